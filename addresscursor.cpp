@@ -0,0 +1,226 @@
+// Copyright (c) 2015-2019 Vector 35 Inc
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+#define ADDRESS_CURSOR_INITIAL_WINDOW 0x10000
+#define ADDRESS_CURSOR_MAX_WINDOW     (1ULL << 62)
+
+
+AddressCursor::AddressCursor(BinaryView* view, uint64_t start, uint64_t end, size_t chunkSize): m_view(view),
+	m_position(start), m_end(end), m_chunkSize(chunkSize ? chunkSize : 1), m_window(ADDRESS_CURSOR_INITIAL_WINDOW)
+{
+}
+
+
+uint64_t AddressCursor::GetWindowEnd() const
+{
+	if ((m_end - m_position) > m_window)
+		return m_position + m_window;
+	return m_end;
+}
+
+
+bool AddressCursor::IsWindowTooLarge(size_t count) const
+{
+	// Queries return every item in the window at once, so a dense window is retried in smaller pieces to
+	// keep the amount of memory held by a single query close to the chunk size
+	return (count > (m_chunkSize * 2)) && (m_window > 1);
+}
+
+
+void AddressCursor::ShrinkWindow(size_t count)
+{
+	// Scale the window so the retry is expected to hold about one chunk
+	m_window = max<uint64_t>(m_window / ((count / m_chunkSize) + 1), 1);
+}
+
+
+void AddressCursor::FinishWindow(uint64_t windowEnd, size_t count)
+{
+	m_position = windowEnd;
+
+	// Grow quickly across sparse or unmapped regions, and back off in dense ones
+	if ((count < (m_chunkSize / 4)) && (m_window < ADDRESS_CURSOR_MAX_WINDOW))
+		m_window *= 2;
+	else if ((count > m_chunkSize) && (m_window > 1))
+		m_window /= 2;
+}
+
+
+StringCursor::StringCursor(BinaryView* view, size_t chunkSize):
+	AddressCursor(view, view->GetStart(), view->GetEnd(), chunkSize)
+{
+}
+
+
+StringCursor::StringCursor(BinaryView* view, uint64_t start, uint64_t end, size_t chunkSize):
+	AddressCursor(view, start, end, chunkSize)
+{
+}
+
+
+bool StringCursor::Next(vector<BNStringReference>& strings)
+{
+	strings.clear();
+	while (!IsAtEnd() && (strings.size() < m_chunkSize))
+	{
+		uint64_t windowStart = m_position;
+		uint64_t windowEnd = GetWindowEnd();
+		size_t count;
+		BNStringReference* refs = BNGetStringsInRange(m_view->GetObject(), windowStart, windowEnd - windowStart,
+			&count);
+		if (IsWindowTooLarge(count))
+		{
+			BNFreeStringReferenceList(refs);
+			ShrinkWindow(count);
+			continue;
+		}
+
+		// Only take strings that start in the window, so one that spans a window boundary is not repeated
+		size_t first = strings.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			if ((refs[i].start >= windowStart) && (refs[i].start < windowEnd))
+				strings.push_back(refs[i]);
+		}
+		BNFreeStringReferenceList(refs);
+
+		sort(strings.begin() + first, strings.end(), [](const BNStringReference& a, const BNStringReference& b) {
+				return a.start < b.start;
+			});
+		FinishWindow(windowEnd, strings.size() - first);
+	}
+	return !strings.empty();
+}
+
+
+SymbolCursor::SymbolCursor(BinaryView* view, const NameSpace& nameSpace, size_t chunkSize):
+	AddressCursor(view, view->GetStart(), view->GetEnd(), chunkSize), m_nameSpace(nameSpace), m_filterType(false),
+	m_type(FunctionSymbol)
+{
+}
+
+
+SymbolCursor::SymbolCursor(BinaryView* view, BNSymbolType type, const NameSpace& nameSpace, size_t chunkSize):
+	AddressCursor(view, view->GetStart(), view->GetEnd(), chunkSize), m_nameSpace(nameSpace), m_filterType(true),
+	m_type(type)
+{
+}
+
+
+SymbolCursor::SymbolCursor(BinaryView* view, uint64_t start, uint64_t end, const NameSpace& nameSpace,
+	size_t chunkSize): AddressCursor(view, start, end, chunkSize), m_nameSpace(nameSpace), m_filterType(false),
+	m_type(FunctionSymbol)
+{
+}
+
+
+SymbolCursor::SymbolCursor(BinaryView* view, BNSymbolType type, uint64_t start, uint64_t end,
+	const NameSpace& nameSpace, size_t chunkSize): AddressCursor(view, start, end, chunkSize),
+	m_nameSpace(nameSpace), m_filterType(true), m_type(type)
+{
+}
+
+
+bool SymbolCursor::Next(vector<Ref<Symbol>>& symbols)
+{
+	symbols.clear();
+	BNNameSpace ns = m_nameSpace.GetAPIObject();
+	vector<pair<uint64_t, BNSymbol*>> sorted;
+	while (!IsAtEnd() && (symbols.size() < m_chunkSize))
+	{
+		uint64_t windowStart = m_position;
+		uint64_t windowEnd = GetWindowEnd();
+		size_t count;
+		BNSymbol** syms;
+		if (m_filterType)
+			syms = BNGetSymbolsOfTypeInRange(m_view->GetObject(), m_type, windowStart, windowEnd - windowStart, &count, &ns);
+		else
+			syms = BNGetSymbolsInRange(m_view->GetObject(), windowStart, windowEnd - windowStart, &count, &ns);
+		if (IsWindowTooLarge(count))
+		{
+			BNFreeSymbolList(syms, count);
+			ShrinkWindow(count);
+			continue;
+		}
+
+		sorted.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			uint64_t addr = BNGetSymbolAddress(syms[i]);
+			if ((addr >= windowStart) && (addr < windowEnd))
+				sorted.push_back(pair<uint64_t, BNSymbol*>(addr, syms[i]));
+		}
+		stable_sort(sorted.begin(), sorted.end(),
+			[](const pair<uint64_t, BNSymbol*>& a, const pair<uint64_t, BNSymbol*>& b) { return a.first < b.first; });
+		for (auto& i : sorted)
+			symbols.emplace_back(new Symbol(BNNewSymbolReference(i.second)));
+		BNFreeSymbolList(syms, count);
+
+		FinishWindow(windowEnd, sorted.size());
+	}
+	NameSpace::FreeAPIObject(&ns);
+	return !symbols.empty();
+}
+
+
+DataVariableCursor::DataVariableCursor(BinaryView* view, size_t chunkSize):
+	AddressCursor(view, view->GetStart(), view->GetEnd(), chunkSize)
+{
+}
+
+
+DataVariableCursor::DataVariableCursor(BinaryView* view, uint64_t start, uint64_t end, size_t chunkSize):
+	AddressCursor(view, start, end, chunkSize)
+{
+}
+
+
+bool DataVariableCursor::Next(vector<DataVariable>& vars)
+{
+	// There is no range query for data variables, so walk them one at a time from the current position
+	vars.clear();
+	while (!IsAtEnd() && (vars.size() < m_chunkSize))
+	{
+		BNDataVariable var;
+		if (BNGetDataVariableAtAddress(m_view->GetObject(), m_position, &var))
+		{
+			if (var.address == m_position)
+			{
+				vars.emplace_back(var.address, nullptr, var.autoDiscovered);
+				vars.back().type = Confidence<Ref<Type>>(new Type(var.type), var.typeConfidence);
+			}
+			else
+			{
+				BNFreeType(var.type);
+			}
+		}
+
+		uint64_t next = BNGetNextDataVariableStartAfterAddress(m_view->GetObject(), m_position);
+		m_position = (next > m_position) ? next : m_end;
+	}
+	return !vars.empty();
+}
@@ -0,0 +1,597 @@
+// Copyright (c) 2015-2019 Vector 35 Inc
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <inttypes.h>
+#include <thread>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace Json;
+using namespace std;
+
+
+struct ActiveFunctionSpan
+{
+	Ref<Function> func;
+	double start, end;
+	size_t lastSample;
+};
+
+struct AnalysisProfiler::ProfilerState
+{
+	Ref<BinaryView> view;
+	chrono::steady_clock::time_point startTime;
+
+	mutable mutex lock;
+	vector<AnalysisProfileSample> samples;
+	vector<ActiveFunctionSpan> spans;
+	unordered_map<BNFunction*, size_t> lastSpan;
+	vector<AnalysisFunctionProfile> functions;
+
+	mutex threadLock;
+	condition_variable stopEvent;
+	bool stopping;
+	thread sampleThread;
+};
+
+
+static const char* GetAnalysisStateName(BNAnalysisState state)
+{
+	switch (state)
+	{
+	case IdleState:
+		return "Idle";
+	case DisassembleState:
+		return "Disassemble";
+	case AnalyzeState:
+		return "Analyze";
+	case ExtendedAnalyzeState:
+		return "Extended analyze";
+	default:
+		return "Unknown";
+	}
+}
+
+
+static string FormatAddress(uint64_t addr)
+{
+	char str[32];
+	snprintf(str, sizeof(str), "0x%" PRIx64, addr);
+	return str;
+}
+
+
+static string FormatMetricValue(double value)
+{
+	char str[32];
+	snprintf(str, sizeof(str), "%.9g", value);
+	return str;
+}
+
+
+static string EscapePrometheusLabel(const string& value)
+{
+	string result;
+	result.reserve(value.size());
+	for (char c : value)
+	{
+		if (c == '\\')
+			result += "\\\\";
+		else if (c == '"')
+			result += "\\\"";
+		else if (c == '\n')
+			result += "\\n";
+		else
+			result += c;
+	}
+	return result;
+}
+
+
+static string WriteJson(const Value& value)
+{
+	StreamWriterBuilder builder;
+	builder["indentation"] = "";
+	builder["precision"] = 12;
+	return writeString(builder, value);
+}
+
+
+AnalysisProfiler::AnalysisProfiler(BinaryView* view): m_state(new ProfilerState)
+{
+	m_state->view = view;
+	m_state->startTime = chrono::steady_clock::now();
+	m_state->stopping = false;
+}
+
+
+AnalysisProfiler::~AnalysisProfiler()
+{
+	Stop();
+}
+
+
+void AnalysisProfiler::Sample()
+{
+	// Query the core before taking the lock, so that reports can be written while sampling
+	AnalysisProfileSample sample;
+	sample.progress = m_state->view->GetAnalysisProgress();
+	sample.memoryUsage = GetMemoryUsageInfo();
+	AnalysisInfo info = m_state->view->GetAnalysisInfo();
+	sample.time = chrono::duration<double>(chrono::steady_clock::now() - m_state->startTime).count();
+
+	unique_lock<mutex> lock(m_state->lock);
+	size_t index = m_state->samples.size();
+	m_state->samples.push_back(move(sample));
+	double time = m_state->samples.back().time;
+
+	// Extend the span of functions that were also active in the previous sample, start new ones otherwise
+	for (auto& i : info.activeInfo)
+	{
+		auto last = m_state->lastSpan.find(i.func->GetObject());
+		if ((last != m_state->lastSpan.end()) && (index > 0) &&
+			(m_state->spans[last->second].lastSample == (index - 1)))
+		{
+			ActiveFunctionSpan& span = m_state->spans[last->second];
+			span.end = time;
+			span.lastSample = index;
+			continue;
+		}
+
+		ActiveFunctionSpan span;
+		span.func = i.func;
+		span.start = time;
+		span.end = time;
+		span.lastSample = index;
+		m_state->lastSpan[i.func->GetObject()] = m_state->spans.size();
+		m_state->spans.push_back(span);
+	}
+}
+
+
+void AnalysisProfiler::Start(uint32_t intervalMs)
+{
+	Stop();
+
+	unique_lock<mutex> lock(m_state->threadLock);
+	m_state->stopping = false;
+	m_state->sampleThread = thread([=]() {
+		while (true)
+		{
+			Sample();
+			unique_lock<mutex> waitLock(m_state->threadLock);
+			if (m_state->stopEvent.wait_for(waitLock, chrono::milliseconds(intervalMs),
+				[&]() { return m_state->stopping; }))
+				break;
+		}
+	});
+}
+
+
+void AnalysisProfiler::Stop()
+{
+	thread sampleThread;
+	{
+		unique_lock<mutex> lock(m_state->threadLock);
+		if (!m_state->sampleThread.joinable())
+			return;
+		m_state->stopping = true;
+		sampleThread = move(m_state->sampleThread);
+	}
+	m_state->stopEvent.notify_all();
+	sampleThread.join();
+}
+
+
+void AnalysisProfiler::CollectFunctionTimings(size_t threadCount)
+{
+	vector<Ref<Function>> funcs = m_state->view->GetAnalysisFunctionList();
+	vector<AnalysisFunctionProfile> profiles(funcs.size());
+	WorkerParallelFor(funcs.size(), [&](size_t i) {
+		AnalysisFunctionProfile& profile = profiles[i];
+		profile.func = funcs[i];
+		profile.phases = funcs[i]->GetAnalysisPerformanceInfo();
+		profile.totalTime = 0;
+		for (auto& j : profile.phases)
+			profile.totalTime += j.second;
+	}, threadCount);
+
+	unique_lock<mutex> lock(m_state->lock);
+	m_state->functions = move(profiles);
+}
+
+
+vector<AnalysisProfileSample> AnalysisProfiler::GetSamples() const
+{
+	unique_lock<mutex> lock(m_state->lock);
+	return m_state->samples;
+}
+
+
+vector<AnalysisFunctionProfile> AnalysisProfiler::GetFunctionProfiles() const
+{
+	unique_lock<mutex> lock(m_state->lock);
+	return m_state->functions;
+}
+
+
+vector<AnalysisFunctionProfile> AnalysisProfiler::GetSlowestFunctions(size_t count, const string& phase) const
+{
+	vector<pair<double, size_t>> times;
+	unique_lock<mutex> lock(m_state->lock);
+	times.reserve(m_state->functions.size());
+	for (size_t i = 0; i < m_state->functions.size(); i++)
+	{
+		const AnalysisFunctionProfile& profile = m_state->functions[i];
+		double time = profile.totalTime;
+		if (!phase.empty())
+		{
+			auto j = profile.phases.find(phase);
+			if (j == profile.phases.end())
+				continue;
+			time = j->second;
+		}
+		times.push_back(pair<double, size_t>(time, i));
+	}
+
+	count = min(count, times.size());
+	partial_sort(times.begin(), times.begin() + count, times.end(),
+		[](const pair<double, size_t>& a, const pair<double, size_t>& b) {
+			if (a.first != b.first)
+				return a.first > b.first;
+			return a.second < b.second;
+		});
+
+	vector<AnalysisFunctionProfile> result;
+	result.reserve(count);
+	for (size_t i = 0; i < count; i++)
+		result.push_back(m_state->functions[times[i].second]);
+	return result;
+}
+
+
+const vector<double>& AnalysisProfiler::GetHistogramBounds()
+{
+	// Upper bounds in seconds, three buckets per decade from 10us to 100s
+	static const vector<double> bounds = {0.00001, 0.000025, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025,
+		0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100};
+	return bounds;
+}
+
+
+vector<AnalysisPhaseProfile> AnalysisProfiler::GetPhaseProfiles() const
+{
+	const vector<double>& bounds = GetHistogramBounds();
+	map<string, AnalysisPhaseProfile> phases;
+
+	unique_lock<mutex> lock(m_state->lock);
+	for (auto& i : m_state->functions)
+	{
+		for (auto& j : i.phases)
+		{
+			auto phase = phases.find(j.first);
+			if (phase == phases.end())
+			{
+				AnalysisPhaseProfile profile;
+				profile.name = j.first;
+				profile.count = 0;
+				profile.totalTime = 0;
+				profile.minTime = j.second;
+				profile.maxTime = j.second;
+				profile.histogram.resize(bounds.size() + 1, 0);
+				phase = phases.insert(pair<string, AnalysisPhaseProfile>(j.first, move(profile))).first;
+			}
+
+			AnalysisPhaseProfile& profile = phase->second;
+			profile.count++;
+			profile.totalTime += j.second;
+			profile.minTime = min(profile.minTime, j.second);
+			profile.maxTime = max(profile.maxTime, j.second);
+			profile.histogram[lower_bound(bounds.begin(), bounds.end(), j.second) - bounds.begin()]++;
+		}
+	}
+	lock.unlock();
+
+	vector<AnalysisPhaseProfile> result;
+	result.reserve(phases.size());
+	for (auto& i : phases)
+		result.push_back(move(i.second));
+	return result;
+}
+
+
+string AnalysisProfiler::ToJson(size_t topCount) const
+{
+	const vector<double>& bounds = GetHistogramBounds();
+	vector<AnalysisFunctionProfile> slowest = GetSlowestFunctions(topCount);
+	vector<AnalysisPhaseProfile> phases = GetPhaseProfiles();
+	vector<AnalysisProfileSample> samples = GetSamples();
+
+	double totalTime = 0;
+	size_t functionCount;
+	{
+		unique_lock<mutex> lock(m_state->lock);
+		functionCount = m_state->functions.size();
+		for (auto& i : m_state->functions)
+			totalTime += i.totalTime;
+	}
+
+	Value result(objectValue);
+	result["functionCount"] = (UInt64)functionCount;
+	result["totalTime"] = totalTime;
+
+	Value phaseList(arrayValue);
+	for (auto& i : phases)
+	{
+		Value phase(objectValue);
+		phase["name"] = i.name;
+		phase["count"] = (UInt64)i.count;
+		phase["totalTime"] = i.totalTime;
+		phase["minTime"] = i.minTime;
+		phase["maxTime"] = i.maxTime;
+		Value histogram(arrayValue);
+		for (size_t j = 0; j < i.histogram.size(); j++)
+		{
+			Value bucket(objectValue);
+			if (j < bounds.size())
+				bucket["le"] = bounds[j];
+			else
+				bucket["le"] = "+Inf";
+			bucket["count"] = (UInt64)i.histogram[j];
+			histogram.append(bucket);
+		}
+		phase["histogram"] = histogram;
+		phaseList.append(phase);
+	}
+	result["phases"] = phaseList;
+
+	// The cumulative share of total time shows how few functions dominate analysis
+	Value functionList(arrayValue);
+	double cumulative = 0;
+	for (auto& i : slowest)
+	{
+		cumulative += i.totalTime;
+		Value func(objectValue);
+		func["address"] = FormatAddress(i.func->GetStart());
+		func["name"] = i.func->GetSymbol()->GetFullName();
+		func["totalTime"] = i.totalTime;
+		func["cumulativeFraction"] = (totalTime > 0) ? (cumulative / totalTime) : 0.0;
+		Value phaseTimes(objectValue);
+		for (auto& j : i.phases)
+			phaseTimes[j.first] = j.second;
+		func["phases"] = phaseTimes;
+		functionList.append(func);
+	}
+	result["slowestFunctions"] = functionList;
+
+	Value transitions(arrayValue);
+	Value sampleList(arrayValue);
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		const AnalysisProfileSample& sample = samples[i];
+		if ((i == 0) || (sample.progress.state != samples[i - 1].progress.state))
+		{
+			Value transition(objectValue);
+			transition["time"] = sample.time;
+			transition["state"] = GetAnalysisStateName(sample.progress.state);
+			transitions.append(transition);
+		}
+
+		Value entry(objectValue);
+		entry["time"] = sample.time;
+		entry["state"] = GetAnalysisStateName(sample.progress.state);
+		entry["count"] = (UInt64)sample.progress.count;
+		entry["total"] = (UInt64)sample.progress.total;
+		Value memory(objectValue);
+		for (auto& j : sample.memoryUsage)
+			memory[j.first] = (UInt64)j.second;
+		entry["memoryUsage"] = memory;
+		sampleList.append(entry);
+	}
+	result["stateTransitions"] = transitions;
+	result["samples"] = sampleList;
+
+	return WriteJson(result);
+}
+
+
+string AnalysisProfiler::ToPrometheus(size_t topCount) const
+{
+	const vector<double>& bounds = GetHistogramBounds();
+	vector<AnalysisFunctionProfile> slowest = GetSlowestFunctions(topCount);
+	vector<AnalysisPhaseProfile> phases = GetPhaseProfiles();
+
+	size_t functionCount;
+	bool hasSample;
+	AnalysisProfileSample last;
+	{
+		unique_lock<mutex> lock(m_state->lock);
+		functionCount = m_state->functions.size();
+		hasSample = !m_state->samples.empty();
+		if (hasSample)
+			last = m_state->samples.back();
+	}
+
+	string result;
+	result += "# HELP binaryninja_analysis_phase_seconds Analysis time of each function by phase.\n";
+	result += "# TYPE binaryninja_analysis_phase_seconds histogram\n";
+	for (auto& i : phases)
+	{
+		string label = "phase=\"" + EscapePrometheusLabel(i.name) + "\"";
+		size_t cumulative = 0;
+		for (size_t j = 0; j < i.histogram.size(); j++)
+		{
+			cumulative += i.histogram[j];
+			string bound = (j < bounds.size()) ? FormatMetricValue(bounds[j]) : "+Inf";
+			result += "binaryninja_analysis_phase_seconds_bucket{" + label + ",le=\"" + bound + "\"} " +
+				to_string(cumulative) + "\n";
+		}
+		result += "binaryninja_analysis_phase_seconds_sum{" + label + "} " + FormatMetricValue(i.totalTime) + "\n";
+		result += "binaryninja_analysis_phase_seconds_count{" + label + "} " + to_string(i.count) + "\n";
+	}
+
+	result += "# HELP binaryninja_analysis_function_seconds Total analysis time of the slowest functions.\n";
+	result += "# TYPE binaryninja_analysis_function_seconds gauge\n";
+	for (auto& i : slowest)
+	{
+		result += "binaryninja_analysis_function_seconds{address=\"" + FormatAddress(i.func->GetStart()) +
+			"\",name=\"" + EscapePrometheusLabel(i.func->GetSymbol()->GetFullName()) + "\"} " +
+			FormatMetricValue(i.totalTime) + "\n";
+	}
+
+	result += "# HELP binaryninja_analysis_functions Number of functions with collected timings.\n";
+	result += "# TYPE binaryninja_analysis_functions gauge\n";
+	result += "binaryninja_analysis_functions " + to_string(functionCount) + "\n";
+
+	if (!hasSample)
+		return result;
+
+	result += "# HELP binaryninja_analysis_state Analysis state at the last sample.\n";
+	result += "# TYPE binaryninja_analysis_state gauge\n";
+	result += "binaryninja_analysis_state " + to_string((int)last.progress.state) + "\n";
+	result += "# HELP binaryninja_analysis_progress Analysis progress at the last sample.\n";
+	result += "# TYPE binaryninja_analysis_progress gauge\n";
+	result += "binaryninja_analysis_progress{value=\"count\"} " + to_string(last.progress.count) + "\n";
+	result += "binaryninja_analysis_progress{value=\"total\"} " + to_string(last.progress.total) + "\n";
+	result += "# HELP binaryninja_memory_usage Core memory usage counters at the last sample.\n";
+	result += "# TYPE binaryninja_memory_usage gauge\n";
+	for (auto& i : last.memoryUsage)
+	{
+		result += "binaryninja_memory_usage{name=\"" + EscapePrometheusLabel(i.first) + "\"} " +
+			to_string(i.second) + "\n";
+	}
+	return result;
+}
+
+
+string AnalysisProfiler::ToChromeTrace() const
+{
+	vector<AnalysisProfileSample> samples;
+	vector<ActiveFunctionSpan> spans;
+	unordered_map<BNFunction*, const AnalysisFunctionProfile*> timings;
+	vector<AnalysisFunctionProfile> functions = GetFunctionProfiles();
+	{
+		unique_lock<mutex> lock(m_state->lock);
+		samples = m_state->samples;
+		spans = m_state->spans;
+	}
+	for (auto& i : functions)
+		timings[i.func->GetObject()] = &i;
+
+	// Trace timestamps are in microseconds. Thread 0 shows the analysis state, function spans are packed
+	// into as few further threads as possible.
+	Value events(arrayValue);
+	auto addThreadName = [&](int tid, const string& name) {
+		Value event(objectValue);
+		event["name"] = "thread_name";
+		event["ph"] = "M";
+		event["pid"] = 1;
+		event["tid"] = tid;
+		event["args"]["name"] = name;
+		events.append(event);
+	};
+	addThreadName(0, "Analysis state");
+
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		const AnalysisProfileSample& sample = samples[i];
+		if ((i == 0) || (sample.progress.state != samples[i - 1].progress.state))
+		{
+			size_t end = i + 1;
+			while ((end < samples.size()) && (samples[end].progress.state == sample.progress.state))
+				end++;
+			double endTime = (end < samples.size()) ? samples[end].time : samples.back().time;
+
+			Value event(objectValue);
+			event["name"] = GetAnalysisStateName(sample.progress.state);
+			event["ph"] = "X";
+			event["pid"] = 1;
+			event["tid"] = 0;
+			event["ts"] = sample.time * 1000000.0;
+			event["dur"] = (endTime - sample.time) * 1000000.0;
+			events.append(event);
+		}
+
+		Value progress(objectValue);
+		progress["name"] = "Progress";
+		progress["ph"] = "C";
+		progress["pid"] = 1;
+		progress["ts"] = sample.time * 1000000.0;
+		progress["args"]["count"] = (UInt64)sample.progress.count;
+		progress["args"]["total"] = (UInt64)sample.progress.total;
+		events.append(progress);
+
+		if (!sample.memoryUsage.empty())
+		{
+			Value memory(objectValue);
+			memory["name"] = "Memory usage";
+			memory["ph"] = "C";
+			memory["pid"] = 1;
+			memory["ts"] = sample.time * 1000000.0;
+			for (auto& j : sample.memoryUsage)
+				memory["args"][j.first] = (UInt64)j.second;
+			events.append(memory);
+		}
+	}
+
+	// Spans are recorded in order of start time, so a greedy assignment gives the fewest threads
+	vector<double> laneEnds;
+	for (auto& i : spans)
+	{
+		size_t lane = 0;
+		while ((lane < laneEnds.size()) && (laneEnds[lane] > i.start))
+			lane++;
+		if (lane == laneEnds.size())
+		{
+			laneEnds.push_back(i.end);
+			addThreadName((int)lane + 1, "Function analysis " + to_string(lane + 1));
+		}
+		else
+		{
+			laneEnds[lane] = i.end;
+		}
+
+		Value event(objectValue);
+		event["name"] = i.func->GetSymbol()->GetFullName();
+		event["ph"] = "X";
+		event["pid"] = 1;
+		event["tid"] = (int)lane + 1;
+		event["ts"] = i.start * 1000000.0;
+		event["dur"] = (i.end - i.start) * 1000000.0;
+		event["args"]["address"] = FormatAddress(i.func->GetStart());
+		auto timing = timings.find(i.func->GetObject());
+		if (timing != timings.end())
+		{
+			event["args"]["totalTime"] = timing->second->totalTime;
+			for (auto& j : timing->second->phases)
+				event["args"]["phases"][j.first] = j.second;
+		}
+		events.append(event);
+	}
+
+	Value result(objectValue);
+	result["traceEvents"] = events;
+	result["displayTimeUnit"] = "ms";
+	return WriteJson(result);
+}
@@ -767,7 +767,7 @@ Ref<Architecture> Architecture::GetByName(const string& name)
 	BNArchitecture* arch = BNGetArchitectureByName(name.c_str());
 	if (!arch)
 		return nullptr;
-	return new CoreArchitecture(arch);
+	return CoreArchitecture::Intern(arch);
 }
 
 
@@ -780,7 +780,7 @@ vector<Ref<Architecture>> Architecture::GetList()
 	vector<Ref<Architecture>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new CoreArchitecture(archs[i]));
+		result.emplace_back(CoreArchitecture::Intern(archs[i]));
 
 	BNFreeArchitectureList(archs);
 	return result;
@@ -1213,7 +1213,7 @@ vector<Ref<CallingConvention>> Architecture::GetCallingConventions()
 	vector<Ref<CallingConvention>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new CoreCallingConvention(BNNewCallingConventionReference(list[i])));
+		result.emplace_back(new CoreCallingConvention(BNNewCallingConventionReference(list[i])));
 
 	BNFreeCallingConventionList(list, count);
 	return result;
@@ -1291,7 +1291,7 @@ Ref<CallingConvention> Architecture::GetFastcallCallingConvention()
 
 Ref<Platform> Architecture::GetStandalonePlatform()
 {
-	return new Platform(BNGetArchitectureStandalonePlatform(m_object));
+	return Platform::Intern(BNGetArchitectureStandalonePlatform(m_object));
 }
 
 
@@ -1306,6 +1306,17 @@ CoreArchitecture::CoreArchitecture(BNArchitecture* arch): Architecture(arch)
 }
 
 
+Ref<Architecture> CoreArchitecture::Intern(BNArchitecture* arch)
+{
+	Ref<CoreArchitecture> result = WrapperCache<CoreArchitecture, BNArchitecture>::Get(arch, [](BNArchitecture* a) {
+		CoreArchitecture* wrapper = new CoreArchitecture(a);
+		wrapper->AddRefForRegistration();
+		return wrapper;
+	});
+	return Ref<Architecture>::Adopt(result.Detach());
+}
+
+
 BNEndianness CoreArchitecture::GetEndianness() const
 {
 	return BNGetArchitectureEndianness(m_object);
@@ -1344,7 +1355,7 @@ size_t CoreArchitecture::GetOpcodeDisplayLength() const
 
 Ref<Architecture> CoreArchitecture::GetAssociatedArchitectureByAddress(uint64_t& addr)
 {
-	return new CoreArchitecture(BNGetAssociatedArchitectureByAddress(m_object, &addr));
+	return CoreArchitecture::Intern(BNGetAssociatedArchitectureByAddress(m_object, &addr));
 }
 
 
@@ -2170,14 +2181,14 @@ Ref<BasicBlock> DisassemblyTextRenderer::GetBasicBlock() const
 {
 	BNBasicBlock* block = BNGetDisassemblyTextRendererBasicBlock(m_object);
 	if (block)
-		return new BasicBlock(block);
+		return BasicBlock::Intern(block);
 	return nullptr;
 }
 
 
 Ref<Architecture> DisassemblyTextRenderer::GetArchitecture() const
 {
-	return new CoreArchitecture(BNGetDisassemblyTextRendererArchitecture(m_object));
+	return CoreArchitecture::Intern(BNGetDisassemblyTextRendererArchitecture(m_object));
 }
 
 
@@ -2189,7 +2200,7 @@ Ref<DisassemblySettings> DisassemblyTextRenderer::GetSettings() const
 
 Ref<Function> DisassemblyTextRenderer::GetFunction() const
 {
-	return new Function(BNGetDisassemblyTextRendererFunction(m_object));
+	return Function::Intern(BNGetDisassemblyTextRendererFunction(m_object));
 }
 
 
@@ -69,7 +69,7 @@ vector<Ref<BackgroundTask>> BackgroundTask::GetRunningTasks()
 	vector<Ref<BackgroundTask>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new BackgroundTask(BNNewBackgroundTaskReference(tasks[i])));
+		result.emplace_back(new BackgroundTask(BNNewBackgroundTaskReference(tasks[i])));
 
 	BNFreeBackgroundTaskList(tasks, count);
 	return result;
@@ -93,15 +93,27 @@ BasicBlock::BasicBlock(BNBasicBlock* block)
 }
 
 
+BasicBlock::~BasicBlock()
+{
+	WrapperCache<BasicBlock, BNBasicBlock>::Remove(m_object, this);
+}
+
+
+Ref<BasicBlock> BasicBlock::Intern(BNBasicBlock* block)
+{
+	return WrapperCache<BasicBlock, BNBasicBlock>::Get(block, [](BNBasicBlock* b) { return new BasicBlock(b); });
+}
+
+
 Ref<Function> BasicBlock::GetFunction() const
 {
-	return new Function(BNGetBasicBlockFunction(m_object));
+	return Function::Intern(BNGetBasicBlockFunction(m_object));
 }
 
 
 Ref<Architecture> BasicBlock::GetArchitecture() const
 {
-	return new CoreArchitecture(BNGetBasicBlockArchitecture(m_object));
+	return CoreArchitecture::Intern(BNGetBasicBlockArchitecture(m_object));
 }
 
 
@@ -140,10 +152,10 @@ vector<BasicBlockEdge> BasicBlock::GetOutgoingEdges() const
 	{
 		BasicBlockEdge edge;
 		edge.type = array[i].type;
-		edge.target = array[i].target ? new BasicBlock(BNNewBasicBlockReference(array[i].target)) : nullptr;
+		edge.target = array[i].target ? BasicBlock::Intern(BNNewBasicBlockReference(array[i].target)) : nullptr;
 		edge.backEdge = array[i].backEdge;
 		edge.fallThrough = array[i].fallThrough;
-		result.push_back(edge);
+		result.push_back(std::move(edge));
 	}
 
 	BNFreeBasicBlockEdgeList(array, count);
@@ -162,10 +174,10 @@ vector<BasicBlockEdge> BasicBlock::GetIncomingEdges() const
 	{
 		BasicBlockEdge edge;
 		edge.type = array[i].type;
-		edge.target = array[i].target ? new BasicBlock(BNNewBasicBlockReference(array[i].target)) : nullptr;
+		edge.target = array[i].target ? BasicBlock::Intern(BNNewBasicBlockReference(array[i].target)) : nullptr;
 		edge.backEdge = array[i].backEdge;
 		edge.fallThrough = array[i].fallThrough;
-		result.push_back(edge);
+		result.push_back(std::move(edge));
 	}
 
 	BNFreeBasicBlockEdgeList(array, count);
@@ -192,7 +204,7 @@ set<Ref<BasicBlock>> BasicBlock::GetDominators(bool post) const
 
 	set<Ref<BasicBlock>> result;
 	for (size_t i = 0; i < count; i++)
-		result.insert(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.insert(BasicBlock::Intern(BNNewBasicBlockReference(blocks[i])));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -206,7 +218,7 @@ set<Ref<BasicBlock>> BasicBlock::GetStrictDominators(bool post) const
 
 	set<Ref<BasicBlock>> result;
 	for (size_t i = 0; i < count; i++)
-		result.insert(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.insert(BasicBlock::Intern(BNNewBasicBlockReference(blocks[i])));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -218,7 +230,7 @@ Ref<BasicBlock> BasicBlock::GetImmediateDominator(bool post) const
 	BNBasicBlock* result = BNGetBasicBlockImmediateDominator(m_object, post);
 	if (!result)
 		return nullptr;
-	return new BasicBlock(result);
+	return BasicBlock::Intern(result);
 }
 
 
@@ -229,7 +241,7 @@ set<Ref<BasicBlock>> BasicBlock::GetDominatorTreeChildren(bool post) const
 
 	set<Ref<BasicBlock>> result;
 	for (size_t i = 0; i < count; i++)
-		result.insert(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.insert(BasicBlock::Intern(BNNewBasicBlockReference(blocks[i])));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -243,7 +255,7 @@ set<Ref<BasicBlock>> BasicBlock::GetDominanceFrontier(bool post) const
 
 	set<Ref<BasicBlock>> result;
 	for (size_t i = 0; i < count; i++)
-		result.insert(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.insert(BasicBlock::Intern(BNNewBasicBlockReference(blocks[i])));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -263,7 +275,7 @@ set<Ref<BasicBlock>> BasicBlock::GetIteratedDominanceFrontier(const set<Ref<Basi
 
 	set<Ref<BasicBlock>> result;
 	for (size_t k = 0; k < count; k++)
-		result.insert(new BasicBlock(BNNewBasicBlockReference(resultBlocks[k])));
+		result.insert(BasicBlock::Intern(BNNewBasicBlockReference(resultBlocks[k])));
 
 	BNFreeBasicBlockList(resultBlocks, count);
 	return result;
@@ -0,0 +1,539 @@
+// Copyright (c) 2015-2019 Vector 35 Inc
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+enum PendingChange
+{
+	PendingAdded,
+	PendingRemoved,
+	PendingUpdated
+};
+
+
+struct PendingStringKey
+{
+	BNStringType type;
+	uint64_t start;
+	size_t length;
+
+	bool operator<(const PendingStringKey& other) const
+	{
+		if (start != other.start)
+			return start < other.start;
+		if (length != other.length)
+			return length < other.length;
+		return type < other.type;
+	}
+};
+
+
+struct PendingDataVariable
+{
+	PendingChange change;
+	BNDataVariable var; // Holds a reference to the type
+};
+
+
+struct BatchedDataNotification::BatchState
+{
+	mutex lock;
+	mutex deliveryLock; // Held while a batch is being delivered, so batches arrive in order
+	condition_variable wake;
+	thread timer;
+	bool registered, running;
+	chrono::milliseconds interval;
+	chrono::steady_clock::time_point firstEvent;
+	size_t eventCount;
+
+	map<uint64_t, uint64_t> written;
+	map<BNFunction*, PendingChange> functions; // Holds a reference to each function
+	map<uint64_t, PendingDataVariable> dataVariables;
+	map<PendingStringKey, PendingChange> strings;
+
+	Ref<AnalysisCompletionEvent> completion;
+	atomic<bool> completionArmed;
+	mutex completionLock; // Held while a completion event delivers, and when registration changes
+	uint64_t registration; // Changed on unregister, so completion events armed before it do nothing
+	atomic<thread::id> deliveringThread; // Thread running OnDataBatch, if any
+
+	BatchState(uint64_t ms): registered(false), running(false), interval(ms), eventCount(0),
+		completionArmed(false), registration(0)
+	{
+	}
+
+	~BatchState()
+	{
+		for (auto& i : functions)
+			BNFreeFunction(i.first);
+		for (auto& i : dataVariables)
+			BNFreeType(i.second.var.type);
+	}
+
+	void AddWrittenRange(uint64_t start, uint64_t end)
+	{
+		auto i = written.upper_bound(start);
+		if (i != written.begin())
+		{
+			auto prev = i;
+			--prev;
+			if (prev->second >= start)
+			{
+				start = prev->first;
+				end = max(end, prev->second);
+				i = written.erase(prev);
+			}
+		}
+		while ((i != written.end()) && (i->first <= end))
+		{
+			end = max(end, i->second);
+			i = written.erase(i);
+		}
+		written[start] = end;
+	}
+
+	void AddFunction(BNFunction* func, PendingChange change)
+	{
+		auto i = functions.find(func);
+		if (i == functions.end())
+		{
+			functions[BNNewFunctionReference(func)] = change;
+			return;
+		}
+
+		if ((change == PendingRemoved) && (i->second == PendingAdded))
+		{
+			BNFreeFunction(i->first);
+			functions.erase(i);
+		}
+		else if (change == PendingRemoved)
+		{
+			i->second = PendingRemoved;
+		}
+		else if ((change == PendingAdded) && (i->second == PendingRemoved))
+		{
+			i->second = PendingUpdated;
+		}
+	}
+
+	void AddDataVariable(const BNDataVariable* var, PendingChange change)
+	{
+		auto i = dataVariables.find(var->address);
+		if (i == dataVariables.end())
+		{
+			PendingDataVariable pending;
+			pending.change = change;
+			pending.var = *var;
+			pending.var.type = BNNewTypeReference(var->type);
+			dataVariables[var->address] = pending;
+			return;
+		}
+
+		PendingDataVariable& pending = i->second;
+		if ((change == PendingRemoved) && (pending.change == PendingAdded))
+		{
+			BNFreeType(pending.var.type);
+			dataVariables.erase(i);
+			return;
+		}
+
+		if (change == PendingRemoved)
+			pending.change = PendingRemoved;
+		else if (pending.change == PendingRemoved)
+			pending.change = PendingUpdated;
+		BNFreeType(pending.var.type);
+		pending.var = *var;
+		pending.var.type = BNNewTypeReference(var->type);
+	}
+
+	void AddString(BNStringType type, uint64_t start, size_t length, PendingChange change)
+	{
+		PendingStringKey key;
+		key.type = type;
+		key.start = start;
+		key.length = length;
+		auto i = strings.find(key);
+		if (i == strings.end())
+			strings[key] = change;
+		else if (i->second != change)
+			strings.erase(i);
+	}
+
+	// Moves the pending events into batch, transferring the held references
+	void TakeBatch(DataNotificationBatch& batch)
+	{
+		for (auto& i : written)
+			batch.writtenRanges.push_back(pair<uint64_t, uint64_t>(i.first, i.second));
+		for (auto& i : functions)
+		{
+			Ref<Function> func = Function::Intern(i.first);
+			if (i.second == PendingAdded)
+				batch.addedFunctions.push_back(func);
+			else if (i.second == PendingRemoved)
+				batch.removedFunctions.push_back(func);
+			else
+				batch.updatedFunctions.push_back(func);
+		}
+		for (auto& i : dataVariables)
+		{
+			const BNDataVariable& var = i.second.var;
+			DataVariable varObj(var.address, Confidence<Ref<Type>>(new Type(var.type), var.typeConfidence), var.autoDiscovered);
+			if (i.second.change == PendingAdded)
+				batch.addedDataVariables.push_back(varObj);
+			else if (i.second.change == PendingRemoved)
+				batch.removedDataVariables.push_back(varObj);
+			else
+				batch.updatedDataVariables.push_back(varObj);
+		}
+		for (auto& i : strings)
+		{
+			BNStringReference str;
+			str.type = i.first.type;
+			str.start = i.first.start;
+			str.length = i.first.length;
+			if (i.second == PendingAdded)
+				batch.foundStrings.push_back(str);
+			else
+				batch.removedStrings.push_back(str);
+		}
+		batch.eventCount = eventCount;
+
+		written.clear();
+		functions.clear();
+		dataVariables.clear();
+		strings.clear();
+		eventCount = 0;
+	}
+};
+
+
+BatchedDataNotification::BatchedDataNotification(BinaryView* view, uint64_t interval):
+	m_view(view), m_state(new BatchState(interval))
+{
+	BNBinaryDataNotification* callbacks = GetCallbacks();
+	callbacks->dataWritten = DataWrittenCallback;
+	callbacks->dataInserted = DataInsertedCallback;
+	callbacks->dataRemoved = DataRemovedCallback;
+	callbacks->functionAdded = FunctionAddedCallback;
+	callbacks->functionRemoved = FunctionRemovedCallback;
+	callbacks->functionUpdated = FunctionUpdatedCallback;
+	callbacks->dataVariableAdded = DataVariableAddedCallback;
+	callbacks->dataVariableRemoved = DataVariableRemovedCallback;
+	callbacks->dataVariableUpdated = DataVariableUpdatedCallback;
+	callbacks->stringFound = StringFoundCallback;
+	callbacks->stringRemoved = StringRemovedCallback;
+}
+
+
+BatchedDataNotification::~BatchedDataNotification()
+{
+	// OnDataBatch can no longer reach the subclass from here, so the pending batch is dropped
+	if (StopDelivery())
+		LogError("BatchedDataNotification destroyed while registered, pending events discarded");
+}
+
+
+void BatchedDataNotification::DataWrittenCallback(void* ctxt, BNBinaryView*, uint64_t offset, size_t len)
+{
+	BatchedDataNotification* notify = static_cast<BatchedDataNotification*>((BinaryDataNotification*)ctxt);
+	unique_lock<mutex> lock(notify->m_state->lock);
+	if (len != 0)
+		notify->m_state->AddWrittenRange(offset, offset + len);
+	notify->EventAdded();
+}
+
+
+void BatchedDataNotification::DataInsertedCallback(void* ctxt, BNBinaryView* object, uint64_t offset, size_t len)
+{
+	BatchedDataNotification* notify = static_cast<BatchedDataNotification*>((BinaryDataNotification*)ctxt);
+	notify->Flush();
+	Ref<BinaryView> view = new BinaryView(BNNewViewReference(object));
+	notify->OnBinaryDataInserted(view, offset, len);
+}
+
+
+void BatchedDataNotification::DataRemovedCallback(void* ctxt, BNBinaryView* object, uint64_t offset, uint64_t len)
+{
+	BatchedDataNotification* notify = static_cast<BatchedDataNotification*>((BinaryDataNotification*)ctxt);
+	notify->Flush();
+	Ref<BinaryView> view = new BinaryView(BNNewViewReference(object));
+	notify->OnBinaryDataRemoved(view, offset, len);
+}
+
+
+void BatchedDataNotification::FunctionAddedCallback(void* ctxt, BNBinaryView*, BNFunction* func)
+{
+	BatchedDataNotification* notify = static_cast<BatchedDataNotification*>((BinaryDataNotification*)ctxt);
+	unique_lock<mutex> lock(notify->m_state->lock);
+	notify->m_state->AddFunction(func, PendingAdded);
+	notify->EventAdded();
+}
+
+
+void BatchedDataNotification::FunctionRemovedCallback(void* ctxt, BNBinaryView*, BNFunction* func)
+{
+	BatchedDataNotification* notify = static_cast<BatchedDataNotification*>((BinaryDataNotification*)ctxt);
+	unique_lock<mutex> lock(notify->m_state->lock);
+	notify->m_state->AddFunction(func, PendingRemoved);
+	notify->EventAdded();
+}
+
+
+void BatchedDataNotification::FunctionUpdatedCallback(void* ctxt, BNBinaryView*, BNFunction* func)
+{
+	BatchedDataNotification* notify = static_cast<BatchedDataNotification*>((BinaryDataNotification*)ctxt);
+	unique_lock<mutex> lock(notify->m_state->lock);
+	notify->m_state->AddFunction(func, PendingUpdated);
+	notify->EventAdded();
+}
+
+
+void BatchedDataNotification::DataVariableAddedCallback(void* ctxt, BNBinaryView*, BNDataVariable* var)
+{
+	BatchedDataNotification* notify = static_cast<BatchedDataNotification*>((BinaryDataNotification*)ctxt);
+	unique_lock<mutex> lock(notify->m_state->lock);
+	notify->m_state->AddDataVariable(var, PendingAdded);
+	notify->EventAdded();
+}
+
+
+void BatchedDataNotification::DataVariableRemovedCallback(void* ctxt, BNBinaryView*, BNDataVariable* var)
+{
+	BatchedDataNotification* notify = static_cast<BatchedDataNotification*>((BinaryDataNotification*)ctxt);
+	unique_lock<mutex> lock(notify->m_state->lock);
+	notify->m_state->AddDataVariable(var, PendingRemoved);
+	notify->EventAdded();
+}
+
+
+void BatchedDataNotification::DataVariableUpdatedCallback(void* ctxt, BNBinaryView*, BNDataVariable* var)
+{
+	BatchedDataNotification* notify = static_cast<BatchedDataNotification*>((BinaryDataNotification*)ctxt);
+	unique_lock<mutex> lock(notify->m_state->lock);
+	notify->m_state->AddDataVariable(var, PendingUpdated);
+	notify->EventAdded();
+}
+
+
+void BatchedDataNotification::StringFoundCallback(void* ctxt, BNBinaryView*, BNStringType type, uint64_t offset, size_t len)
+{
+	BatchedDataNotification* notify = static_cast<BatchedDataNotification*>((BinaryDataNotification*)ctxt);
+	unique_lock<mutex> lock(notify->m_state->lock);
+	notify->m_state->AddString(type, offset, len, PendingAdded);
+	notify->EventAdded();
+}
+
+
+void BatchedDataNotification::StringRemovedCallback(void* ctxt, BNBinaryView*, BNStringType type, uint64_t offset, size_t len)
+{
+	BatchedDataNotification* notify = static_cast<BatchedDataNotification*>((BinaryDataNotification*)ctxt);
+	unique_lock<mutex> lock(notify->m_state->lock);
+	notify->m_state->AddString(type, offset, len, PendingRemoved);
+	notify->EventAdded();
+}
+
+
+// Called with the state lock held after an event has been folded into the pending batch
+void BatchedDataNotification::EventAdded()
+{
+	if (m_state->eventCount++ == 0)
+	{
+		m_state->firstEvent = chrono::steady_clock::now();
+		m_state->wake.notify_one();
+	}
+}
+
+
+// Requests a flush when the current analysis completes. Completion events fire once, so this is repeated from
+// the delivery thread whenever new events arrive after the previous one fired.
+void BatchedDataNotification::ArmCompletionEvent()
+{
+	if (m_state->completionArmed.exchange(true))
+		return;
+
+	// The event can fire after Unregister or destruction, so it holds the state rather than relying on this
+	shared_ptr<BatchState> state = m_state;
+	uint64_t registration;
+	{
+		unique_lock<mutex> lock(state->completionLock);
+		registration = state->registration;
+	}
+	Ref<AnalysisCompletionEvent> event = m_view->AddAnalysisCompletionEvent([this, state, registration]() {
+		unique_lock<mutex> lock(state->completionLock);
+		if (state->registration != registration)
+			return;
+		state->completionArmed = false;
+		Flush();
+	});
+
+	unique_lock<mutex> lock(m_state->lock);
+	if (m_state->registered)
+		m_state->completion = event;
+	else
+		event->Cancel();
+}
+
+
+void BatchedDataNotification::DeliveryThread()
+{
+	unique_lock<mutex> lock(m_state->lock);
+	while (m_state->running)
+	{
+		if (m_state->eventCount == 0)
+		{
+			m_state->wake.wait(lock);
+			continue;
+		}
+
+		if (!m_state->completionArmed)
+		{
+			lock.unlock();
+			ArmCompletionEvent();
+			lock.lock();
+			continue;
+		}
+
+		chrono::steady_clock::time_point due = m_state->firstEvent + m_state->interval;
+		if (chrono::steady_clock::now() < due)
+		{
+			m_state->wake.wait_until(lock, due);
+			continue;
+		}
+
+		lock.unlock();
+		Flush();
+		lock.lock();
+	}
+}
+
+
+void BatchedDataNotification::Register()
+{
+	{
+		unique_lock<mutex> lock(m_state->lock);
+		if (m_state->registered)
+			return;
+		m_state->registered = true;
+		m_state->running = true;
+		m_state->timer = thread([this]() { DeliveryThread(); });
+	}
+	m_view->RegisterNotification(this);
+}
+
+
+void BatchedDataNotification::Unregister()
+{
+	// From OnDataBatch this would join the delivery thread or wait for the delivery from within itself
+	if (m_state->deliveringThread == this_thread::get_id())
+	{
+		LogError("BatchedDataNotification::Unregister cannot be called from OnDataBatch");
+		return;
+	}
+
+	if (StopDelivery())
+		Flush();
+}
+
+
+// Stops notifications, the delivery thread and completion events, leaving any pending events in place.
+// Returns false if the notification was not registered.
+bool BatchedDataNotification::StopDelivery()
+{
+	Ref<AnalysisCompletionEvent> completion;
+	{
+		unique_lock<mutex> lock(m_state->lock);
+		if (!m_state->registered)
+			return false;
+		m_state->registered = false;
+	}
+	m_view->UnregisterNotification(this);
+
+	{
+		unique_lock<mutex> lock(m_state->lock);
+		m_state->running = false;
+		m_state->wake.notify_all();
+		completion = m_state->completion;
+		m_state->completion = nullptr;
+	}
+	m_state->timer.join();
+	if (completion)
+		completion->Cancel();
+
+	// Waits for a completion event that is already delivering, and stops any that has yet to start
+	{
+		unique_lock<mutex> lock(m_state->completionLock);
+		m_state->registration++;
+	}
+	m_state->completionArmed = false;
+	return true;
+}
+
+
+bool BatchedDataNotification::IsRegistered() const
+{
+	unique_lock<mutex> lock(m_state->lock);
+	return m_state->registered;
+}
+
+
+uint64_t BatchedDataNotification::GetInterval() const
+{
+	unique_lock<mutex> lock(m_state->lock);
+	return (uint64_t)m_state->interval.count();
+}
+
+
+void BatchedDataNotification::SetInterval(uint64_t interval)
+{
+	unique_lock<mutex> lock(m_state->lock);
+	m_state->interval = chrono::milliseconds(interval);
+	m_state->wake.notify_all();
+}
+
+
+void BatchedDataNotification::Flush()
+{
+	if (m_state->deliveringThread == this_thread::get_id())
+		return;
+
+	unique_lock<mutex> delivery(m_state->deliveryLock);
+	DataNotificationBatch batch;
+	{
+		unique_lock<mutex> lock(m_state->lock);
+		if (m_state->eventCount == 0)
+			return;
+		m_state->TakeBatch(batch);
+	}
+
+	if (batch.writtenRanges.empty() && batch.addedFunctions.empty() && batch.removedFunctions.empty() &&
+		batch.updatedFunctions.empty() && batch.addedDataVariables.empty() && batch.removedDataVariables.empty() &&
+		batch.updatedDataVariables.empty() && batch.foundStrings.empty() && batch.removedStrings.empty())
+		return;
+	m_state->deliveringThread = this_thread::get_id();
+	OnDataBatch(m_view, batch);
+	m_state->deliveringThread = thread::id();
+}
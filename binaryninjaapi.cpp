@@ -18,6 +18,8 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <condition_variable>
+#include <exception>
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
@@ -336,6 +338,73 @@ void BinaryNinja::WorkerInteractiveEnqueue(RefCountObject* owner, const function
 }
 
 
+void BinaryNinja::WorkerParallelFor(size_t count, const function<void(size_t)>& action, size_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = GetWorkerThreadCount();
+	if (threadCount > count)
+		threadCount = count;
+	if (threadCount <= 1)
+	{
+		for (size_t i = 0; i < count; i++)
+			action(i);
+		return;
+	}
+
+	// Workers that start after every index has been claimed return without touching the caller's state, so
+	// only the completion of claimed indices needs to be waited on
+	struct State
+	{
+		atomic<size_t> next;
+		size_t completed;
+		exception_ptr error;
+		mutex lock;
+		condition_variable cv;
+	};
+	shared_ptr<State> state = make_shared<State>();
+	state->next = 0;
+	state->completed = 0;
+
+	function<void()> run = [=]() {
+		size_t finished = 0;
+		for (size_t i = state->next++; i < count; i = state->next++)
+		{
+			try
+			{
+				action(i);
+			}
+			catch (...)
+			{
+				// Stop handing out indices, and count the ones never claimed as finished so the wait below ends
+				size_t unclaimed = state->next.exchange(count);
+				if (unclaimed < count)
+					finished += count - unclaimed;
+				unique_lock<mutex> lock(state->lock);
+				if (!state->error)
+					state->error = current_exception();
+			}
+			finished++;
+		}
+		if (finished == 0)
+			return;
+		unique_lock<mutex> lock(state->lock);
+		state->completed += finished;
+		if (state->completed == count)
+			state->cv.notify_all();
+	};
+
+	for (size_t i = 1; i < threadCount; i++)
+		WorkerEnqueue(run);
+	run();
+
+	unique_lock<mutex> lock(state->lock);
+	while (state->completed < count)
+		state->cv.wait(lock);
+	if (state->error)
+		rethrow_exception(state->error);
+}
+
+
 size_t BinaryNinja::GetWorkerThreadCount()
 {
 	return BNGetWorkerThreadCount();
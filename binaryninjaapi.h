@@ -32,8 +32,12 @@
 #include <functional>
 #include <set>
 #include <mutex>
+#include <atomic>
 #include <memory>
+#include <utility>
+#include <type_traits>
 #include <cstdint>
+#include <cstring>
 #include "binaryninjacore.h"
 #include "json/json.h"
 
@@ -48,10 +52,24 @@
 
 namespace BinaryNinja
 {
+	/*! Adds a reference only while other references are outstanding, so that an object that has started
+		destruction is never revived. Used by WrapperCache lookups.
+	 */
+	inline bool TryAddRefIfReferenced(std::atomic<int>& refs)
+	{
+		int count = refs.load(std::memory_order_relaxed);
+		while (count != 0)
+		{
+			if (refs.compare_exchange_weak(count, count + 1, std::memory_order_relaxed))
+				return true;
+		}
+		return false;
+	}
+
 	class RefCountObject
 	{
 	public:
-		int m_refs;
+		std::atomic<int> m_refs;
 		RefCountObject(): m_refs(0) {}
 		virtual ~RefCountObject() {}
 
@@ -60,22 +78,13 @@ namespace BinaryNinja
 
 		void AddRef()
 		{
-#ifdef WIN32
-			InterlockedIncrement((LONG*)&m_refs);
-#else
-			__sync_fetch_and_add(&m_refs, 1);
-#endif
+			m_refs.fetch_add(1, std::memory_order_relaxed);
 		}
 
 		void Release()
 		{
-#ifdef WIN32
-			if (InterlockedDecrement((LONG*)&m_refs) == 0)
-				delete this;
-#else
-			if (__sync_fetch_and_add(&m_refs, -1) == 1)
+			if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
 				delete this;
-#endif
 		}
 	};
 
@@ -84,26 +93,17 @@ namespace BinaryNinja
 	{
 		void AddRefInternal()
 		{
-#ifdef WIN32
-			InterlockedIncrement((LONG*)&m_refs);
-#else
-			__sync_fetch_and_add(&m_refs, 1);
-#endif
+			m_refs.fetch_add(1, std::memory_order_relaxed);
 		}
 
 		void ReleaseInternal()
 		{
-#ifdef WIN32
-			if (InterlockedDecrement((LONG*)&m_refs) == 0)
+			if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
 				delete this;
-#else
-			if (__sync_fetch_and_add(&m_refs, -1) == 1)
-				delete this;
-#endif
 		}
 
 	public:
-		int m_refs;
+		std::atomic<int> m_refs;
 		T* m_object;
 		CoreRefCountObject(): m_refs(0), m_object(nullptr) {}
 		virtual ~CoreRefCountObject() {}
@@ -119,7 +119,7 @@ namespace BinaryNinja
 
 		void AddRef()
 		{
-			if (m_object && (m_refs != 0))
+			if (m_object && (m_refs.load(std::memory_order_relaxed) != 0))
 				AddObjectReference(m_object);
 			AddRefInternal();
 		}
@@ -141,6 +141,12 @@ namespace BinaryNinja
 			m_object = nullptr;
 			ReleaseInternal();
 		}
+
+		bool TryAddRefForCache()
+		{
+			// No core reference is added; the caller transfers its own
+			return TryAddRefIfReferenced(m_refs);
+		}
 	};
 
 	template <class T>
@@ -148,26 +154,17 @@ namespace BinaryNinja
 	{
 		void AddRefInternal()
 		{
-#ifdef WIN32
-			InterlockedIncrement((LONG*)&m_refs);
-#else
-			__sync_fetch_and_add(&m_refs, 1);
-#endif
+			m_refs.fetch_add(1, std::memory_order_relaxed);
 		}
 
 		void ReleaseInternal()
 		{
-#ifdef WIN32
-			if (InterlockedDecrement((LONG*)&m_refs) == 0)
-				delete this;
-#else
-			if (__sync_fetch_and_add(&m_refs, -1) == 1)
+			if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
 				delete this;
-#endif
 		}
 
 	public:
-		int m_refs;
+		std::atomic<int> m_refs;
 		T* m_object;
 		StaticCoreRefCountObject(): m_refs(0), m_object(nullptr) {}
 		virtual ~StaticCoreRefCountObject() {}
@@ -195,6 +192,11 @@ namespace BinaryNinja
 		{
 			AddRefInternal();
 		}
+
+		bool TryAddRefForCache()
+		{
+			return TryAddRefIfReferenced(m_refs);
+		}
 	};
 
 	template <class T>
@@ -232,6 +234,15 @@ namespace BinaryNinja
 			}
 		}
 
+		Ref<T>(Ref<T>&& obj) NOEXCEPT: m_obj(obj.m_obj)
+		{
+#ifdef BN_REF_COUNT_DEBUG
+			m_assignmentTrace = obj.m_assignmentTrace;
+			obj.m_assignmentTrace = nullptr;
+#endif
+			obj.m_obj = NULL;
+		}
+
 		~Ref<T>()
 		{
 			if (m_obj)
@@ -243,6 +254,47 @@ namespace BinaryNinja
 			}
 		}
 
+		/*! Takes ownership of a reference that the caller already holds on obj (for example one
+			returned by Detach), without adding a new one.
+		 */
+		static Ref<T> Adopt(T* obj)
+		{
+			Ref<T> result;
+			result.m_obj = obj;
+#ifdef BN_REF_COUNT_DEBUG
+			if (obj)
+				result.m_assignmentTrace = BNRegisterObjectRefDebugTrace(typeid(T).name());
+#endif
+			return result;
+		}
+
+		/*! Gives up ownership of the held reference without releasing it. The caller becomes
+			responsible for eventually calling Release on the returned object, or passing it to Adopt.
+		 */
+		T* Detach()
+		{
+#ifdef BN_REF_COUNT_DEBUG
+			if (m_obj)
+				BNUnregisterObjectRefDebugTrace(typeid(T).name(), m_assignmentTrace);
+			m_assignmentTrace = nullptr;
+#endif
+			T* obj = m_obj;
+			m_obj = NULL;
+			return obj;
+		}
+
+		void swap(Ref<T>& obj) NOEXCEPT
+		{
+			T* temp = m_obj;
+			m_obj = obj.m_obj;
+			obj.m_obj = temp;
+#ifdef BN_REF_COUNT_DEBUG
+			void* trace = m_assignmentTrace;
+			m_assignmentTrace = obj.m_assignmentTrace;
+			obj.m_assignmentTrace = trace;
+#endif
+		}
+
 		Ref<T>& operator=(const Ref<T>& obj)
 		{
 #ifdef BN_REF_COUNT_DEBUG
@@ -260,6 +312,16 @@ namespace BinaryNinja
 			return *this;
 		}
 
+		Ref<T>& operator=(Ref<T>&& obj) NOEXCEPT
+		{
+			if (this != &obj)
+			{
+				Ref<T> oldRef(std::move(*this));
+				swap(obj);
+			}
+			return *this;
+		}
+
 		Ref<T>& operator=(T* obj)
 		{
 #ifdef BN_REF_COUNT_DEBUG
@@ -333,6 +395,152 @@ namespace BinaryNinja
 		}
 	};
 
+	template <class T>
+	void swap(Ref<T>& a, Ref<T>& b) NOEXCEPT
+	{
+		a.swap(b);
+	}
+
+	/*! LocalRef is a borrowed, non-owning handle to a reference counted object. It never touches the reference
+		count, so it is free to copy and pass between threads, but it is only valid while some enclosing owner
+		(usually a Ref held by the caller) keeps the object alive. Use ToRef to take a reference that must outlive
+		that owner.
+	 */
+	template <class T>
+	class LocalRef
+	{
+		T* m_obj;
+
+	public:
+		LocalRef<T>(): m_obj(nullptr)
+		{
+		}
+
+		LocalRef<T>(T* obj): m_obj(obj)
+		{
+		}
+
+		LocalRef<T>(const Ref<T>& obj): m_obj(obj.GetPtr())
+		{
+		}
+
+		Ref<T> ToRef() const
+		{
+			return Ref<T>(m_obj);
+		}
+
+		operator T*() const
+		{
+			return m_obj;
+		}
+
+		T* operator->() const
+		{
+			return m_obj;
+		}
+
+		T& operator*() const
+		{
+			return *m_obj;
+		}
+
+		bool operator!() const
+		{
+			return m_obj == nullptr;
+		}
+
+		bool operator==(const T* obj) const
+		{
+			return T::GetObject(m_obj) == T::GetObject(obj);
+		}
+
+		bool operator==(const LocalRef<T>& obj) const
+		{
+			return T::GetObject(m_obj) == T::GetObject(obj.m_obj);
+		}
+
+		bool operator!=(const T* obj) const
+		{
+			return T::GetObject(m_obj) != T::GetObject(obj);
+		}
+
+		bool operator!=(const LocalRef<T>& obj) const
+		{
+			return T::GetObject(m_obj) != T::GetObject(obj.m_obj);
+		}
+
+		bool operator<(const T* obj) const
+		{
+			return T::GetObject(m_obj) < T::GetObject(obj);
+		}
+
+		bool operator<(const LocalRef<T>& obj) const
+		{
+			return T::GetObject(m_obj) < T::GetObject(obj.m_obj);
+		}
+
+		T* GetPtr() const
+		{
+			return m_obj;
+		}
+	};
+
+	/*! WrapperCache interns API wrapper objects by their core handle, so that every lookup of the same core
+		object yields the same C++ object. Entries are weak: a wrapper unregisters itself from its destructor
+		once the last Ref to it has been released. The map is split into shards by handle, each with its own
+		lock, so that threads wrapping different objects rarely contend.
+	 */
+	template <class T, class H>
+	class WrapperCache
+	{
+		static constexpr size_t ShardCount = 64;
+
+		struct Shard
+		{
+			std::mutex m_mutex;
+			std::unordered_map<H*, T*> m_wrappers;
+		};
+		Shard m_shards[ShardCount];
+
+		static Shard& GetShard(H* handle)
+		{
+			// Intentionally leaked, wrappers released during static destruction still unregister themselves
+			static WrapperCache<T, H>* cache = new WrapperCache<T, H>();
+			// Core objects are heap allocated, so the low bits carry no information
+			return cache->m_shards[(reinterpret_cast<uintptr_t>(handle) >> 4) % ShardCount];
+		}
+
+	public:
+		/*! Returns the wrapper for handle, calling create(handle) to construct one if none is alive. Ownership of
+			the core reference held by handle is transferred to the returned wrapper in either case.
+		 */
+		template <class F>
+		static Ref<T> Get(H* handle, const F& create)
+		{
+			if (!handle)
+				return nullptr;
+
+			Shard& shard = GetShard(handle);
+			std::unique_lock<std::mutex> lock(shard.m_mutex);
+			auto i = shard.m_wrappers.find(handle);
+			if ((i != shard.m_wrappers.end()) && i->second->TryAddRefForCache())
+				return Ref<T>::Adopt(i->second);
+
+			T* wrapper = create(handle);
+			shard.m_wrappers[handle] = wrapper;
+			return wrapper;
+		}
+
+		static void Remove(H* handle, T* wrapper)
+		{
+			Shard& shard = GetShard(handle);
+			std::unique_lock<std::mutex> lock(shard.m_mutex);
+			auto i = shard.m_wrappers.find(handle);
+			if ((i != shard.m_wrappers.end()) && (i->second == wrapper))
+				shard.m_wrappers.erase(i);
+		}
+	};
+
 	class ConfidenceBase
 	{
 	protected:
@@ -462,6 +670,10 @@ namespace BinaryNinja
 		{
 		}
 
+		Confidence(Confidence<Ref<T>>&& v) NOEXCEPT: ConfidenceBase(v.m_confidence), m_value(std::move(v.m_value))
+		{
+		}
+
 		operator Ref<T>() const { return m_value; }
 		operator T*() const { return m_value.GetPtr(); }
 		T* operator->() const { return m_value.GetPtr(); }
@@ -478,6 +690,13 @@ namespace BinaryNinja
 			return *this;
 		}
 
+		Confidence<Ref<T>>& operator=(Confidence<Ref<T>>&& v) NOEXCEPT
+		{
+			m_value = std::move(v.m_value);
+			m_confidence = v.m_confidence;
+			return *this;
+		}
+
 		Confidence<Ref<T>>& operator=(T* value)
 		{
 			m_value = value;
@@ -537,6 +756,7 @@ namespace BinaryNinja
 	class Platform;
 	class Type;
 	class DataBuffer;
+	class DataBufferView;
 	class MainThreadAction;
 	class MainThreadActionHandler;
 	class InteractionHandler;
@@ -599,6 +819,7 @@ namespace BinaryNinja
 	void CloseLogs();
 
 	std::string EscapeString(const std::string& s);
+	std::string EscapeString(const DataBufferView& data);
 	std::string UnescapeString(const std::string& s);
 
 	bool PreprocessSource(const std::string& source, const std::string& fileName,
@@ -666,6 +887,14 @@ namespace BinaryNinja
 	void WorkerInteractiveEnqueue(const std::function<void()>& action);
 	void WorkerInteractiveEnqueue(RefCountObject* owner, const std::function<void()>& action);
 
+	/*! Calls action(i) for every i below count, using the calling thread and up to threadCount - 1 worker
+		threads (zero means the worker thread count), and returns once every call has finished. The caller
+		takes part in the work, so this is safe to use from a worker thread even when the pool is busy. If a
+		call throws, no further indices are started, and the first exception is rethrown once the calls
+		already under way have finished.
+	 */
+	void WorkerParallelFor(size_t count, const std::function<void(size_t)>& action, size_t threadCount = 0);
+
 	size_t GetWorkerThreadCount();
 	void SetWorkerThreadCount(size_t count);
 
@@ -699,23 +928,39 @@ namespace BinaryNinja
 
 	std::map<std::string, uint64_t> GetMemoryUsageInfo();
 
+	/*! DataBuffer holds a block of bytes. Buffers of up to InlineCapacity bytes are stored inside the object
+		itself, and default constructed or moved-from buffers hold no storage at all, so small and empty buffers
+		never allocate in the core. A core buffer is created on demand when the contents outgrow the inline
+		storage or when GetBufferObject is called, and backs the object from then on.
+	 */
 	class DataBuffer
 	{
-		BNDataBuffer* m_buffer;
+	public:
+		static constexpr size_t InlineCapacity = 32;
+
+	private:
+		mutable std::atomic<BNDataBuffer*> m_buffer;
+		size_t m_inlineLength;
+		uint8_t m_inline[InlineCapacity];
+
+		void AssignInline(const void* data, size_t len);
+		void ResetToEmpty();
 
 	public:
 		DataBuffer();
 		DataBuffer(size_t len);
 		DataBuffer(const void* data, size_t len);
 		DataBuffer(const DataBuffer& buf);
-		DataBuffer(DataBuffer&& buf);
+		DataBuffer(DataBuffer&& buf) NOEXCEPT;
 		DataBuffer(BNDataBuffer* buf);
+		explicit DataBuffer(const DataBufferView& view);
 		~DataBuffer();
 
 		DataBuffer& operator=(const DataBuffer& buf);
-		DataBuffer& operator=(DataBuffer&& buf);
+		DataBuffer& operator=(DataBuffer&& buf) NOEXCEPT;
 
-		BNDataBuffer* GetBufferObject() const { return m_buffer; }
+		BNDataBuffer* GetBufferObject() const;
+		bool IsInline() const { return m_buffer.load(std::memory_order_acquire) == nullptr; }
 
 		void* GetData();
 		const void* GetData() const;
@@ -730,6 +975,8 @@ namespace BinaryNinja
 		void AppendByte(uint8_t val);
 
 		DataBuffer GetSlice(size_t start, size_t len);
+		DataBufferView GetView() const;
+		DataBufferView GetView(size_t start, size_t len) const;
 
 		uint8_t& operator[](size_t offset);
 		const uint8_t& operator[](size_t offset) const;
@@ -743,11 +990,54 @@ namespace BinaryNinja
 		bool ZlibDecompress(DataBuffer& output) const;
 	};
 
+	/*! DataBufferView is a non-owning, read-only window onto contiguous bytes, usually all or part of a DataBuffer.
+		Slicing a view never copies. A view created from a shared_ptr keeps that buffer alive; any other view
+		requires the caller to keep the underlying storage alive for as long as the view is in use.
+	 */
+	class DataBufferView
+	{
+		const uint8_t* m_data;
+		size_t m_length;
+		const DataBuffer* m_buffer;
+		std::shared_ptr<const DataBuffer> m_owner;
+
+	public:
+		DataBufferView();
+		DataBufferView(const void* data, size_t len);
+		DataBufferView(const DataBuffer& buf);
+		DataBufferView(const std::string& str);
+		DataBufferView(const std::shared_ptr<const DataBuffer>& owner);
+
+		const void* GetData() const { return m_data; }
+		const void* GetDataAt(size_t offset) const { return m_data + offset; }
+		size_t GetLength() const { return m_length; }
+		bool IsEmpty() const { return m_length == 0; }
+
+		/*! Returns the DataBuffer this view covers in its entirety, or nullptr if the view is over a part of a
+			buffer or over foreign memory. Used to hand the existing core buffer to the core without a copy.
+		 */
+		const DataBuffer* GetBuffer() const { return m_buffer; }
+
+		const uint8_t& operator[](size_t offset) const { return m_data[offset]; }
+		const uint8_t* begin() const { return m_data; }
+		const uint8_t* end() const { return m_data + m_length; }
+
+		DataBufferView GetSlice(size_t start, size_t len) const;
+		DataBuffer ToBuffer() const;
+		std::string ToString() const;
+
+		std::string ToEscapedString() const;
+		std::string ToBase64() const;
+		bool ZlibCompress(DataBuffer& output) const;
+		bool ZlibDecompress(DataBuffer& output) const;
+	};
+
 	class TemporaryFile: public CoreRefCountObject<BNTemporaryFile, BNNewTemporaryFileReference, BNFreeTemporaryFile>
 	{
 	public:
 		TemporaryFile();
 		TemporaryFile(const DataBuffer& contents);
+		TemporaryFile(const DataBufferView& contents);
 		TemporaryFile(const std::string& contents);
 		TemporaryFile(BNTemporaryFile* file);
 
@@ -945,6 +1235,135 @@ namespace BinaryNinja
 		virtual size_t Write(uint64_t offset, const void* src, size_t len) override;
 	};
 
+#ifndef WIN32
+	enum MmapAccessHint
+	{
+		MmapNormalAccess,
+		MmapSequentialAccess,
+		MmapRandomAccess,
+		MmapWillNeedAccess
+	};
+
+	/*! FileAccessor backed by a read-only MAP_PRIVATE mapping of a file, so opening very large inputs with
+		BinaryData(FileMetadata*, FileAccessor*) does not require reading the file up front. Reads are served
+		directly from the mapping. Writes never reach the file; they are kept in page sized copy-on-write
+		overlays, and writes past the end extend the accessor's length. The accessor must outlive any view
+		created from it.
+	 */
+	class MmapFileAccessor: public FileAccessor
+	{
+		int m_fd;
+		const uint8_t* m_base;
+		uint64_t m_fileLength;
+		std::atomic<uint64_t> m_length;
+		uint64_t m_pageSize;
+
+		std::mutex m_overlayMutex;
+		std::atomic<bool> m_hasOverlays;
+		std::map<uint64_t, std::vector<uint8_t>> m_overlays;
+
+		void ReadMapped(uint8_t* dest, uint64_t offset, size_t len) const;
+
+	public:
+		MmapFileAccessor(const std::string& path);
+		virtual ~MmapFileAccessor();
+
+		virtual bool IsValid() const override { return m_fd != -1; }
+		virtual uint64_t GetLength() const override { return m_length; }
+		virtual size_t Read(void* dest, uint64_t offset, size_t len) override;
+		virtual size_t Write(uint64_t offset, const void* src, size_t len) override;
+
+		/*! Passes an access pattern hint for a range of the file to madvise. A length of zero covers the
+			rest of the file. */
+		bool Advise(MmapAccessHint hint, uint64_t offset = 0, uint64_t len = 0);
+
+		bool IsModified();
+		size_t GetOverlayPageCount();
+		void DiscardWrites();
+	};
+#endif
+
+	/*! Receives output from ZlibCompressor and ZlibDecompressor in order. Returning false aborts the stream. */
+	typedef std::function<bool(const void* data, size_t len)> ZlibOutputCallback;
+
+	/*! Incrementally compresses data into a single zlib stream. Input is split into blocks of blockSize bytes,
+		which are compressed independently (on the worker thread pool when threadCount is greater than one)
+		and joined in order, so at most threadCount + 1 blocks are held in memory at any time. Because blocks
+		do not share history the result is slightly larger than compressing the data as one buffer.
+	 */
+	class ZlibCompressor
+	{
+	public:
+		static constexpr size_t DefaultBlockSize = 1024 * 1024;
+
+	private:
+		struct Block;
+
+		ZlibOutputCallback m_output;
+		uint64_t m_outputOffset;
+		size_t m_threadCount;
+		size_t m_blockSize;
+		std::vector<uint8_t> m_current;
+		std::vector<std::shared_ptr<Block>> m_pending;
+		uint32_t m_adler;
+		uint64_t m_totalIn, m_totalOut;
+		bool m_headerWritten, m_finished, m_failed;
+
+		bool Emit(const void* data, size_t len);
+		bool SubmitBlock();
+		bool RetireOldestBlock();
+
+	public:
+		ZlibCompressor(const ZlibOutputCallback& output, size_t threadCount = 1, size_t blockSize = DefaultBlockSize);
+		ZlibCompressor(FileAccessor* output, uint64_t offset = 0, size_t threadCount = 1,
+			size_t blockSize = DefaultBlockSize);
+		ZlibCompressor(const ZlibCompressor&) = delete;
+		ZlibCompressor& operator=(const ZlibCompressor&) = delete;
+		~ZlibCompressor();
+
+		bool Write(const void* data, size_t len);
+		bool Write(const DataBufferView& data);
+		bool Finish();
+
+		bool HasFailed() const { return m_failed; }
+		uint64_t GetTotalIn() const { return m_totalIn; }
+		uint64_t GetTotalOut() const { return m_totalOut; }
+	};
+
+	/*! Incrementally decompresses a zlib stream (or a raw deflate stream when rawDeflate is set). Input may be
+		written in chunks of any size; output is passed on in pieces of at most 64 KiB and only the 32 KiB
+		history window is retained, so memory use does not depend on the size of the stream.
+	 */
+	class ZlibDecompressor
+	{
+		struct State;
+
+		std::unique_ptr<State> m_state;
+		ZlibOutputCallback m_output;
+		uint64_t m_outputOffset;
+
+		bool Process(bool final);
+		bool Flush();
+		bool Fail(const std::string& error);
+
+	public:
+		ZlibDecompressor(const ZlibOutputCallback& output, bool rawDeflate = false);
+		ZlibDecompressor(FileAccessor* output, uint64_t offset = 0, bool rawDeflate = false);
+		ZlibDecompressor(const ZlibDecompressor&) = delete;
+		ZlibDecompressor& operator=(const ZlibDecompressor&) = delete;
+		~ZlibDecompressor();
+
+		bool Write(const void* data, size_t len);
+		bool Write(const DataBufferView& data);
+		bool Finish();
+
+		bool IsComplete() const;
+		bool HasFailed() const;
+		std::string GetError() const;
+		uint64_t GetTotalIn() const;
+		uint64_t GetTotalOut() const;
+	};
+
 	class Function;
 	class BasicBlock;
 	class NameList
@@ -1066,6 +1485,20 @@ namespace BinaryNinja
 		uint64_t addr;
 	};
 
+	/*! Result of a batched reference query in compressed sparse row form. The references to or from the i-th
+		queried address are refs[offsets[i]] up to but not including refs[offsets[i + 1]].
+	 */
+	template <typename T>
+	struct ReferenceTable
+	{
+		std::vector<size_t> offsets;
+		std::vector<T> refs;
+
+		size_t GetAddressCount() const { return offsets.empty() ? 0 : (offsets.size() - 1); }
+		size_t GetReferenceCount(size_t i) const { return offsets[i + 1] - offsets[i]; }
+		const T* GetReferences(size_t i) const { return refs.data() + offsets[i]; }
+	};
+
 	struct InstructionTextToken
 	{
 		BNInstructionTextTokenType type;
@@ -1143,7 +1576,7 @@ namespace BinaryNinja
 		size_t updateCount;
 		size_t submitCount;
 
-		ActiveAnalysisInfo(Ref<Function> f, uint64_t t, size_t uc, size_t sc) : func(f), analysisTime(t), updateCount(uc), submitCount(sc)
+		ActiveAnalysisInfo(Ref<Function> f, uint64_t t, size_t uc, size_t sc) : func(std::move(f)), analysisTime(t), updateCount(uc), submitCount(sc)
 		{
 		}
 	};
@@ -1165,6 +1598,79 @@ namespace BinaryNinja
 		bool autoDiscovered;
 	};
 
+	/*! Events accumulated by a BatchedDataNotification since the previous batch */
+	struct DataNotificationBatch
+	{
+		std::vector<std::pair<uint64_t, uint64_t>> writtenRanges; // Sorted and merged [start, end) ranges
+		std::vector<Ref<Function>> addedFunctions, removedFunctions, updatedFunctions;
+		std::vector<DataVariable> addedDataVariables, removedDataVariables, updatedDataVariables;
+		std::vector<BNStringReference> foundStrings, removedStrings;
+		size_t eventCount; // Number of individual events folded into this batch
+
+		DataNotificationBatch(): eventCount(0) {}
+	};
+
+	/*! Opt-in batched delivery of data notifications. Data writes, function, data variable and string events
+		are accumulated and delivered together through OnDataBatch, at most interval milliseconds after the
+		first pending event, when analysis completes, or when Flush is called. Overlapping and adjacent
+		written ranges are merged, and repeated events for the same function, data variable or string are
+		collapsed so that each appears in at most one list of a batch. An add followed by a remove in the same
+		batch cancels out.
+
+		Inserts and removes shift addresses, so the pending batch is delivered before they are passed to
+		OnBinaryDataInserted and OnBinaryDataRemoved. Other events are delivered individually as with
+		BinaryDataNotification.
+
+		Use Register and Unregister rather than BinaryView::RegisterNotification, so that the delivery timer
+		runs only while registered. Unregister delivers the pending batch and must be called before a
+		subclass is destroyed; destroying a registered notification logs an error and discards the pending
+		batch. Unregister must not be called from OnDataBatch, and Flush does nothing there.
+	 */
+	class BatchedDataNotification: public BinaryDataNotification
+	{
+		struct BatchState;
+
+		Ref<BinaryView> m_view;
+		std::shared_ptr<BatchState> m_state;
+
+		static void DataWrittenCallback(void* ctxt, BNBinaryView* data, uint64_t offset, size_t len);
+		static void DataInsertedCallback(void* ctxt, BNBinaryView* data, uint64_t offset, size_t len);
+		static void DataRemovedCallback(void* ctxt, BNBinaryView* data, uint64_t offset, uint64_t len);
+		static void FunctionAddedCallback(void* ctxt, BNBinaryView* data, BNFunction* func);
+		static void FunctionRemovedCallback(void* ctxt, BNBinaryView* data, BNFunction* func);
+		static void FunctionUpdatedCallback(void* ctxt, BNBinaryView* data, BNFunction* func);
+		static void DataVariableAddedCallback(void* ctxt, BNBinaryView* data, BNDataVariable* var);
+		static void DataVariableRemovedCallback(void* ctxt, BNBinaryView* data, BNDataVariable* var);
+		static void DataVariableUpdatedCallback(void* ctxt, BNBinaryView* data, BNDataVariable* var);
+		static void StringFoundCallback(void* ctxt, BNBinaryView* data, BNStringType type, uint64_t offset, size_t len);
+		static void StringRemovedCallback(void* ctxt, BNBinaryView* data, BNStringType type, uint64_t offset, size_t len);
+
+		void EventAdded();
+		void ArmCompletionEvent();
+		void DeliveryThread();
+		bool StopDelivery();
+
+	public:
+		static constexpr uint64_t DefaultInterval = 250;
+
+		BatchedDataNotification(BinaryView* view, uint64_t interval = DefaultInterval);
+		BatchedDataNotification(const BatchedDataNotification&) = delete;
+		BatchedDataNotification& operator=(const BatchedDataNotification&) = delete;
+		virtual ~BatchedDataNotification();
+
+		void Register();
+		void Unregister();
+		bool IsRegistered() const;
+
+		uint64_t GetInterval() const;
+		void SetInterval(uint64_t interval);
+
+		/*! Delivers the pending batch now, if there is one. Batches are never delivered concurrently. */
+		void Flush();
+
+		virtual void OnDataBatch(BinaryView* view, const DataNotificationBatch& batch) { (void)view; (void)batch; }
+	};
+
 	class Relocation;
 	class Segment: public CoreRefCountObject<BNSegment, BNNewSegmentReference, BNFreeSegment>
 	{
@@ -1323,11 +1829,22 @@ namespace BinaryNinja
 		size_t Read(void* dest, uint64_t offset, size_t len);
 		DataBuffer ReadBuffer(uint64_t offset, size_t len);
 
+		/*! Positional reads that keep no cursor or other state in the API, so any number of threads may call
+			them on the same view at once without a BinaryReader per thread or any client side locking. A read
+			that races with a write to the same range may return the bytes from before or after the write.
+			ReadAt returns true only if all len bytes were read; ReadAt<T> throws ReadException instead.
+		 */
+		bool ReadAt(uint64_t offset, void* dest, size_t len) const;
+		template <typename T> bool TryReadAt(uint64_t offset, T& value, BNEndianness endian) const;
+		template <typename T> T ReadAt(uint64_t offset, BNEndianness endian) const;
+
 		size_t Write(uint64_t offset, const void* data, size_t len);
 		size_t WriteBuffer(uint64_t offset, const DataBuffer& data);
+		size_t WriteBuffer(uint64_t offset, const DataBufferView& data);
 
 		size_t Insert(uint64_t offset, const void* data, size_t len);
 		size_t InsertBuffer(uint64_t offset, const DataBuffer& data);
+		size_t InsertBuffer(uint64_t offset, const DataBufferView& data);
 
 		size_t Remove(uint64_t offset, uint64_t len);
 
@@ -1409,6 +1926,14 @@ namespace BinaryNinja
 		std::vector<uint64_t> GetDataReferencesFrom(uint64_t addr);
 		std::vector<uint64_t> GetDataReferencesFrom(uint64_t addr, uint64_t len);
 
+		/*! Batched forms of the single address queries above. Results are in the order of addrs, which should
+			be sorted for the best locality. The query is split into chunks that run on up to threadCount
+			threads (zero means the worker thread count).
+		 */
+		ReferenceTable<ReferenceSource> GetCodeReferences(const std::vector<uint64_t>& addrs, size_t threadCount = 1);
+		ReferenceTable<uint64_t> GetDataReferences(const std::vector<uint64_t>& addrs, size_t threadCount = 1);
+		ReferenceTable<uint64_t> GetDataReferencesFrom(const std::vector<uint64_t>& addrs, size_t threadCount = 1);
+
 		Ref<Symbol> GetSymbolByAddress(uint64_t addr, const NameSpace& nameSpace=NameSpace());
 		Ref<Symbol> GetSymbolByRawName(const std::string& name, const NameSpace& nameSpace=NameSpace());
 		std::vector<Ref<Symbol>> GetSymbolsByName(const std::string& name, const NameSpace& nameSpace=NameSpace());
@@ -1493,6 +2018,23 @@ namespace BinaryNinja
 		bool FindNextConstant(uint64_t start, uint64_t end, uint64_t constant, uint64_t& addr, Ref<DisassemblySettings> settings,
 			const std::function<bool(size_t current, size_t total)>& progress);
 
+		/*! Finds every occurrence of pattern that starts between start and end. A byte only has to match in the
+			bits that are set in the corresponding byte of mask; an empty mask requires every bit to match. Each
+			readable segment in the range is split into chunks that are searched on up to threadCount threads
+			(zero means the worker thread count). Hits are passed to callback in address order, one call at a
+			time, and the search stops when callback returns false. When task is given, its progress text is
+			updated and cancelling it stops the search. Returns false if the search was stopped early.
+		 */
+		bool FindAllData(uint64_t start, uint64_t end, const DataBuffer& pattern, const DataBuffer& mask,
+			const std::function<bool(uint64_t addr)>& callback, size_t threadCount = 0, BackgroundTask* task = nullptr);
+
+		/*! Form of FindAllData that takes a pattern such as "48 8b ?? ?5 c3", where ? is a wildcard nibble.
+			Returns false without searching if the pattern is invalid. */
+		bool FindAllData(uint64_t start, uint64_t end, const std::string& pattern,
+			const std::function<bool(uint64_t addr)>& callback, size_t threadCount = 0, BackgroundTask* task = nullptr);
+
+		static bool ParseBytePattern(const std::string& text, DataBuffer& pattern, DataBuffer& mask);
+
 		void Reanalyze();
 
 		void ShowPlainTextReport(const std::string& title, const std::string& contents);
@@ -1573,6 +2115,468 @@ namespace BinaryNinja
 		BinaryData(FileMetadata* file, FileAccessor* accessor);
 	};
 
+	/*! Base class for custom views whose reads are expensive, such as views that decompress or decrypt
+		their contents. Reads from the core are served from an LRU cache of fixed size pages, and only missing
+		pages are passed to PerformUncachedRead, with runs of consecutive missing pages fetched in one call.
+		Writes, inserts and removes are passed to the PerformUncached methods and invalidate the affected
+		pages. Subclasses whose underlying data changes by other means should call InvalidateCache.
+	 */
+	class CachedBinaryView: public BinaryView
+	{
+		struct PageCache;
+
+		std::unique_ptr<PageCache> m_cache;
+		std::atomic<uint64_t> m_cacheHits, m_cacheMisses;
+
+	protected:
+		static constexpr size_t DefaultPageSize = 0x1000;
+		static constexpr size_t DefaultPageCount = 1024;
+
+		CachedBinaryView(const std::string& typeName, FileMetadata* file, BinaryView* parentView = nullptr,
+			size_t pageCount = DefaultPageCount, size_t pageSize = DefaultPageSize);
+
+		virtual size_t PerformRead(void* dest, uint64_t offset, size_t len) override final;
+		virtual size_t PerformWrite(uint64_t offset, const void* data, size_t len) override final;
+		virtual size_t PerformInsert(uint64_t offset, const void* data, size_t len) override final;
+		virtual size_t PerformRemove(uint64_t offset, uint64_t len) override final;
+
+		virtual size_t PerformUncachedRead(void* dest, uint64_t offset, size_t len) = 0;
+		virtual size_t PerformUncachedWrite(uint64_t offset, const void* data, size_t len) { (void)offset; (void)data; (void)len; return 0; }
+		virtual size_t PerformUncachedInsert(uint64_t offset, const void* data, size_t len) { (void)offset; (void)data; (void)len; return 0; }
+		virtual size_t PerformUncachedRemove(uint64_t offset, uint64_t len) { (void)offset; (void)len; return 0; }
+
+	public:
+		virtual ~CachedBinaryView();
+
+		size_t GetCachePageSize() const;
+		size_t GetCachePageCount() const;
+		void SetCachePageCount(size_t pageCount);
+
+		/*! Drops cached pages overlapping [offset, offset + len) */
+		void InvalidateCache(uint64_t offset, uint64_t len);
+		void ClearCache();
+
+		uint64_t GetCacheHitCount() const { return m_cacheHits; }
+		uint64_t GetCacheMissCount() const { return m_cacheMisses; }
+		void ResetCacheStatistics();
+	};
+
+	/*! Base for cursors that stream items of a view in address order. Each call to Next returns about
+		chunkSize items, so memory use is bounded by the chunk size instead of the total number of items. The
+		cursor only holds an address, so an enumeration can be resumed later with Seek(GetPosition()). Items
+		added or removed ahead of the cursor between calls are reflected in later chunks. Next replaces the
+		contents of its argument with the next chunk and returns false once there is nothing left.
+	 */
+	class AddressCursor
+	{
+	protected:
+		Ref<BinaryView> m_view;
+		uint64_t m_position, m_end;
+		size_t m_chunkSize;
+		uint64_t m_window;
+
+		AddressCursor(BinaryView* view, uint64_t start, uint64_t end, size_t chunkSize);
+
+		uint64_t GetWindowEnd() const;
+		bool IsWindowTooLarge(size_t count) const;
+		void ShrinkWindow(size_t count);
+		void FinishWindow(uint64_t windowEnd, size_t count);
+
+	public:
+		static constexpr size_t DefaultChunkSize = 4096;
+
+		virtual ~AddressCursor() {}
+
+		bool IsAtEnd() const { return m_position >= m_end; }
+		uint64_t GetPosition() const { return m_position; }
+		void Seek(uint64_t addr) { m_position = addr; }
+		size_t GetChunkSize() const { return m_chunkSize; }
+	};
+
+	class StringCursor: public AddressCursor
+	{
+	public:
+		StringCursor(BinaryView* view, size_t chunkSize = DefaultChunkSize);
+		StringCursor(BinaryView* view, uint64_t start, uint64_t end, size_t chunkSize = DefaultChunkSize);
+
+		bool Next(std::vector<BNStringReference>& strings);
+	};
+
+	class SymbolCursor: public AddressCursor
+	{
+		NameSpace m_nameSpace;
+		bool m_filterType;
+		BNSymbolType m_type;
+
+	public:
+		SymbolCursor(BinaryView* view, const NameSpace& nameSpace = NameSpace(), size_t chunkSize = DefaultChunkSize);
+		SymbolCursor(BinaryView* view, BNSymbolType type, const NameSpace& nameSpace = NameSpace(),
+			size_t chunkSize = DefaultChunkSize);
+		SymbolCursor(BinaryView* view, uint64_t start, uint64_t end, const NameSpace& nameSpace = NameSpace(),
+			size_t chunkSize = DefaultChunkSize);
+		SymbolCursor(BinaryView* view, BNSymbolType type, uint64_t start, uint64_t end,
+			const NameSpace& nameSpace = NameSpace(), size_t chunkSize = DefaultChunkSize);
+
+		bool Next(std::vector<Ref<Symbol>>& symbols);
+	};
+
+	class DataVariableCursor: public AddressCursor
+	{
+	public:
+		DataVariableCursor(BinaryView* view, size_t chunkSize = DefaultChunkSize);
+		DataVariableCursor(BinaryView* view, uint64_t start, uint64_t end, size_t chunkSize = DefaultChunkSize);
+
+		bool Next(std::vector<DataVariable>& vars);
+	};
+
+	/*! Finds many byte patterns at once. The patterns are compiled into an Aho-Corasick automaton when the
+		scanner is created, after which a scan makes a single pass over the data no matter how many patterns
+		there are. A pattern's id is its index in the list given to the constructor. The scanner is immutable,
+		so one instance can be shared between threads and used with any number of views.
+	 */
+	class MultiPatternScanner
+	{
+		struct Automaton;
+
+		std::unique_ptr<Automaton> m_automaton;
+
+	public:
+		struct Match
+		{
+			size_t patternId;
+			uint64_t address;
+		};
+
+		MultiPatternScanner(const std::vector<DataBuffer>& patterns);
+		MultiPatternScanner(const MultiPatternScanner&) = delete;
+		MultiPatternScanner& operator=(const MultiPatternScanner&) = delete;
+		~MultiPatternScanner();
+
+		size_t GetPatternCount() const;
+		size_t GetMaxPatternLength() const;
+
+		/*! Finds the patterns in data, which is taken to be located at base. Matches are appended to matches
+			sorted by address, then by pattern id. */
+		void Scan(const uint8_t* data, size_t len, uint64_t base, std::vector<Match>& matches) const;
+
+		/*! Scans the segments of view between start and end in parallel, in the same way as
+			BinaryView::FindAllData, passing matches to callback in address order. Returns false if the scan
+			was stopped by the callback or by cancelling task.
+		 */
+		bool Scan(BinaryView* view, uint64_t start, uint64_t end,
+			const std::function<bool(size_t patternId, uint64_t addr)>& callback, size_t threadCount = 0,
+			BackgroundTask* task = nullptr) const;
+		bool Scan(BinaryView* view, const std::function<bool(size_t patternId, uint64_t addr)>& callback,
+			size_t threadCount = 0, BackgroundTask* task = nullptr) const;
+	};
+
+	/*! Regular expression over raw bytes, matched with lazily built DFAs so that scan time is linear in the size
+		of the data. The syntax supports literal characters, \\xNN escapes, ".", character classes such as
+		[\\x00-\\x1f] and [^a-z], \\d, \\w and \\s, groups, alternation, and the *, +, ?, {n}, {n,} and {n,m}
+		quantifiers. Each DFA keeps at most maxCachedStates states per scanning thread and is rebuilt when the
+		cache fills, so memory use is bounded for any pattern.
+
+		Matches are leftmost-longest, never overlap and are never empty: each one starts at the earliest
+		position with a match of at most maxMatchLength bytes, and is the longest such match from there. The
+		next match is searched for from the end of the previous one.
+	 */
+	class ByteRegex
+	{
+		struct Program;
+
+		std::unique_ptr<Program> m_program;
+		std::string m_error;
+
+	public:
+		struct Match
+		{
+			uint64_t address;
+			size_t length;
+		};
+
+		static constexpr size_t DefaultMaxMatchLength = 0x10000;
+		static constexpr size_t DefaultMaxCachedStates = 4096;
+
+		ByteRegex(const std::string& pattern, size_t maxMatchLength = DefaultMaxMatchLength,
+			size_t maxCachedStates = DefaultMaxCachedStates);
+		ByteRegex(const ByteRegex&) = delete;
+		ByteRegex& operator=(const ByteRegex&) = delete;
+		~ByteRegex();
+
+		bool IsValid() const { return m_program != nullptr; }
+		std::string GetError() const { return m_error; }
+		size_t GetMaxMatchLength() const;
+
+		/*! Finds matches that start in the first positions bytes of data, which is taken to be located at
+			base. Bytes after that are only used to complete matches. Returns the end of the last match
+			relative to data, or zero if there were none. */
+		size_t Scan(const uint8_t* data, size_t len, size_t positions, uint64_t base,
+			std::vector<Match>& matches) const;
+		void Scan(const uint8_t* data, size_t len, uint64_t base, std::vector<Match>& matches) const;
+
+		/*! Scans the segments of view between start and end in parallel, in the same way as
+			BinaryView::FindAllData. Matches that cross the boundary between two chunks are stitched, so the
+			results are the same as a single scan from start to end. Returns false if the regular expression
+			is invalid or the scan was stopped by the callback or by cancelling task.
+		 */
+		bool Scan(BinaryView* view, uint64_t start, uint64_t end,
+			const std::function<bool(uint64_t addr, size_t len)>& callback, size_t threadCount = 0,
+			BackgroundTask* task = nullptr) const;
+		bool Scan(BinaryView* view, const std::function<bool(uint64_t addr, size_t len)>& callback,
+			size_t threadCount = 0, BackgroundTask* task = nullptr) const;
+	};
+
+	/*! Block entropy of a view, computed on worker threads and cached. Values are the Shannon entropy of each
+		block divided by 8, the same scale as BinaryView::GetEntropy. Cached blocks are only recomputed after
+		the view reports a write, insert or remove touching them.
+
+		Block values are kept in a pyramid of sums over power of two runs of blocks, so GetOverview can
+		summarize any range at any width by visiting O(log n) nodes per column once the blocks are known.
+	 */
+	class EntropyCache: public BinaryDataNotification
+	{
+		Ref<BinaryView> m_view;
+		size_t m_blockSize;
+		size_t m_threadCount;
+		bool m_registered;
+
+		std::mutex m_mutex;
+		uint64_t m_start;
+		size_t m_blockCount;
+		std::vector<float> m_blocks;
+		std::vector<bool> m_valid;
+		std::vector<uint32_t> m_epochs; // Changed whenever a block is invalidated
+		uint32_t m_epoch;
+		std::vector<std::vector<double>> m_levels; // Level n holds sums over runs of 2^(n+1) blocks
+		std::vector<std::vector<bool>> m_dirty;
+
+		void ResizeLocked(uint64_t changed);
+		void InvalidateLocked(uint64_t start, uint64_t end);
+		void MarkDirtyLocked(size_t first, size_t last);
+		void ComputeBlocks(size_t first, size_t last);
+		double GetSumLocked(size_t level, size_t index);
+		double GetRangeSumLocked(size_t first, size_t last);
+
+	public:
+		static constexpr size_t DefaultBlockSize = 1024;
+
+		/*! Creates a cache over view. Unless registerNotifications is false, the cache registers itself for
+			data notifications on view, otherwise the owner must call Invalidate. A threadCount of zero uses
+			all worker threads. */
+		EntropyCache(BinaryView* view, size_t blockSize = DefaultBlockSize, size_t threadCount = 0,
+			bool registerNotifications = true);
+		EntropyCache(const EntropyCache&) = delete;
+		EntropyCache& operator=(const EntropyCache&) = delete;
+		virtual ~EntropyCache();
+
+		size_t GetBlockSize() const { return m_blockSize; }
+
+		/*! Fills counts with the number of occurrences of each byte value in data. */
+		static void ComputeHistogram(const uint8_t* data, size_t len, uint32_t counts[256]);
+		static float ComputeEntropy(const uint8_t* data, size_t len);
+
+		/*! Returns the entropy of each block overlapping [start, end). Blocks are aligned to the start of
+			the view. */
+		std::vector<float> GetBlockEntropy(uint64_t start, uint64_t end);
+
+		/*! Splits [start, end) into columns equal parts and returns the mean block entropy of each. Columns
+			narrower than a block take the value of the block they fall in. */
+		std::vector<float> GetOverview(uint64_t start, uint64_t end, size_t columns);
+
+		/*! Drops the cached values of blocks overlapping [start, end). */
+		void Invalidate(uint64_t start, uint64_t end);
+		void InvalidateAll();
+
+		/*! Returns a counter that changes whenever cached values are dropped, so that owners can tell when
+			a display built from the cache is out of date. */
+		uint32_t GetChangeCount();
+
+		virtual void OnBinaryDataWritten(BinaryView* view, uint64_t offset, size_t len) override;
+		virtual void OnBinaryDataInserted(BinaryView* view, uint64_t offset, size_t len) override;
+		virtual void OnBinaryDataRemoved(BinaryView* view, uint64_t offset, uint64_t len) override;
+	};
+
+	/*! Client side index of the symbols of a view in one name space. Lookups by name use hash tables over the
+		raw, short and full names, and lookups by address use a sorted array, so neither calls into the core.
+
+		The index is built on first use. Afterwards only addresses whose symbols may have changed are queried
+		again: addresses passed to symbol definitions made through BinaryView, the starts of added or removed
+		functions and data variables, and addresses passed to RefreshAddress. Inserting or removing data
+		rebuilds the index. Symbols defined by other means, such as by the core or another language binding,
+		without an accompanying function or data variable change are picked up by RefreshAddress or Refresh.
+	 */
+	class SymbolIndex: public BinaryDataNotification
+	{
+		struct Entry
+		{
+			Ref<Symbol> symbol;
+			uint64_t address;
+			std::string rawName, shortName, fullName;
+			bool live;
+		};
+
+		Ref<BinaryView> m_view;
+		NameSpace m_nameSpace;
+		bool m_registered;
+
+		std::mutex m_updateMutex; // Held while querying the view, before m_mutex when both are needed
+		std::mutex m_mutex;
+		bool m_stale;
+		uint64_t m_generation; // Incremented by Refresh
+		std::vector<Entry> m_entries;
+		std::vector<size_t> m_freeEntries, m_removedEntries;
+		std::unordered_map<std::string, std::vector<size_t>> m_rawNames, m_names;
+		std::vector<std::pair<uint64_t, size_t>> m_addresses; // Sorted by address
+		std::vector<std::pair<uint64_t, size_t>> m_addedAddresses;
+		std::set<uint64_t> m_changedAddresses;
+
+		void AddEntryLocked(const Ref<Symbol>& symbol);
+		void RemoveEntryLocked(size_t entry);
+		void MergeAddressesLocked();
+		void Update(std::unique_lock<std::mutex>& lock);
+		void AddressChanged(uint64_t addr);
+
+	public:
+		SymbolIndex(BinaryView* view, const NameSpace& nameSpace = NameSpace(), bool registerNotifications = true);
+		SymbolIndex(const SymbolIndex&) = delete;
+		SymbolIndex& operator=(const SymbolIndex&) = delete;
+		virtual ~SymbolIndex();
+
+		/*! Called by BinaryView after it defines or undefines sym, and for imported functions, the symbol
+			at the start of func */
+		static void NotifySymbolChanged(BNBinaryView* view, Symbol* sym, Function* func = nullptr);
+
+		void Refresh();
+		void RefreshAddress(uint64_t addr);
+
+		size_t GetSymbolCount();
+		Ref<Symbol> GetSymbolByAddress(uint64_t addr);
+		Ref<Symbol> GetSymbolByRawName(const std::string& name);
+		std::vector<Ref<Symbol>> GetSymbolsByName(const std::string& name);
+		std::vector<Ref<Symbol>> GetSymbols(uint64_t start, uint64_t len);
+
+		virtual void OnBinaryDataInserted(BinaryView* view, uint64_t offset, size_t len) override;
+		virtual void OnBinaryDataRemoved(BinaryView* view, uint64_t offset, uint64_t len) override;
+		virtual void OnAnalysisFunctionAdded(BinaryView* view, Function* func) override;
+		virtual void OnAnalysisFunctionRemoved(BinaryView* view, Function* func) override;
+		virtual void OnDataVariableAdded(BinaryView* view, const DataVariable& var) override;
+		virtual void OnDataVariableRemoved(BinaryView* view, const DataVariable& var) override;
+		virtual void OnDataVariableUpdated(BinaryView* view, const DataVariable& var) override;
+	};
+
+	enum SegmentMapFlag
+	{
+		SegmentMapReadable = 1,
+		SegmentMapWritable = 2,
+		SegmentMapExecutable = 4,
+		SegmentMapBackedByFile = 8,
+		SegmentMapCodeSemantics = 0x10,
+		SegmentMapWritableSemantics = 0x20,
+		SegmentMapExternSemantics = 0x40,
+		SegmentMapPointerToCode = 0x80, // Executable with code semantics
+		SegmentMapInSegment = 0x100,
+		SegmentMapInSection = 0x200,
+		SegmentMapMixedPage = 0x8000 // Page table entry only: the page needs an interval lookup
+	};
+
+	/*! Snapshot of the segments and sections of a view for fast permission and semantics queries. The
+		address space is split into a sorted table of intervals with uniform flags, and a table with one entry
+		per 4 KiB page answers most queries with a single load. Pages that contain an interval boundary fall
+		back to a binary search of the interval table.
+
+		Sections give code, writable and extern semantics where present. Where no section has semantics other
+		than DefaultSectionSemantics, executable segments have code semantics and writable segments have
+		writable semantics. A view without segments is treated as one readable, writable and file backed
+		segment covering the view.
+
+		The snapshot does not track the view. Call Update before a batch of queries; it compares the current
+		segments and sections with the snapshot and only rebuilds when they differ. Queries are const and may
+		be made from multiple threads, but not concurrently with Update.
+	 */
+	class SegmentMap
+	{
+		struct Interval
+		{
+			uint64_t start, end;
+			uint16_t flags;
+			size_t segment; // Index into m_segments, or SIZE_MAX
+			size_t firstSection, sectionCount; // Range of m_intervalSections
+		};
+
+		struct Descriptor
+		{
+			uint64_t start, end, dataEnd;
+			uint32_t flags;
+			bool operator==(const Descriptor& other) const
+			{
+				return (start == other.start) && (end == other.end) && (dataEnd == other.dataEnd) &&
+					(flags == other.flags);
+			}
+		};
+
+		Ref<BinaryView> m_view;
+		std::vector<Ref<Segment>> m_segments;
+		std::vector<Ref<Section>> m_sections;
+		std::vector<Descriptor> m_segmentDescriptors, m_sectionDescriptors;
+		std::vector<Interval> m_intervals;
+		std::vector<size_t> m_intervalSections;
+		uint64_t m_pageBase;
+		std::vector<uint16_t> m_pages;
+		uint16_t m_outsideFlags; // Flags for addresses outside the page table
+
+		void Rebuild();
+		const Interval* GetInterval(uint64_t addr) const;
+		uint16_t GetIntervalFlags(uint64_t addr) const;
+
+	public:
+		static constexpr size_t PageShift = 12;
+		static constexpr size_t MaxPageCount = 0x400000;
+
+		SegmentMap(BinaryView* view);
+
+		/*! Rebuilds the snapshot if the segments or sections of the view changed. Returns true if it did. */
+		bool Update();
+
+		uint16_t GetFlags(uint64_t addr) const
+		{
+			uint64_t page = (addr - m_pageBase) >> PageShift;
+			uint16_t flags = (page < m_pages.size()) ? m_pages[(size_t)page] : m_outsideFlags;
+			if (flags & SegmentMapMixedPage)
+				return GetIntervalFlags(addr);
+			return flags;
+		}
+
+		void GetFlags(const uint64_t* addrs, size_t count, uint16_t* flags) const;
+
+		bool IsOffsetReadable(uint64_t addr) const { return (GetFlags(addr) & SegmentMapReadable) != 0; }
+		bool IsOffsetWritable(uint64_t addr) const { return (GetFlags(addr) & SegmentMapWritable) != 0; }
+		bool IsOffsetExecutable(uint64_t addr) const { return (GetFlags(addr) & SegmentMapExecutable) != 0; }
+		bool IsOffsetBackedByFile(uint64_t addr) const
+		{
+			return (GetFlags(addr) & SegmentMapBackedByFile) != 0;
+		}
+		bool IsOffsetCodeSemantics(uint64_t addr) const
+		{
+			return (GetFlags(addr) & SegmentMapCodeSemantics) != 0;
+		}
+		bool IsOffsetWritableSemantics(uint64_t addr) const
+		{
+			return (GetFlags(addr) & SegmentMapWritableSemantics) != 0;
+		}
+		bool IsOffsetExternSemantics(uint64_t addr) const
+		{
+			return (GetFlags(addr) & SegmentMapExternSemantics) != 0;
+		}
+		bool IsPointerToCode(uint64_t addr) const { return (GetFlags(addr) & SegmentMapPointerToCode) != 0; }
+
+		/*! Copies the values that point to code to out, keeping their order. Returns the number copied. out
+			may be the same array as values. */
+		size_t FilterPointersToCode(const uint64_t* values, size_t count, uint64_t* out) const;
+
+		Ref<Segment> GetSegmentAt(uint64_t addr) const;
+		std::vector<Ref<Section>> GetSectionsAt(uint64_t addr) const;
+	};
+
 	class Platform;
 
 	class BinaryViewType: public StaticCoreRefCountObject<BNBinaryViewType>
@@ -1626,22 +2630,115 @@ namespace BinaryNinja
 		virtual const char* what() const NOEXCEPT { return "read out of bounds"; }
 	};
 
+	template <typename T> bool BinaryView::TryReadAt(uint64_t offset, T& value, BNEndianness endian) const
+	{
+		static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+			"positional value reads require an integer, floating point or enumeration type");
+		uint8_t data[sizeof(T)];
+		if (!ReadAt(offset, data, sizeof(T)))
+			return false;
+		if (endian == BigEndian)
+		{
+			for (size_t i = 0; i < (sizeof(T) / 2); i++)
+				std::swap(data[i], data[sizeof(T) - 1 - i]);
+		}
+		memcpy(&value, data, sizeof(T));
+		return true;
+	}
+
+	template <typename T> T BinaryView::ReadAt(uint64_t offset, BNEndianness endian) const
+	{
+		T value;
+		if (!TryReadAt(offset, value, endian))
+			throw ReadException();
+		return value;
+	}
+
+	/*! BinaryReader reads sequentially from a BinaryView. By default every read is a call into the core. After
+		EnableBuffering, reads are served from a window of the view's contents that is refilled on demand, and
+		the reader tracks its own position. The window is discarded whenever the view's data is written,
+		inserted or removed. A failed read in buffered mode leaves the position unchanged.
+	 */
 	class BinaryReader
 	{
+		class BufferInvalidator;
+
 		Ref<BinaryView> m_view;
 		BNBinaryReader* m_stream;
+		BNEndianness m_endian;
+		bool m_latchErrors, m_errorLatched;
+
+		bool m_buffered;
+		uint64_t m_offset;
+		std::vector<uint8_t> m_window;
+		uint64_t m_windowStart;
+		size_t m_windowLength;
+		uint64_t m_windowGeneration;
+		std::unique_ptr<BufferInvalidator> m_invalidator;
+
+		bool ReadBuffered(void* dest, size_t len);
+		template <typename T> bool ReadBufferedValue(T& result, BNEndianness endian);
+		bool TryReadArrayElements(void* dest, size_t count, size_t elementSize);
+		void ReadFailed();
+		bool CheckLatch(bool success)
+		{
+			if (!success && m_latchErrors)
+				m_errorLatched = true;
+			return success;
+		}
 
 	public:
+		static constexpr size_t DefaultBufferSize = 0x10000;
+
 		BinaryReader(BinaryView* data, BNEndianness endian = LittleEndian);
 		~BinaryReader();
 
 		BNEndianness GetEndianness() const;
 		void SetEndianness(BNEndianness endian);
 
+		void EnableBuffering(size_t windowSize = DefaultBufferSize);
+		void DisableBuffering();
+		bool IsBuffered() const { return m_buffered; }
+
+		/*! In error latch mode a failed read returns zero instead of throwing ReadException, and every read after
+			it fails immediately without touching the view. Check HasError once the whole structure is parsed.
+			Enabling or disabling the latch clears any latched error.
+		 */
+		void SetErrorLatch(bool enabled);
+		bool IsErrorLatchEnabled() const { return m_latchErrors; }
+		bool HasError() const { return m_errorLatched; }
+		void ClearError() { m_errorLatched = false; }
+
 		void Read(void* dest, size_t len);
 		DataBuffer Read(size_t len);
 		template <typename T> T Read();
 		template <typename T> std::vector<T> ReadVector(size_t count);
+
+		/*! Reads count integer or floating point values in the reader's endianness with a single read. Byte
+			swapping, when needed, is done over the whole array at once.
+		 */
+		template <typename T> bool TryReadInto(T* dest, size_t count)
+		{
+			static_assert(std::is_arithmetic<T>::value && (sizeof(T) <= 8),
+				"array reads require an integer or floating point type of at most 8 bytes");
+			return TryReadArrayElements(dest, count, sizeof(T));
+		}
+		template <typename T> bool TryReadInto(std::vector<T>& dest) { return TryReadInto(dest.data(), dest.size()); }
+		template <typename T> void ReadInto(T* dest, size_t count)
+		{
+			if (!TryReadInto(dest, count))
+			{
+				ReadFailed();
+				memset(dest, 0, count * sizeof(T));
+			}
+		}
+		template <typename T> void ReadInto(std::vector<T>& dest) { ReadInto(dest.data(), dest.size()); }
+		template <typename T> std::vector<T> ReadArray(size_t count)
+		{
+			std::vector<T> result(count);
+			ReadInto(result.data(), count);
+			return result;
+		}
 		std::string ReadString(size_t len);
 		std::string ReadCString(size_t maxLength=-1);
 
@@ -1684,10 +2781,33 @@ namespace BinaryNinja
 		virtual const char* what() const NOEXCEPT { return "write out of bounds"; }
 	};
 
+	/*! BinaryWriter writes sequentially to a BinaryView. Between BeginTransaction and CommitTransaction writes
+		are collected instead of being applied, with adjacent and overlapping writes merged (later writes win).
+		The commit applies each merged range with one write, so the view sends one OnBinaryDataWritten per
+		range, and groups them into a single undo action. AbortTransaction discards the pending writes and
+		returns to the position the transaction began at. Reads from the view do not see pending writes.
+		Destroying the writer with a transaction open discards it.
+	 */
 	class BinaryWriter
 	{
 		Ref<BinaryView> m_view;
 		BNBinaryWriter* m_stream;
+		BNEndianness m_endian;
+		bool m_latchErrors, m_errorLatched;
+
+		bool m_inTransaction;
+		uint64_t m_offset, m_transactionStart;
+		std::map<uint64_t, std::vector<uint8_t>> m_pendingWrites;
+
+		void AddPendingWrite(const void* src, size_t len);
+		template <typename T> bool AddPendingValue(T val, BNEndianness endian);
+		void WriteFailed();
+		bool CheckLatch(bool success)
+		{
+			if (!success && m_latchErrors)
+				m_errorLatched = true;
+			return success;
+		}
 
 	public:
 		BinaryWriter(BinaryView* data, BNEndianness endian = LittleEndian);
@@ -1696,8 +2816,24 @@ namespace BinaryNinja
 		BNEndianness GetEndianness() const;
 		void SetEndianness(BNEndianness endian);
 
+		/*! In error latch mode a failed write is ignored instead of throwing WriteException, and every write after
+			it is skipped. Check HasError once all writes are issued. Enabling or disabling the latch clears any
+			latched error.
+		 */
+		void SetErrorLatch(bool enabled);
+		bool IsErrorLatchEnabled() const { return m_latchErrors; }
+		bool HasError() const { return m_errorLatched; }
+		void ClearError() { m_errorLatched = false; }
+
+		void BeginTransaction();
+		bool CommitTransaction();
+		void AbortTransaction();
+		bool IsInTransaction() const { return m_inTransaction; }
+		size_t GetPendingRangeCount() const { return m_pendingWrites.size(); }
+
 		void Write(const void* src, size_t len);
 		void Write(const DataBuffer& buf);
+		void Write(const DataBufferView& buf);
 		void Write(const std::string& str);
 		void Write8(uint8_t val);
 		void Write16(uint16_t val);
@@ -1712,6 +2848,7 @@ namespace BinaryNinja
 
 		bool TryWrite(const void* src, size_t len);
 		bool TryWrite(const DataBuffer& buf);
+		bool TryWrite(const DataBufferView& buf);
 		bool TryWrite(const std::string& str);
 		bool TryWrite8(uint8_t val);
 		bool TryWrite16(uint16_t val);
@@ -1729,6 +2866,180 @@ namespace BinaryNinja
 		void SeekRelative(int64_t offset);
 	};
 
+	enum StructFieldEndianness
+	{
+		StructDefaultEndian, // Endianness of the reader, writer, or view the layout is used with
+		StructLittleEndian,
+		StructBigEndian
+	};
+
+	/*! Describes an integer or enumeration member of T that is stored in Width bytes at Offset from the start
+		of the structure. Values narrower than the member are zero or sign extended to the member's type.
+	 */
+	template <typename T, typename FieldType, FieldType T::*Member, uint64_t Offset, size_t Width = sizeof(FieldType),
+		StructFieldEndianness Endian = StructDefaultEndian>
+	struct StructField
+	{
+		static_assert(std::is_integral<FieldType>::value || std::is_enum<FieldType>::value,
+			"StructField requires an integer or enumeration member");
+		static_assert((Width > 0) && (Width <= 8), "StructField width must be between 1 and 8 bytes");
+		static_assert(Width <= sizeof(FieldType), "StructField width must not exceed the size of the member");
+
+		typedef typename std::conditional<std::is_enum<FieldType>::value, std::underlying_type<FieldType>,
+			std::enable_if<true, FieldType>>::type::type IntegerType;
+
+		static constexpr uint64_t End = Offset + Width;
+
+		static bool IsBigEndian(BNEndianness endian)
+		{
+			return (Endian == StructBigEndian) || ((Endian == StructDefaultEndian) && (endian == BigEndian));
+		}
+
+		static void Decode(T& out, const uint8_t* data, BNEndianness endian)
+		{
+			bool big = IsBigEndian(endian);
+			uint64_t value = 0;
+			for (size_t i = 0; i < Width; i++)
+				value |= (uint64_t)data[Offset + i] << (big ? ((Width - 1 - i) * 8) : (i * 8));
+			if (std::is_signed<IntegerType>::value)
+			{
+				uint64_t signBit = (uint64_t)1 << ((Width * 8) - 1);
+				value = (value ^ signBit) - signBit;
+			}
+			out.*Member = (FieldType)(IntegerType)value;
+		}
+
+		static void Encode(const T& in, uint8_t* data, BNEndianness endian)
+		{
+			bool big = IsBigEndian(endian);
+			uint64_t value = (uint64_t)(IntegerType)(in.*Member);
+			for (size_t i = 0; i < Width; i++)
+				data[Offset + i] = (uint8_t)(value >> (big ? ((Width - 1 - i) * 8) : (i * 8)));
+		}
+	};
+
+	/*! Describes a fixed size byte or character array member of T stored at Offset, such as a section name. */
+	template <typename T, typename ElementType, size_t Count, ElementType (T::*Member)[Count], uint64_t Offset>
+	struct StructBytesField
+	{
+		static_assert(sizeof(ElementType) == 1, "StructBytesField requires an array of bytes or characters");
+
+		static constexpr uint64_t End = Offset + Count;
+
+		static void Decode(T& out, const uint8_t* data, BNEndianness)
+		{
+			memcpy(out.*Member, data + Offset, Count);
+		}
+
+		static void Encode(const T& in, uint8_t* data, BNEndianness)
+		{
+			memcpy(data + Offset, in.*Member, Count);
+		}
+	};
+
+	template <typename... Fields> struct StructFieldsEnd;
+	template <> struct StructFieldsEnd<>
+	{
+		static constexpr uint64_t Value = 0;
+	};
+	template <typename Field, typename... Rest> struct StructFieldsEnd<Field, Rest...>
+	{
+		static constexpr uint64_t Value =
+			(Field::End > StructFieldsEnd<Rest...>::Value) ? Field::End : StructFieldsEnd<Rest...>::Value;
+	};
+
+	/*! Reads and writes a structure described by a list of StructField and StructBytesField descriptors.
+		The whole structure is transferred with a single read or write of Size bytes, and the fields are
+		decoded from or encoded into that buffer by code generated for the layout, for example:
+
+		\code{.cpp}
+		struct SectionHeader { char name[8]; uint32_t virtualSize, virtualAddress; };
+		typedef StructLayout<SectionHeader,
+			StructBytesField<SectionHeader, char, 8, &SectionHeader::name, 0>,
+			StructField<SectionHeader, uint32_t, &SectionHeader::virtualSize, 8>,
+			StructField<SectionHeader, uint32_t, &SectionHeader::virtualAddress, 12>> SectionHeaderLayout;
+
+		SectionHeader header;
+		if (SectionHeaderLayout::TryRead(reader, header))
+			...
+		\endcode
+
+		Bytes of the structure that are not covered by a field are skipped when reading. TryWrite and Write
+		store them as zero; use TryUpdate to rewrite a structure in place without touching them.
+	 */
+	template <typename T, typename... Fields>
+	struct StructLayout
+	{
+		static constexpr size_t Size = (size_t)StructFieldsEnd<Fields...>::Value;
+		static_assert(Size > 0, "StructLayout requires at least one field");
+
+		static void Decode(T& out, const uint8_t* data, BNEndianness endian = LittleEndian)
+		{
+			int expand[] = {0, (Fields::Decode(out, data, endian), 0)...};
+			(void)expand;
+		}
+
+		static void Encode(const T& in, uint8_t* data, BNEndianness endian = LittleEndian)
+		{
+			int expand[] = {0, (Fields::Encode(in, data, endian), 0)...};
+			(void)expand;
+		}
+
+		static bool TryRead(BinaryReader& reader, T& out)
+		{
+			uint8_t data[Size];
+			if (!reader.TryRead(data, Size))
+				return false;
+			Decode(out, data, reader.GetEndianness());
+			return true;
+		}
+
+		static bool TryRead(BinaryView* view, uint64_t offset, T& out, BNEndianness endian)
+		{
+			uint8_t data[Size];
+			if (view->Read(data, offset, Size) != Size)
+				return false;
+			Decode(out, data, endian);
+			return true;
+		}
+
+		static T Read(BinaryReader& reader)
+		{
+			uint8_t data[Size] = {};
+			reader.Read(data, Size);
+			T result = T();
+			Decode(result, data, reader.GetEndianness());
+			return result;
+		}
+
+		// Bytes not covered by a field are written as zero
+		static bool TryWrite(BinaryWriter& writer, const T& in)
+		{
+			uint8_t data[Size] = {};
+			Encode(in, data, writer.GetEndianness());
+			return writer.TryWrite(data, Size);
+		}
+
+		// Bytes not covered by a field are written as zero
+		static void Write(BinaryWriter& writer, const T& in)
+		{
+			uint8_t data[Size] = {};
+			Encode(in, data, writer.GetEndianness());
+			writer.Write(data, Size);
+		}
+
+		// Reads the structure at offset and writes it back with the fields replaced, so reserved and padding
+		// bytes keep their contents
+		static bool TryUpdate(BinaryView* view, uint64_t offset, const T& in, BNEndianness endian)
+		{
+			uint8_t data[Size];
+			if (view->Read(data, offset, Size) != Size)
+				return false;
+			Encode(in, data, endian);
+			return view->Write(offset, data, Size) == Size;
+		}
+	};
+
 	struct TransformParameter
 	{
 		std::string name, longName;
@@ -1769,6 +3080,12 @@ namespace BinaryNinja
 		                    std::map<std::string, DataBuffer>());
 		virtual bool Encode(const DataBuffer& input, DataBuffer& output, const std::map<std::string, DataBuffer>& params =
 		                    std::map<std::string, DataBuffer>());
+
+		// Separately named so that subclasses overriding Decode and Encode do not hide them
+		bool DecodeView(const DataBufferView& input, DataBuffer& output, const std::map<std::string, DataBuffer>& params =
+		                std::map<std::string, DataBuffer>());
+		bool EncodeView(const DataBufferView& input, DataBuffer& output, const std::map<std::string, DataBuffer>& params =
+		                std::map<std::string, DataBuffer>());
 	};
 
 	class CoreTransform: public Transform
@@ -2063,6 +3380,11 @@ namespace BinaryNinja
 	{
 	public:
 		CoreArchitecture(BNArchitecture* arch);
+
+		/*! Returns the shared wrapper for a core architecture. Architectures live for the lifetime of the
+			process, so the wrapper is created once and never freed.
+		 */
+		static Ref<Architecture> Intern(BNArchitecture* arch);
 		virtual BNEndianness GetEndianness() const override;
 		virtual size_t GetAddressSize() const override;
 		virtual size_t GetDefaultIntegerSize() const override;
@@ -2434,6 +3756,10 @@ namespace BinaryNinja
 	{
 	public:
 		BasicBlock(BNBasicBlock* block);
+		virtual ~BasicBlock();
+
+		/*! Returns the shared wrapper for a core basic block, taking ownership of the passed reference. */
+		static Ref<BasicBlock> Intern(BNBasicBlock* block);
 
 		Ref<Function> GetFunction() const;
 		Ref<Architecture> GetArchitecture() const;
@@ -2559,6 +3885,11 @@ namespace BinaryNinja
 		Function(BNFunction* func);
 		virtual ~Function();
 
+		/*! Returns the shared wrapper for a core function, taking ownership of the passed reference.
+			All lookups of the same core function return the same Function object while it is referenced.
+		 */
+		static Ref<Function> Intern(BNFunction* func);
+
 		Ref<BinaryView> GetView() const;
 		Ref<Architecture> GetArchitecture() const;
 		Ref<Platform> GetPlatform() const;
@@ -3904,6 +5235,10 @@ namespace BinaryNinja
 
 	public:
 		Platform(BNPlatform* platform);
+		virtual ~Platform();
+
+		/*! Returns the shared wrapper for a core platform, taking ownership of the passed reference. */
+		static Ref<Platform> Intern(BNPlatform* platform);
 
 		Ref<Architecture> GetArchitecture() const;
 		std::string GetName() const;
@@ -4484,4 +5819,61 @@ namespace BinaryNinja
 			bool hasAutoAnnotations,
 			const std::string& leadingSpaces="  ");
 	};
+
+	struct AnalysisFunctionProfile
+	{
+		Ref<Function> func;
+		double totalTime; // Sum of all phases, in seconds
+		std::map<std::string, double> phases;
+	};
+
+	struct AnalysisPhaseProfile
+	{
+		std::string name;
+		size_t count;
+		double totalTime, minTime, maxTime;
+		std::vector<size_t> histogram; // One count per AnalysisProfiler::GetHistogramBounds entry, then overflow
+	};
+
+	struct AnalysisProfileSample
+	{
+		double time; // Seconds since the profiler was created
+		BNAnalysisProgress progress;
+		std::map<std::string, uint64_t> memoryUsage;
+	};
+
+	/*! Collects analysis performance data for a whole view. Sample records the analysis progress, the
+		memory usage counters of the core and the functions currently being analyzed; Start calls it
+		periodically from a background thread until Stop. CollectFunctionTimings gathers the per-phase
+		timings of every function from Function::GetAnalysisPerformanceInfo, replacing any earlier
+		collection, and is normally called once analysis has finished.
+
+		Reports can be written as JSON, as Prometheus text exposition or as a Chrome trace-event timeline
+		(loadable in chrome://tracing or Perfetto). In the timeline, function spans are bounded by the
+		samples in which the function was seen active, so they are only as precise as the sampling interval.
+	 */
+	class AnalysisProfiler
+	{
+		struct ProfilerState;
+		std::unique_ptr<ProfilerState> m_state;
+
+	public:
+		AnalysisProfiler(BinaryView* view);
+		~AnalysisProfiler();
+
+		void Sample();
+		void Start(uint32_t intervalMs = 100);
+		void Stop();
+		void CollectFunctionTimings(size_t threadCount = 0);
+
+		std::vector<AnalysisProfileSample> GetSamples() const;
+		std::vector<AnalysisFunctionProfile> GetFunctionProfiles() const;
+		std::vector<AnalysisFunctionProfile> GetSlowestFunctions(size_t count, const std::string& phase = "") const;
+		std::vector<AnalysisPhaseProfile> GetPhaseProfiles() const;
+		static const std::vector<double>& GetHistogramBounds();
+
+		std::string ToJson(size_t topCount = 20) const;
+		std::string ToPrometheus(size_t topCount = 20) const;
+		std::string ToChromeTrace() const;
+	};
 }
@@ -18,13 +18,134 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
 #include "binaryninjaapi.h"
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BINARYREADER_SSE2
+#endif
 
 using namespace BinaryNinja;
 using namespace std;
 
 
-BinaryReader::BinaryReader(BinaryView* data, BNEndianness endian): m_view(data)
+// Counts modifications to the view's contents so that a buffered reader can tell when its window is stale.
+// Notifications may be delivered on any thread, so the reader only compares generations.
+class BinaryReader::BufferInvalidator: public BinaryDataNotification
+{
+	Ref<BinaryView> m_view;
+
+public:
+	atomic<uint64_t> generation;
+
+	BufferInvalidator(BinaryView* view): m_view(view), generation(0)
+	{
+		m_view->RegisterNotification(this);
+	}
+
+	virtual ~BufferInvalidator()
+	{
+		m_view->UnregisterNotification(this);
+	}
+
+	virtual void OnBinaryDataWritten(BinaryView*, uint64_t, size_t) override
+	{
+		generation.fetch_add(1, memory_order_release);
+	}
+
+	virtual void OnBinaryDataInserted(BinaryView*, uint64_t, size_t) override
+	{
+		generation.fetch_add(1, memory_order_release);
+	}
+
+	virtual void OnBinaryDataRemoved(BinaryView*, uint64_t, uint64_t) override
+	{
+		generation.fetch_add(1, memory_order_release);
+	}
+};
+
+
+constexpr size_t BinaryReader::DefaultBufferSize;
+
+
+static inline uint16_t SwapBytes(uint16_t value)
+{
+	return (uint16_t)((value >> 8) | (value << 8));
+}
+
+
+static inline uint32_t SwapBytes(uint32_t value)
+{
+	return ((value >> 24) & 0xff) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+}
+
+
+static inline uint64_t SwapBytes(uint64_t value)
+{
+	return ((uint64_t)SwapBytes((uint32_t)value) << 32) | SwapBytes((uint32_t)(value >> 32));
+}
+
+
+// Reverses the bytes of every element in place. SSE2 is part of the x86-64 baseline, so the vector paths need no
+// runtime dispatch; the element byte order is reversed with 16-bit word shuffles followed by a byte rotate.
+template <typename T>
+static void SwapArrayScalar(T* data, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		data[i] = SwapBytes(data[i]);
+}
+
+
+static void SwapArray16(uint16_t* data, size_t count)
+{
+	size_t i = 0;
+#ifdef BINARYREADER_SSE2
+	for (; (i + 8) <= count; i += 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)&data[i]);
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i*)&data[i], v);
+	}
+#endif
+	SwapArrayScalar(data + i, count - i);
+}
+
+
+static void SwapArray32(uint32_t* data, size_t count)
+{
+	size_t i = 0;
+#ifdef BINARYREADER_SSE2
+	for (; (i + 4) <= count; i += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)&data[i]);
+		v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i*)&data[i], v);
+	}
+#endif
+	SwapArrayScalar(data + i, count - i);
+}
+
+
+static void SwapArray64(uint64_t* data, size_t count)
+{
+	size_t i = 0;
+#ifdef BINARYREADER_SSE2
+	for (; (i + 2) <= count; i += 2)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)&data[i]);
+		v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i*)&data[i], v);
+	}
+#endif
+	SwapArrayScalar(data + i, count - i);
+}
+
+
+BinaryReader::BinaryReader(BinaryView* data, BNEndianness endian): m_view(data), m_endian(endian),
+	m_latchErrors(false), m_errorLatched(false), m_buffered(false), m_offset(0), m_windowStart(0), m_windowLength(0),
+	m_windowGeneration(0)
 {
 	m_stream = BNCreateBinaryReader(data->GetObject());
 	BNSetBinaryReaderEndianness(m_stream, endian);
@@ -39,23 +160,123 @@ BinaryReader::~BinaryReader()
 
 BNEndianness BinaryReader::GetEndianness() const
 {
-	return BNGetBinaryReaderEndianness(m_stream);
+	return m_endian;
 }
 
 
 void BinaryReader::SetEndianness(BNEndianness endian)
 {
+	m_endian = endian;
 	BNSetBinaryReaderEndianness(m_stream, endian);
 }
 
 
-void BinaryReader::Read(void* dest, size_t len)
+void BinaryReader::SetErrorLatch(bool enabled)
+{
+	m_latchErrors = enabled;
+	m_errorLatched = false;
+}
+
+
+void BinaryReader::ReadFailed()
 {
-	if (!BNReadData(m_stream, dest, len))
+	if (!m_latchErrors)
 		throw ReadException();
 }
 
 
+void BinaryReader::EnableBuffering(size_t windowSize)
+{
+	if (windowSize == 0)
+		windowSize = DefaultBufferSize;
+	if (!m_buffered)
+	{
+		m_offset = BNGetReaderPosition(m_stream);
+		m_invalidator.reset(new BufferInvalidator(m_view));
+		m_buffered = true;
+	}
+	m_window.resize(windowSize);
+	m_window.shrink_to_fit();
+	m_windowLength = 0;
+}
+
+
+void BinaryReader::DisableBuffering()
+{
+	if (!m_buffered)
+		return;
+	BNSeekBinaryReader(m_stream, m_offset);
+	m_buffered = false;
+	m_invalidator.reset();
+	vector<uint8_t>().swap(m_window);
+	m_windowLength = 0;
+}
+
+
+bool BinaryReader::ReadBuffered(void* dest, size_t len)
+{
+	if (len == 0)
+		return true;
+
+	uint64_t generation = m_invalidator->generation.load(memory_order_acquire);
+	if (generation != m_windowGeneration)
+	{
+		m_windowGeneration = generation;
+		m_windowLength = 0;
+	}
+
+	uint64_t windowOffset = m_offset - m_windowStart;
+	if ((m_offset < m_windowStart) || (windowOffset > m_windowLength) || (len > (m_windowLength - windowOffset)))
+	{
+		// Requests larger than the window go straight to the view
+		if (len > m_window.size())
+		{
+			if (m_view->Read(dest, m_offset, len) != len)
+				return false;
+			m_offset += len;
+			return true;
+		}
+
+		m_windowStart = m_offset;
+		m_windowLength = m_view->Read(m_window.data(), m_offset, m_window.size());
+		windowOffset = 0;
+		if (len > m_windowLength)
+		{
+			// The view may stop a read at a boundary it could have read past, so confirm the failure directly
+			if (m_view->Read(dest, m_offset, len) != len)
+				return false;
+			m_offset += len;
+			return true;
+		}
+	}
+
+	memcpy(dest, &m_window[(size_t)windowOffset], len);
+	m_offset += len;
+	return true;
+}
+
+
+template <typename T>
+bool BinaryReader::ReadBufferedValue(T& result, BNEndianness endian)
+{
+	T value;
+	if (!ReadBuffered(&value, sizeof(T)))
+		return false;
+	result = (endian == BigEndian) ? SwapBytes(value) : value;
+	return true;
+}
+
+
+void BinaryReader::Read(void* dest, size_t len)
+{
+	if (!TryRead(dest, len))
+	{
+		ReadFailed();
+		memset(dest, 0, len);
+	}
+}
+
+
 DataBuffer BinaryReader::Read(size_t len)
 {
 	DataBuffer result(len);
@@ -66,16 +287,21 @@ DataBuffer BinaryReader::Read(size_t len)
 
 string BinaryReader::ReadString(size_t len)
 {
-	DataBuffer result = Read(len);
-	return string((const char*)result.GetData(), len);
+	string result(len, '\0');
+	if (len != 0)
+		Read(&result[0], len);
+	return result;
 }
 
 
 uint8_t BinaryReader::Read8()
 {
 	uint8_t result;
-	if (!BNRead8(m_stream, &result))
-		throw ReadException();
+	if (!TryRead8(result))
+	{
+		ReadFailed();
+		return 0;
+	}
 	return result;
 }
 
@@ -83,8 +309,11 @@ uint8_t BinaryReader::Read8()
 uint16_t BinaryReader::Read16()
 {
 	uint16_t result;
-	if (!BNRead16(m_stream, &result))
-		throw ReadException();
+	if (!TryRead16(result))
+	{
+		ReadFailed();
+		return 0;
+	}
 	return result;
 }
 
@@ -92,8 +321,11 @@ uint16_t BinaryReader::Read16()
 uint32_t BinaryReader::Read32()
 {
 	uint32_t result;
-	if (!BNRead32(m_stream, &result))
-		throw ReadException();
+	if (!TryRead32(result))
+	{
+		ReadFailed();
+		return 0;
+	}
 	return result;
 }
 
@@ -101,8 +333,11 @@ uint32_t BinaryReader::Read32()
 uint64_t BinaryReader::Read64()
 {
 	uint64_t result;
-	if (!BNRead64(m_stream, &result))
-		throw ReadException();
+	if (!TryRead64(result))
+	{
+		ReadFailed();
+		return 0;
+	}
 	return result;
 }
 
@@ -110,8 +345,11 @@ uint64_t BinaryReader::Read64()
 uint16_t BinaryReader::ReadLE16()
 {
 	uint16_t result;
-	if (!BNReadLE16(m_stream, &result))
-		throw ReadException();
+	if (!TryReadLE16(result))
+	{
+		ReadFailed();
+		return 0;
+	}
 	return result;
 }
 
@@ -119,8 +357,11 @@ uint16_t BinaryReader::ReadLE16()
 uint32_t BinaryReader::ReadLE32()
 {
 	uint32_t result;
-	if (!BNReadLE32(m_stream, &result))
-		throw ReadException();
+	if (!TryReadLE32(result))
+	{
+		ReadFailed();
+		return 0;
+	}
 	return result;
 }
 
@@ -128,8 +369,11 @@ uint32_t BinaryReader::ReadLE32()
 uint64_t BinaryReader::ReadLE64()
 {
 	uint64_t result;
-	if (!BNReadLE64(m_stream, &result))
-		throw ReadException();
+	if (!TryReadLE64(result))
+	{
+		ReadFailed();
+		return 0;
+	}
 	return result;
 }
 
@@ -137,8 +381,11 @@ uint64_t BinaryReader::ReadLE64()
 uint16_t BinaryReader::ReadBE16()
 {
 	uint16_t result;
-	if (!BNReadBE16(m_stream, &result))
-		throw ReadException();
+	if (!TryReadBE16(result))
+	{
+		ReadFailed();
+		return 0;
+	}
 	return result;
 }
 
@@ -146,8 +393,11 @@ uint16_t BinaryReader::ReadBE16()
 uint32_t BinaryReader::ReadBE32()
 {
 	uint32_t result;
-	if (!BNReadBE32(m_stream, &result))
-		throw ReadException();
+	if (!TryReadBE32(result))
+	{
+		ReadFailed();
+		return 0;
+	}
 	return result;
 }
 
@@ -155,15 +405,22 @@ uint32_t BinaryReader::ReadBE32()
 uint64_t BinaryReader::ReadBE64()
 {
 	uint64_t result;
-	if (!BNReadBE64(m_stream, &result))
-		throw ReadException();
+	if (!TryReadBE64(result))
+	{
+		ReadFailed();
+		return 0;
+	}
 	return result;
 }
 
 
 bool BinaryReader::TryRead(void* dest, size_t len)
 {
-	return BNReadData(m_stream, dest, len);
+	if (m_errorLatched)
+		return false;
+	if (m_buffered)
+		return CheckLatch(ReadBuffered(dest, len));
+	return CheckLatch(BNReadData(m_stream, dest, len));
 }
 
 
@@ -176,94 +433,172 @@ bool BinaryReader::TryRead(DataBuffer& dest, size_t len)
 
 bool BinaryReader::TryReadString(string& dest, size_t len)
 {
-	DataBuffer result(len);
-	if (!TryRead(result.GetData(), len))
+	string result(len, '\0');
+	if ((len != 0) && !TryRead(&result[0], len))
 		return false;
-	dest = string((const char*)result.GetData(), len);
+	dest.swap(result);
 	return true;
 }
 
 
 bool BinaryReader::TryRead8(uint8_t& result)
 {
-	return BNRead8(m_stream, &result);
+	if (m_errorLatched)
+		return false;
+	if (m_buffered)
+		return CheckLatch(ReadBuffered(&result, 1));
+	return CheckLatch(BNRead8(m_stream, &result));
 }
 
 
 bool BinaryReader::TryRead16(uint16_t& result)
 {
-	return BNRead16(m_stream, &result);
+	if (m_errorLatched)
+		return false;
+	if (m_buffered)
+		return CheckLatch(ReadBufferedValue(result, m_endian));
+	return CheckLatch(BNRead16(m_stream, &result));
 }
 
 
 bool BinaryReader::TryRead32(uint32_t& result)
 {
-	return BNRead32(m_stream, &result);
+	if (m_errorLatched)
+		return false;
+	if (m_buffered)
+		return CheckLatch(ReadBufferedValue(result, m_endian));
+	return CheckLatch(BNRead32(m_stream, &result));
 }
 
 
 bool BinaryReader::TryRead64(uint64_t& result)
 {
-	return BNRead64(m_stream, &result);
+	if (m_errorLatched)
+		return false;
+	if (m_buffered)
+		return CheckLatch(ReadBufferedValue(result, m_endian));
+	return CheckLatch(BNRead64(m_stream, &result));
 }
 
 
 bool BinaryReader::TryReadLE16(uint16_t& result)
 {
-	return BNReadLE16(m_stream, &result);
+	if (m_errorLatched)
+		return false;
+	if (m_buffered)
+		return CheckLatch(ReadBufferedValue(result, LittleEndian));
+	return CheckLatch(BNReadLE16(m_stream, &result));
 }
 
 
 bool BinaryReader::TryReadLE32(uint32_t& result)
 {
-	return BNReadLE32(m_stream, &result);
+	if (m_errorLatched)
+		return false;
+	if (m_buffered)
+		return CheckLatch(ReadBufferedValue(result, LittleEndian));
+	return CheckLatch(BNReadLE32(m_stream, &result));
 }
 
 
 bool BinaryReader::TryReadLE64(uint64_t& result)
 {
-	return BNReadLE64(m_stream, &result);
+	if (m_errorLatched)
+		return false;
+	if (m_buffered)
+		return CheckLatch(ReadBufferedValue(result, LittleEndian));
+	return CheckLatch(BNReadLE64(m_stream, &result));
 }
 
 
 bool BinaryReader::TryReadBE16(uint16_t& result)
 {
-	return BNReadBE16(m_stream, &result);
+	if (m_errorLatched)
+		return false;
+	if (m_buffered)
+		return CheckLatch(ReadBufferedValue(result, BigEndian));
+	return CheckLatch(BNReadBE16(m_stream, &result));
 }
 
 
 bool BinaryReader::TryReadBE32(uint32_t& result)
 {
-	return BNReadBE32(m_stream, &result);
+	if (m_errorLatched)
+		return false;
+	if (m_buffered)
+		return CheckLatch(ReadBufferedValue(result, BigEndian));
+	return CheckLatch(BNReadBE32(m_stream, &result));
 }
 
 
 bool BinaryReader::TryReadBE64(uint64_t& result)
 {
-	return BNReadBE64(m_stream, &result);
+	if (m_errorLatched)
+		return false;
+	if (m_buffered)
+		return CheckLatch(ReadBufferedValue(result, BigEndian));
+	return CheckLatch(BNReadBE64(m_stream, &result));
+}
+
+
+bool BinaryReader::TryReadArrayElements(void* dest, size_t count, size_t elementSize)
+{
+	if (count > (SIZE_MAX / elementSize))
+		return CheckLatch(false);
+	if (!TryRead(dest, count * elementSize))
+		return false;
+
+	if (m_endian == BigEndian)
+	{
+		switch (elementSize)
+		{
+		case 2:
+			SwapArray16((uint16_t*)dest, count);
+			break;
+		case 4:
+			SwapArray32((uint32_t*)dest, count);
+			break;
+		case 8:
+			SwapArray64((uint64_t*)dest, count);
+			break;
+		default:
+			break;
+		}
+	}
+	return true;
 }
 
 
 uint64_t BinaryReader::GetOffset() const
 {
+	if (m_buffered)
+		return m_offset;
 	return BNGetReaderPosition(m_stream);
 }
 
 
 void BinaryReader::Seek(uint64_t offset)
 {
-	BNSeekBinaryReader(m_stream, offset);
+	if (m_buffered)
+		m_offset = offset;
+	else
+		BNSeekBinaryReader(m_stream, offset);
 }
 
 
 void BinaryReader::SeekRelative(int64_t offset)
 {
-	BNSeekBinaryReaderRelative(m_stream, offset);
+	if (m_buffered)
+		m_offset += offset;
+	else
+		BNSeekBinaryReaderRelative(m_stream, offset);
 }
 
 
 bool BinaryReader::IsEndOfFile() const
 {
+	if (m_buffered)
+		BNSeekBinaryReader(m_stream, m_offset);
 	return BNIsEndOfFile(m_stream);
 }
 
@@ -288,18 +623,16 @@ vector<T> BinaryReader::ReadVector(size_t count)
 
 string BinaryReader::ReadCString(size_t maxSize)
 {
+	// Running into unreadable data ends the string but is not an error
+	bool errorLatched = m_errorLatched;
 	string result;
-	try
+	for (size_t i = 0; i < maxSize; i++)
 	{
-		for (size_t i = 0; i < maxSize; i++)
-		{
-			char cur = Read8();
-			if (cur == 0)
-				break;
-			result.push_back(cur);
-		}
+		uint8_t cur;
+		if (!TryRead8(cur) || (cur == 0))
+			break;
+		result.push_back((char)cur);
 	}
-	catch (ReadException& r)
-	{;}
+	m_errorLatched = errorLatched;
 	return result;
 }
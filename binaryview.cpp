@@ -55,7 +55,7 @@ void BinaryDataNotification::FunctionAddedCallback(void* ctxt, BNBinaryView* obj
 {
 	BinaryDataNotification* notify = (BinaryDataNotification*)ctxt;
 	Ref<BinaryView> view = new BinaryView(BNNewViewReference(object));
-	Ref<Function> funcObj = new Function(BNNewFunctionReference(func));
+	Ref<Function> funcObj = Function::Intern(BNNewFunctionReference(func));
 	notify->OnAnalysisFunctionAdded(view, funcObj);
 }
 
@@ -64,7 +64,7 @@ void BinaryDataNotification::FunctionRemovedCallback(void* ctxt, BNBinaryView* o
 {
 	BinaryDataNotification* notify = (BinaryDataNotification*)ctxt;
 	Ref<BinaryView> view = new BinaryView(BNNewViewReference(object));
-	Ref<Function> funcObj = new Function(BNNewFunctionReference(func));
+	Ref<Function> funcObj = Function::Intern(BNNewFunctionReference(func));
 	notify->OnAnalysisFunctionRemoved(view, funcObj);
 }
 
@@ -73,7 +73,7 @@ void BinaryDataNotification::FunctionUpdatedCallback(void* ctxt, BNBinaryView* o
 {
 	BinaryDataNotification* notify = (BinaryDataNotification*)ctxt;
 	Ref<BinaryView> view = new BinaryView(BNNewViewReference(object));
-	Ref<Function> funcObj = new Function(BNNewFunctionReference(func));
+	Ref<Function> funcObj = Function::Intern(BNNewFunctionReference(func));
 	notify->OnAnalysisFunctionUpdated(view, funcObj);
 }
 
@@ -82,7 +82,7 @@ void BinaryDataNotification::FunctionUpdateRequestedCallback(void* ctxt, BNBinar
 {
 	BinaryDataNotification* notify = (BinaryDataNotification*)ctxt;
 	Ref<BinaryView> view = new BinaryView(BNNewViewReference(object));
-	Ref<Function> funcObj = new Function(BNNewFunctionReference(func));
+	Ref<Function> funcObj = Function::Intern(BNNewFunctionReference(func));
 	notify->OnAnalysisFunctionUpdateRequested(view, funcObj);
 }
 
@@ -891,12 +891,24 @@ size_t BinaryView::WriteBuffer(uint64_t offset, const DataBuffer& data)
 }
 
 
+size_t BinaryView::WriteBuffer(uint64_t offset, const DataBufferView& data)
+{
+	return BNWriteViewData(m_object, offset, data.GetData(), data.GetLength());
+}
+
+
 size_t BinaryView::InsertBuffer(uint64_t offset, const DataBuffer& data)
 {
 	return BNInsertViewBuffer(m_object, offset, data.GetBufferObject());
 }
 
 
+size_t BinaryView::InsertBuffer(uint64_t offset, const DataBufferView& data)
+{
+	return BNInsertViewData(m_object, offset, data.GetData(), data.GetLength());
+}
+
+
 vector<float> BinaryView::GetEntropy(uint64_t offset, size_t len, size_t blockSize)
 {
 	if (!blockSize)
@@ -1000,6 +1012,13 @@ size_t BinaryView::Read(void* dest, uint64_t offset, size_t len)
 }
 
 
+bool BinaryView::ReadAt(uint64_t offset, void* dest, size_t len) const
+{
+	// The core read path is safe for concurrent use, so this is just a single call with no wrapper state
+	return BNReadViewData(m_object, dest, offset, len) == len;
+}
+
+
 size_t BinaryView::Write(uint64_t offset, const void* data, size_t len)
 {
 	return BNWriteViewData(m_object, offset, data, len);
@@ -1101,7 +1120,7 @@ Ref<Architecture> BinaryView::GetDefaultArchitecture() const
 	BNArchitecture* arch = BNGetDefaultArchitecture(m_object);
 	if (!arch)
 		return nullptr;
-	return new CoreArchitecture(arch);
+	return CoreArchitecture::Intern(arch);
 }
 
 
@@ -1119,7 +1138,7 @@ Ref<Platform> BinaryView::GetDefaultPlatform() const
 	BNPlatform* platform = BNGetDefaultPlatform(m_object);
 	if (!platform)
 		return nullptr;
-	return new Platform(platform);
+	return Platform::Intern(platform);
 }
 
 
@@ -1288,7 +1307,7 @@ vector<Ref<Function>> BinaryView::GetAnalysisFunctionList()
 	vector<Ref<Function>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Function(BNNewFunctionReference(list[i])));
+		result.emplace_back(Function::Intern(BNNewFunctionReference(list[i])));
 
 	BNFreeFunctionList(list, count);
 
@@ -1304,7 +1323,7 @@ AnalysisInfo BinaryView::GetAnalysisInfo()
 	result.analysisTime = info->analysisTime;
 	result.activeInfo.reserve(info->count);
 	for (size_t i = 0; i < info->count; i++)
-		result.activeInfo.emplace_back(new Function(BNNewFunctionReference(info->activeInfo[i].func)),
+		result.activeInfo.emplace_back(Function::Intern(BNNewFunctionReference(info->activeInfo[i].func)),
 			info->activeInfo[i].analysisTime, info->activeInfo[i].submitCount, info->activeInfo[i].updateCount);
 	BNFreeAnalysisInfo(info);
 	return result;
@@ -1322,7 +1341,7 @@ Ref<Function> BinaryView::GetAnalysisFunction(Platform* platform, uint64_t addr)
 	BNFunction* func = BNGetAnalysisFunction(m_object, platform->GetObject(), addr);
 	if (!func)
 		return nullptr;
-	return new Function(func);
+	return Function::Intern(func);
 }
 
 
@@ -1331,7 +1350,7 @@ Ref<Function> BinaryView::GetRecentAnalysisFunctionForAddress(uint64_t addr)
 	BNFunction* func = BNGetRecentAnalysisFunctionForAddress(m_object, addr);
 	if (!func)
 		return nullptr;
-	return new Function(func);
+	return Function::Intern(func);
 }
 
 
@@ -1343,7 +1362,7 @@ vector<Ref<Function>> BinaryView::GetAnalysisFunctionsForAddress(uint64_t addr)
 	vector<Ref<Function>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Function(BNNewFunctionReference(list[i])));
+		result.emplace_back(Function::Intern(BNNewFunctionReference(list[i])));
 
 	BNFreeFunctionList(list, count);
 	return result;
@@ -1355,7 +1374,7 @@ Ref<Function> BinaryView::GetAnalysisEntryPoint()
 	BNFunction* func = BNGetAnalysisEntryPoint(m_object);
 	if (!func)
 		return nullptr;
-	return new Function(func);
+	return Function::Intern(func);
 }
 
 
@@ -1364,7 +1383,7 @@ Ref<BasicBlock> BinaryView::GetRecentBasicBlockForAddress(uint64_t addr)
 	BNBasicBlock* block = BNGetRecentBasicBlockForAddress(m_object, addr);
 	if (!block)
 		return nullptr;
-	return new BasicBlock(block);
+	return BasicBlock::Intern(block);
 }
 
 
@@ -1376,7 +1395,7 @@ vector<Ref<BasicBlock>> BinaryView::GetBasicBlocksForAddress(uint64_t addr)
 	vector<Ref<BasicBlock>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.emplace_back(BasicBlock::Intern(BNNewBasicBlockReference(blocks[i])));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -1391,7 +1410,7 @@ vector<Ref<BasicBlock>> BinaryView::GetBasicBlocksStartingAtAddress(uint64_t add
 	vector<Ref<BasicBlock>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.emplace_back(BasicBlock::Intern(BNNewBasicBlockReference(blocks[i])));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -1408,10 +1427,10 @@ vector<ReferenceSource> BinaryView::GetCodeReferences(uint64_t addr)
 	for (size_t i = 0; i < count; i++)
 	{
 		ReferenceSource src;
-		src.func = new Function(BNNewFunctionReference(refs[i].func));
-		src.arch = new CoreArchitecture(refs[i].arch);
+		src.func = Function::Intern(BNNewFunctionReference(refs[i].func));
+		src.arch = CoreArchitecture::Intern(refs[i].arch);
 		src.addr = refs[i].addr;
-		result.push_back(src);
+		result.push_back(std::move(src));
 	}
 
 	BNFreeCodeReferences(refs, count);
@@ -1429,10 +1448,10 @@ vector<ReferenceSource> BinaryView::GetCodeReferences(uint64_t addr, uint64_t le
 	for (size_t i = 0; i < count; i++)
 	{
 		ReferenceSource src;
-		src.func = new Function(BNNewFunctionReference(refs[i].func));
-		src.arch = new CoreArchitecture(refs[i].arch);
+		src.func = Function::Intern(BNNewFunctionReference(refs[i].func));
+		src.arch = CoreArchitecture::Intern(refs[i].arch);
 		src.addr = refs[i].addr;
-		result.push_back(src);
+		result.push_back(std::move(src));
 	}
 
 	BNFreeCodeReferences(refs, count);
@@ -1480,6 +1499,120 @@ vector<uint64_t> BinaryView::GetDataReferencesFrom(uint64_t addr, uint64_t len)
 }
 
 
+#define BATCHED_REFERENCE_CHUNK_SIZE 1024
+
+// Runs query over chunks of the address list and joins the per chunk results into one table. The query
+// appends the references for each address in its chunk and records how many it added for each.
+template <typename T>
+static ReferenceTable<T> QueryReferencesBatched(const vector<uint64_t>& addrs, size_t threadCount,
+	const function<void(const uint64_t* addrs, size_t count, size_t* counts, vector<T>& refs)>& query)
+{
+	struct Chunk
+	{
+		vector<size_t> counts;
+		vector<T> refs;
+	};
+
+	size_t chunkCount = (addrs.size() + BATCHED_REFERENCE_CHUNK_SIZE - 1) / BATCHED_REFERENCE_CHUNK_SIZE;
+	vector<Chunk> chunks(chunkCount);
+	WorkerParallelFor(chunkCount, [&](size_t i) {
+			size_t start = i * BATCHED_REFERENCE_CHUNK_SIZE;
+			size_t count = min((size_t)BATCHED_REFERENCE_CHUNK_SIZE, addrs.size() - start);
+			chunks[i].counts.resize(count);
+			query(&addrs[start], count, chunks[i].counts.data(), chunks[i].refs);
+		}, threadCount);
+
+	ReferenceTable<T> result;
+	size_t total = 0;
+	for (auto& i : chunks)
+		total += i.refs.size();
+	result.offsets.reserve(addrs.size() + 1);
+	result.refs.reserve(total);
+
+	result.offsets.push_back(0);
+	for (auto& i : chunks)
+	{
+		for (size_t count : i.counts)
+			result.offsets.push_back(result.offsets.back() + count);
+		move(i.refs.begin(), i.refs.end(), back_inserter(result.refs));
+	}
+	return result;
+}
+
+
+ReferenceTable<ReferenceSource> BinaryView::GetCodeReferences(const vector<uint64_t>& addrs, size_t threadCount)
+{
+	return QueryReferencesBatched<ReferenceSource>(addrs, threadCount,
+		[&](const uint64_t* chunk, size_t count, size_t* counts, vector<ReferenceSource>& result) {
+			// References from one address list tend to come from the same few functions, so reuse the
+			// wrappers from the previous reference instead of looking each one up again
+			BNFunction* lastFunc = nullptr;
+			BNArchitecture* lastArch = nullptr;
+			Ref<Function> func;
+			Ref<Architecture> arch;
+
+			for (size_t i = 0; i < count; i++)
+			{
+				size_t refCount;
+				BNReferenceSource* refs = BNGetCodeReferences(m_object, chunk[i], &refCount);
+				for (size_t j = 0; j < refCount; j++)
+				{
+					if (refs[j].func != lastFunc)
+					{
+						func = Function::Intern(BNNewFunctionReference(refs[j].func));
+						lastFunc = refs[j].func;
+					}
+					if (refs[j].arch != lastArch)
+					{
+						arch = CoreArchitecture::Intern(refs[j].arch);
+						lastArch = refs[j].arch;
+					}
+
+					ReferenceSource src;
+					src.func = func;
+					src.arch = arch;
+					src.addr = refs[j].addr;
+					result.push_back(std::move(src));
+				}
+				BNFreeCodeReferences(refs, refCount);
+				counts[i] = refCount;
+			}
+		});
+}
+
+
+ReferenceTable<uint64_t> BinaryView::GetDataReferences(const vector<uint64_t>& addrs, size_t threadCount)
+{
+	return QueryReferencesBatched<uint64_t>(addrs, threadCount,
+		[&](const uint64_t* chunk, size_t count, size_t* counts, vector<uint64_t>& result) {
+			for (size_t i = 0; i < count; i++)
+			{
+				size_t refCount;
+				uint64_t* refs = BNGetDataReferences(m_object, chunk[i], &refCount);
+				result.insert(result.end(), refs, &refs[refCount]);
+				BNFreeDataReferences(refs);
+				counts[i] = refCount;
+			}
+		});
+}
+
+
+ReferenceTable<uint64_t> BinaryView::GetDataReferencesFrom(const vector<uint64_t>& addrs, size_t threadCount)
+{
+	return QueryReferencesBatched<uint64_t>(addrs, threadCount,
+		[&](const uint64_t* chunk, size_t count, size_t* counts, vector<uint64_t>& result) {
+			for (size_t i = 0; i < count; i++)
+			{
+				size_t refCount;
+				uint64_t* refs = BNGetDataReferencesFrom(m_object, chunk[i], &refCount);
+				result.insert(result.end(), refs, &refs[refCount]);
+				BNFreeDataReferences(refs);
+				counts[i] = refCount;
+			}
+		});
+}
+
+
 Ref<Symbol> BinaryView::GetSymbolByAddress(uint64_t addr, const NameSpace& nameSpace)
 {
 	BNNameSpace ns = nameSpace.GetAPIObject();
@@ -1512,7 +1645,7 @@ vector<Ref<Symbol>> BinaryView::GetSymbolsByName(const string& name, const NameS
 	vector<Ref<Symbol>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Symbol(BNNewSymbolReference(syms[i])));
+		result.emplace_back(new Symbol(BNNewSymbolReference(syms[i])));
 
 	BNFreeSymbolList(syms, count);
 	return result;
@@ -1529,7 +1662,7 @@ vector<Ref<Symbol>> BinaryView::GetSymbols(const NameSpace& nameSpace)
 	vector<Ref<Symbol>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Symbol(BNNewSymbolReference(syms[i])));
+		result.emplace_back(new Symbol(BNNewSymbolReference(syms[i])));
 
 	BNFreeSymbolList(syms, count);
 	return result;
@@ -1546,7 +1679,7 @@ vector<Ref<Symbol>> BinaryView::GetSymbols(uint64_t start, uint64_t len, const N
 	vector<Ref<Symbol>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Symbol(BNNewSymbolReference(syms[i])));
+		result.emplace_back(new Symbol(BNNewSymbolReference(syms[i])));
 
 	BNFreeSymbolList(syms, count);
 	return result;
@@ -1563,7 +1696,7 @@ vector<Ref<Symbol>> BinaryView::GetSymbolsOfType(BNSymbolType type, const NameSp
 	vector<Ref<Symbol>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Symbol(BNNewSymbolReference(syms[i])));
+		result.emplace_back(new Symbol(BNNewSymbolReference(syms[i])));
 
 	BNFreeSymbolList(syms, count);
 	return result;
@@ -1580,7 +1713,7 @@ vector<Ref<Symbol>> BinaryView::GetSymbolsOfType(BNSymbolType type, uint64_t sta
 	vector<Ref<Symbol>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Symbol(BNNewSymbolReference(syms[i])));
+		result.emplace_back(new Symbol(BNNewSymbolReference(syms[i])));
 
 	BNFreeSymbolList(syms, count);
 	return result;
@@ -1590,6 +1723,7 @@ vector<Ref<Symbol>> BinaryView::GetSymbolsOfType(BNSymbolType type, uint64_t sta
 void BinaryView::DefineAutoSymbol(Ref<Symbol> sym)
 {
 	BNDefineAutoSymbol(m_object, sym->GetObject());
+	SymbolIndex::NotifySymbolChanged(m_object, sym);
 }
 
 
@@ -1597,30 +1731,35 @@ void BinaryView::DefineAutoSymbolAndVariableOrFunction(Ref<Platform> platform, R
 {
 	BNDefineAutoSymbolAndVariableOrFunction(m_object, platform ? platform->GetObject() : nullptr, sym->GetObject(),
 		type ? type->GetObject() : nullptr);
+	SymbolIndex::NotifySymbolChanged(m_object, sym);
 }
 
 
 void BinaryView::UndefineAutoSymbol(Ref<Symbol> sym)
 {
 	BNUndefineAutoSymbol(m_object, sym->GetObject());
+	SymbolIndex::NotifySymbolChanged(m_object, sym);
 }
 
 
 void BinaryView::DefineUserSymbol(Ref<Symbol> sym)
 {
 	BNDefineUserSymbol(m_object, sym->GetObject());
+	SymbolIndex::NotifySymbolChanged(m_object, sym);
 }
 
 
 void BinaryView::UndefineUserSymbol(Ref<Symbol> sym)
 {
 	BNUndefineUserSymbol(m_object, sym->GetObject());
+	SymbolIndex::NotifySymbolChanged(m_object, sym);
 }
 
 
 void BinaryView::DefineImportedFunction(Ref<Symbol> importAddressSym, Ref<Function> func)
 {
 	BNDefineImportedFunction(m_object, importAddressSym->GetObject(), func->GetObject());
+	SymbolIndex::NotifySymbolChanged(m_object, importAddressSym, func);
 }
 
 
@@ -1792,8 +1931,8 @@ LinearDisassemblyPosition BinaryView::GetLinearDisassemblyPositionForAddress(uin
 		settings ? settings->GetObject() : nullptr);
 
 	LinearDisassemblyPosition result;
-	result.function = pos.function ? new Function(pos.function) : nullptr;
-	result.block = pos.block ? new BasicBlock(pos.block) : nullptr;
+	result.function = Function::Intern(pos.function);
+	result.block = BasicBlock::Intern(pos.block);
 	result.address = pos.address;
 	return result;
 }
@@ -1817,18 +1956,18 @@ vector<LinearDisassemblyLine> BinaryView::GetPreviousLinearDisassemblyLines(Line
 	{
 		LinearDisassemblyLine line;
 		line.type = lines[i].type;
-		line.function = lines[i].function ? new Function(BNNewFunctionReference(lines[i].function)) : nullptr;
-		line.block = lines[i].block ? new BasicBlock(BNNewBasicBlockReference(lines[i].block)) : nullptr;
+		line.function = lines[i].function ? Function::Intern(BNNewFunctionReference(lines[i].function)) : nullptr;
+		line.block = lines[i].block ? BasicBlock::Intern(BNNewBasicBlockReference(lines[i].block)) : nullptr;
 		line.lineOffset = lines[i].lineOffset;
 		line.contents.addr = lines[i].contents.addr;
 		line.contents.instrIndex = lines[i].contents.instrIndex;
 		line.contents.highlight = lines[i].contents.highlight;
 		line.contents.tokens = InstructionTextToken::ConvertInstructionTextTokenList(lines[i].contents.tokens, lines[i].contents.count);
-		result.push_back(line);
+		result.push_back(std::move(line));
 	}
 
-	pos.function = linearPos.function ? new Function(linearPos.function) : nullptr;
-	pos.block = linearPos.block ? new BasicBlock(linearPos.block) : nullptr;
+	pos.function = Function::Intern(linearPos.function);
+	pos.block = BasicBlock::Intern(linearPos.block);
 	pos.address = linearPos.address;
 
 	BNFreeLinearDisassemblyLines(lines, count);
@@ -1854,18 +1993,18 @@ vector<LinearDisassemblyLine> BinaryView::GetNextLinearDisassemblyLines(LinearDi
 	{
 		LinearDisassemblyLine line;
 		line.type = lines[i].type;
-		line.function = lines[i].function ? new Function(BNNewFunctionReference(lines[i].function)) : nullptr;
-		line.block = lines[i].block ? new BasicBlock(BNNewBasicBlockReference(lines[i].block)) : nullptr;
+		line.function = lines[i].function ? Function::Intern(BNNewFunctionReference(lines[i].function)) : nullptr;
+		line.block = lines[i].block ? BasicBlock::Intern(BNNewBasicBlockReference(lines[i].block)) : nullptr;
 		line.lineOffset = lines[i].lineOffset;
 		line.contents.addr = lines[i].contents.addr;
 		line.contents.instrIndex = lines[i].contents.instrIndex;
 		line.contents.highlight = lines[i].contents.highlight;
 		line.contents.tokens = InstructionTextToken::ConvertInstructionTextTokenList(lines[i].contents.tokens, lines[i].contents.count);
-		result.push_back(line);
+		result.push_back(std::move(line));
 	}
 
-	pos.function = linearPos.function ? new Function(linearPos.function) : nullptr;
-	pos.block = linearPos.block ? new BasicBlock(linearPos.block) : nullptr;
+	pos.function = Function::Intern(linearPos.function);
+	pos.block = BasicBlock::Intern(linearPos.block);
 	pos.address = linearPos.address;
 
 	BNFreeLinearDisassemblyLines(lines, count);
@@ -2186,7 +2325,7 @@ vector<Ref<Segment>> BinaryView::GetSegments()
 	vector<Ref<Segment>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Segment(BNNewSegmentReference(segments[i])));
+		result.emplace_back(new Segment(BNNewSegmentReference(segments[i])));
 
 	BNFreeSegmentList(segments, count);
 	return result;
@@ -2247,7 +2386,7 @@ vector<Ref<Section>> BinaryView::GetSections()
 	vector<Ref<Section>> result;
     result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Section(BNNewSectionReference(sections[i])));
+		result.emplace_back(new Section(BNNewSectionReference(sections[i])));
 
 	BNFreeSectionList(sections, count);
 	return result;
@@ -2263,7 +2402,7 @@ vector<Ref<Section>> BinaryView::GetSectionsAt(uint64_t addr)
     result.reserve(count);
 	for (size_t i = 0; i < count; i++)
 	{
-		result.push_back(new Section(BNNewSectionReference(sections[i])));
+		result.emplace_back(new Section(BNNewSectionReference(sections[i])));
 	}
 
 	BNFreeSectionList(sections, count);
@@ -2450,7 +2589,7 @@ BNRelocationInfo Relocation::GetInfo() const
 
 Architecture* Relocation::GetArchitecture() const
 {
-	return new CoreArchitecture(BNRelocationGetArchitecture(m_object));
+	return CoreArchitecture::Intern(BNRelocationGetArchitecture(m_object)).GetPtr();
 }
 
 
@@ -87,7 +87,7 @@ vector<Ref<BinaryViewType>> BinaryViewType::GetViewTypes()
 	vector<Ref<BinaryViewType>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new CoreBinaryViewType(types[i]));
+		result.emplace_back(new CoreBinaryViewType(types[i]));
 
 	BNFreeBinaryViewTypeList(types);
 	return result;
@@ -103,7 +103,7 @@ vector<Ref<BinaryViewType>> BinaryViewType::GetViewTypesForData(BinaryView* data
 	vector<Ref<BinaryViewType>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new CoreBinaryViewType(types[i]));
+		result.emplace_back(new CoreBinaryViewType(types[i]));
 
 	BNFreeBinaryViewTypeList(types);
 	return result;
@@ -130,7 +130,7 @@ Ref<Architecture> BinaryViewType::GetArchitecture(uint32_t id, BNEndianness endi
 	BNArchitecture* arch = BNGetArchitectureForViewType(m_object, id, endian);
 	if (!arch)
 		return nullptr;
-	return new CoreArchitecture(arch);
+	return CoreArchitecture::Intern(arch);
 }
 
 
@@ -169,7 +169,7 @@ Ref<Platform> BinaryViewType::GetPlatform(uint32_t id, Architecture* arch)
 	BNPlatform* platform = BNGetPlatformForViewType(m_object, id, arch->GetObject());
 	if (!platform)
 		return nullptr;
-	return new Platform(platform);
+	return Platform::Intern(platform);
 }
 
 
@@ -18,13 +18,15 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
 using namespace std;
 
 
-BinaryWriter::BinaryWriter(BinaryView* data, BNEndianness endian): m_view(data)
+BinaryWriter::BinaryWriter(BinaryView* data, BNEndianness endian): m_view(data), m_endian(endian),
+	m_latchErrors(false), m_errorLatched(false), m_inTransaction(false), m_offset(0), m_transactionStart(0)
 {
 	m_stream = BNCreateBinaryWriter(data->GetObject());
 	BNSetBinaryWriterEndianness(m_stream, endian);
@@ -39,29 +41,166 @@ BinaryWriter::~BinaryWriter()
 
 BNEndianness BinaryWriter::GetEndianness() const
 {
-	return BNGetBinaryWriterEndianness(m_stream);
+	return m_endian;
 }
 
 
 void BinaryWriter::SetEndianness(BNEndianness endian)
 {
+	m_endian = endian;
 	BNSetBinaryWriterEndianness(m_stream, endian);
 }
 
 
-void BinaryWriter::Write(const void* src, size_t len)
+void BinaryWriter::BeginTransaction()
+{
+	if (m_inTransaction)
+		return;
+	m_offset = BNGetWriterPosition(m_stream);
+	m_transactionStart = m_offset;
+	m_inTransaction = true;
+}
+
+
+bool BinaryWriter::CommitTransaction()
+{
+	if (!m_inTransaction)
+		return true;
+
+	bool success = true;
+	if (!m_pendingWrites.empty())
+	{
+		m_view->BeginUndoActions();
+		for (auto& i : m_pendingWrites)
+		{
+			if (m_view->Write(i.first, i.second.data(), i.second.size()) != i.second.size())
+				success = false;
+		}
+		m_view->CommitUndoActions();
+	}
+
+	BNSeekBinaryWriter(m_stream, m_offset);
+	m_pendingWrites.clear();
+	m_inTransaction = false;
+	return CheckLatch(success);
+}
+
+
+void BinaryWriter::AbortTransaction()
+{
+	if (!m_inTransaction)
+		return;
+	BNSeekBinaryWriter(m_stream, m_transactionStart);
+	m_pendingWrites.clear();
+	m_inTransaction = false;
+}
+
+
+void BinaryWriter::AddPendingWrite(const void* src, size_t len)
+{
+	if (len == 0)
+		return;
+
+	uint64_t start = m_offset;
+	uint64_t end = m_offset + len;
+
+	// Find the first pending range that overlaps or touches the new one
+	auto first = m_pendingWrites.upper_bound(start);
+	if (first != m_pendingWrites.begin())
+	{
+		auto prev = first;
+		--prev;
+		if ((prev->first + prev->second.size()) >= start)
+			first = prev;
+	}
+
+	auto last = first;
+	while ((last != m_pendingWrites.end()) && (last->first <= end))
+	{
+		end = max(end, last->first + last->second.size());
+		++last;
+	}
+
+	if ((first != m_pendingWrites.end()) && (first->first <= start))
+	{
+		// Extend the range that already covers the start of this write, which keeps sequential writes linear
+		vector<uint8_t>& data = first->second;
+		uint64_t rangeStart = first->first;
+		auto i = first;
+		for (++i; i != last; ++i)
+		{
+			size_t pos = (size_t)(i->first - rangeStart);
+			if (data.size() < (pos + i->second.size()))
+				data.resize(pos + i->second.size());
+			memcpy(&data[pos], i->second.data(), i->second.size());
+		}
+		if (data.size() < (size_t)(end - rangeStart))
+			data.resize((size_t)(end - rangeStart));
+		memcpy(&data[(size_t)(start - rangeStart)], src, len);
+		auto next = first;
+		m_pendingWrites.erase(++next, last);
+	}
+	else
+	{
+		vector<uint8_t> data((size_t)(end - start));
+		for (auto i = first; i != last; ++i)
+			memcpy(&data[(size_t)(i->first - start)], i->second.data(), i->second.size());
+		memcpy(data.data(), src, len);
+		m_pendingWrites.erase(first, last);
+		m_pendingWrites[start] = move(data);
+	}
+
+	m_offset += len;
+}
+
+
+template <typename T>
+bool BinaryWriter::AddPendingValue(T val, BNEndianness endian)
+{
+	uint8_t bytes[sizeof(T)];
+	for (size_t i = 0; i < sizeof(T); i++)
+	{
+		size_t shift = (endian == BigEndian) ? ((sizeof(T) - 1 - i) * 8) : (i * 8);
+		bytes[i] = (uint8_t)(val >> shift);
+	}
+	AddPendingWrite(bytes, sizeof(T));
+	return true;
+}
+
+
+void BinaryWriter::SetErrorLatch(bool enabled)
+{
+	m_latchErrors = enabled;
+	m_errorLatched = false;
+}
+
+
+void BinaryWriter::WriteFailed()
 {
-	if (!BNWriteData(m_stream, src, len))
+	if (!m_latchErrors)
 		throw WriteException();
 }
 
 
+void BinaryWriter::Write(const void* src, size_t len)
+{
+	if (!TryWrite(src, len))
+		WriteFailed();
+}
+
+
 void BinaryWriter::Write(const DataBuffer& buf)
 {
 	Write(buf.GetData(), buf.GetLength());
 }
 
 
+void BinaryWriter::Write(const DataBufferView& buf)
+{
+	Write(buf.GetData(), buf.GetLength());
+}
+
+
 void BinaryWriter::Write(const string& str)
 {
 	Write(str.c_str(), str.size());
@@ -70,77 +209,84 @@ void BinaryWriter::Write(const string& str)
 
 void BinaryWriter::Write8(uint8_t val)
 {
-	if (!BNWrite8(m_stream, val))
-		throw WriteException();
+	if (!TryWrite8(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::Write16(uint16_t val)
 {
-	if (!BNWrite16(m_stream, val))
-		throw WriteException();
+	if (!TryWrite16(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::Write32(uint32_t val)
 {
-	if (!BNWrite32(m_stream, val))
-		throw WriteException();
+	if (!TryWrite32(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::Write64(uint64_t val)
 {
-	if (!BNWrite64(m_stream, val))
-		throw WriteException();
+	if (!TryWrite64(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteLE16(uint16_t val)
 {
-	if (!BNWriteLE16(m_stream, val))
-		throw WriteException();
+	if (!TryWriteLE16(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteLE32(uint32_t val)
 {
-	if (!BNWriteLE32(m_stream, val))
-		throw WriteException();
+	if (!TryWriteLE32(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteLE64(uint64_t val)
 {
-	if (!BNWriteLE64(m_stream, val))
-		throw WriteException();
+	if (!TryWriteLE64(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteBE16(uint16_t val)
 {
-	if (!BNWriteBE16(m_stream, val))
-		throw WriteException();
+	if (!TryWriteBE16(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteBE32(uint32_t val)
 {
-	if (!BNWriteBE32(m_stream, val))
-		throw WriteException();
+	if (!TryWriteBE32(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteBE64(uint64_t val)
 {
-	if (!BNWriteBE64(m_stream, val))
-		throw WriteException();
+	if (!TryWriteBE64(val))
+		WriteFailed();
 }
 
 
 bool BinaryWriter::TryWrite(const void* src, size_t len)
 {
-	return BNWriteData(m_stream, src, len);
+	if (m_errorLatched)
+		return false;
+	if (m_inTransaction)
+	{
+		AddPendingWrite(src, len);
+		return true;
+	}
+	return CheckLatch(BNWriteData(m_stream, src, len));
 }
 
 
@@ -150,6 +296,12 @@ bool BinaryWriter::TryWrite(const DataBuffer& buf)
 }
 
 
+bool BinaryWriter::TryWrite(const DataBufferView& buf)
+{
+	return TryWrite(buf.GetData(), buf.GetLength());
+}
+
+
 bool BinaryWriter::TryWrite(const string& str)
 {
 	return TryWrite(str.c_str(), str.size());
@@ -158,77 +310,128 @@ bool BinaryWriter::TryWrite(const string& str)
 
 bool BinaryWriter::TryWrite8(uint8_t val)
 {
-	return BNWrite8(m_stream, val);
+	if (m_errorLatched)
+		return false;
+	if (m_inTransaction)
+	{
+		AddPendingWrite(&val, 1);
+		return true;
+	}
+	return CheckLatch(BNWrite8(m_stream, val));
 }
 
 
 bool BinaryWriter::TryWrite16(uint16_t val)
 {
-	return BNWrite16(m_stream, val);
+	if (m_errorLatched)
+		return false;
+	if (m_inTransaction)
+		return AddPendingValue(val, m_endian);
+	return CheckLatch(BNWrite16(m_stream, val));
 }
 
 
 bool BinaryWriter::TryWrite32(uint32_t val)
 {
-	return BNWrite32(m_stream, val);
+	if (m_errorLatched)
+		return false;
+	if (m_inTransaction)
+		return AddPendingValue(val, m_endian);
+	return CheckLatch(BNWrite32(m_stream, val));
 }
 
 
 bool BinaryWriter::TryWrite64(uint64_t val)
 {
-	return BNWrite64(m_stream, val);
+	if (m_errorLatched)
+		return false;
+	if (m_inTransaction)
+		return AddPendingValue(val, m_endian);
+	return CheckLatch(BNWrite64(m_stream, val));
 }
 
 
 bool BinaryWriter::TryWriteLE16(uint16_t val)
 {
-	return BNWriteLE16(m_stream, val);
+	if (m_errorLatched)
+		return false;
+	if (m_inTransaction)
+		return AddPendingValue(val, LittleEndian);
+	return CheckLatch(BNWriteLE16(m_stream, val));
 }
 
 
 bool BinaryWriter::TryWriteLE32(uint32_t val)
 {
-	return BNWriteLE32(m_stream, val);
+	if (m_errorLatched)
+		return false;
+	if (m_inTransaction)
+		return AddPendingValue(val, LittleEndian);
+	return CheckLatch(BNWriteLE32(m_stream, val));
 }
 
 
 bool BinaryWriter::TryWriteLE64(uint64_t val)
 {
-	return BNWriteLE64(m_stream, val);
+	if (m_errorLatched)
+		return false;
+	if (m_inTransaction)
+		return AddPendingValue(val, LittleEndian);
+	return CheckLatch(BNWriteLE64(m_stream, val));
 }
 
 
 bool BinaryWriter::TryWriteBE16(uint16_t val)
 {
-	return BNWriteBE16(m_stream, val);
+	if (m_errorLatched)
+		return false;
+	if (m_inTransaction)
+		return AddPendingValue(val, BigEndian);
+	return CheckLatch(BNWriteBE16(m_stream, val));
 }
 
 
 bool BinaryWriter::TryWriteBE32(uint32_t val)
 {
-	return BNWriteBE32(m_stream, val);
+	if (m_errorLatched)
+		return false;
+	if (m_inTransaction)
+		return AddPendingValue(val, BigEndian);
+	return CheckLatch(BNWriteBE32(m_stream, val));
 }
 
 
 bool BinaryWriter::TryWriteBE64(uint64_t val)
 {
-	return BNWriteBE64(m_stream, val);
+	if (m_errorLatched)
+		return false;
+	if (m_inTransaction)
+		return AddPendingValue(val, BigEndian);
+	return CheckLatch(BNWriteBE64(m_stream, val));
 }
 
 
 uint64_t BinaryWriter::GetOffset() const
 {
+	if (m_inTransaction)
+		return m_offset;
 	return BNGetWriterPosition(m_stream);
 }
 
 
 void BinaryWriter::Seek(uint64_t offset)
 {
-	BNSeekBinaryWriter(m_stream, offset);
+	if (m_inTransaction)
+		m_offset = offset;
+	else
+		BNSeekBinaryWriter(m_stream, offset);
 }
 
 
 void BinaryWriter::SeekRelative(int64_t offset)
 {
-	BNSeekBinaryWriterRelative(m_stream, offset);
+	if (m_inTransaction)
+		m_offset += offset;
+	else
+		BNSeekBinaryWriterRelative(m_stream, offset);
 }
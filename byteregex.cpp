@@ -0,0 +1,816 @@
+// Copyright (c) 2015-2019 Vector 35 Inc
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <algorithm>
+#include <bitset>
+#include <unordered_map>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+#define REGEX_MAX_REPEAT     1000
+#define REGEX_MAX_NFA_STATES 0x40000
+#define REGEX_UNKNOWN_STATE  0xffffffff
+
+
+namespace
+{
+	typedef bitset<256> ByteSet;
+
+	struct RegexNode
+	{
+		enum NodeType
+		{
+			EmptyNode,
+			BytesNode,
+			ConcatNode,
+			AlternateNode,
+			RepeatNode
+		};
+
+		NodeType type;
+		ByteSet bytes;
+		vector<unique_ptr<RegexNode>> children;
+		size_t minCount, maxCount; // maxCount of SIZE_MAX is unbounded
+
+		RegexNode(NodeType t): type(t), minCount(0), maxCount(0) {}
+	};
+
+
+	class RegexParser
+	{
+		const string& m_text;
+		size_t m_pos;
+		string m_error;
+
+		bool AtEnd() const { return m_pos >= m_text.size(); }
+		char Peek() const { return m_text[m_pos]; }
+
+		unique_ptr<RegexNode> Fail(const string& error)
+		{
+			if (m_error.empty())
+				m_error = error + " at offset " + to_string(m_pos);
+			return nullptr;
+		}
+
+		static int HexValue(char c)
+		{
+			if ((c >= '0') && (c <= '9'))
+				return c - '0';
+			if ((c >= 'a') && (c <= 'f'))
+				return c - 'a' + 10;
+			if ((c >= 'A') && (c <= 'F'))
+				return c - 'A' + 10;
+			return -1;
+		}
+
+		// Parses the escape after a backslash into a set of bytes. Returns false on an invalid escape.
+		bool ParseEscape(ByteSet& result)
+		{
+			if (AtEnd())
+				return false;
+			char c = m_text[m_pos++];
+			result.reset();
+			switch (c)
+			{
+			case 'x':
+			{
+				if ((m_pos + 2) > m_text.size())
+					return false;
+				int high = HexValue(m_text[m_pos]);
+				int low = HexValue(m_text[m_pos + 1]);
+				if ((high < 0) || (low < 0))
+					return false;
+				m_pos += 2;
+				result.set((size_t)((high << 4) | low));
+				return true;
+			}
+			case 'd':
+			case 'D':
+				for (size_t i = '0'; i <= '9'; i++)
+					result.set(i);
+				if (c == 'D')
+					result.flip();
+				return true;
+			case 'w':
+			case 'W':
+				for (size_t i = 0; i < 256; i++)
+				{
+					if (((i >= 'a') && (i <= 'z')) || ((i >= 'A') && (i <= 'Z')) || ((i >= '0') && (i <= '9')) ||
+						(i == '_'))
+						result.set(i);
+				}
+				if (c == 'W')
+					result.flip();
+				return true;
+			case 's':
+			case 'S':
+				result.set(' ');
+				result.set('\t');
+				result.set('\n');
+				result.set('\v');
+				result.set('\f');
+				result.set('\r');
+				if (c == 'S')
+					result.flip();
+				return true;
+			case 'n':
+				result.set('\n');
+				return true;
+			case 'r':
+				result.set('\r');
+				return true;
+			case 't':
+				result.set('\t');
+				return true;
+			case '0':
+				result.set(0);
+				return true;
+			default:
+				if (isalnum((unsigned char)c))
+					return false;
+				result.set((uint8_t)c);
+				return true;
+			}
+		}
+
+		unique_ptr<RegexNode> ParseClass()
+		{
+			// The opening bracket has been consumed
+			unique_ptr<RegexNode> node(new RegexNode(RegexNode::BytesNode));
+			bool negate = false;
+			if (!AtEnd() && (Peek() == '^'))
+			{
+				negate = true;
+				m_pos++;
+			}
+
+			bool first = true;
+			while (true)
+			{
+				if (AtEnd())
+					return Fail("unterminated character class");
+				if ((Peek() == ']') && !first)
+				{
+					m_pos++;
+					break;
+				}
+				first = false;
+
+				ByteSet item;
+				if (Peek() == '\\')
+				{
+					m_pos++;
+					if (!ParseEscape(item))
+						return Fail("invalid escape");
+				}
+				else
+				{
+					item.set((uint8_t)m_text[m_pos++]);
+				}
+
+				// Ranges are only allowed between single bytes
+				if (((m_pos + 1) < m_text.size()) && (Peek() == '-') && (m_text[m_pos + 1] != ']') && (item.count() == 1))
+				{
+					m_pos++;
+					ByteSet last;
+					if (Peek() == '\\')
+					{
+						m_pos++;
+						if (!ParseEscape(last))
+							return Fail("invalid escape");
+					}
+					else
+					{
+						last.set((uint8_t)m_text[m_pos++]);
+					}
+					if (last.count() != 1)
+						return Fail("invalid range in character class");
+
+					size_t low = 0, high = 0;
+					while (!item[low])
+						low++;
+					while (!last[high])
+						high++;
+					if (low > high)
+						return Fail("invalid range in character class");
+					for (size_t i = low; i <= high; i++)
+						item.set(i);
+				}
+				node->bytes |= item;
+			}
+
+			if (negate)
+				node->bytes.flip();
+			return node;
+		}
+
+		bool ParseCount(size_t& value)
+		{
+			size_t start = m_pos;
+			value = 0;
+			while (!AtEnd() && (Peek() >= '0') && (Peek() <= '9'))
+			{
+				value = (value * 10) + (size_t)(Peek() - '0');
+				if (value > REGEX_MAX_REPEAT)
+					return false;
+				m_pos++;
+			}
+			return m_pos != start;
+		}
+
+		unique_ptr<RegexNode> ParseAtom()
+		{
+			char c = m_text[m_pos++];
+			switch (c)
+			{
+			case '(':
+			{
+				if (((m_pos + 1) < m_text.size()) && (Peek() == '?') && (m_text[m_pos + 1] == ':'))
+					m_pos += 2;
+				unique_ptr<RegexNode> node = ParseAlternation();
+				if (!node)
+					return nullptr;
+				if (AtEnd() || (Peek() != ')'))
+					return Fail("missing )");
+				m_pos++;
+				return node;
+			}
+			case '[':
+				return ParseClass();
+			case '.':
+			{
+				unique_ptr<RegexNode> node(new RegexNode(RegexNode::BytesNode));
+				node->bytes.set();
+				return node;
+			}
+			case '\\':
+			{
+				unique_ptr<RegexNode> node(new RegexNode(RegexNode::BytesNode));
+				if (!ParseEscape(node->bytes))
+					return Fail("invalid escape");
+				return node;
+			}
+			case ')':
+				return Fail("unmatched )");
+			case '*':
+			case '+':
+			case '?':
+			case '{':
+				return Fail("quantifier without an operand");
+			default:
+			{
+				unique_ptr<RegexNode> node(new RegexNode(RegexNode::BytesNode));
+				node->bytes.set((uint8_t)c);
+				return node;
+			}
+			}
+		}
+
+		unique_ptr<RegexNode> ParseRepeat()
+		{
+			unique_ptr<RegexNode> node = ParseAtom();
+			if (!node)
+				return nullptr;
+
+			while (!AtEnd())
+			{
+				size_t minCount, maxCount;
+				char c = Peek();
+				if (c == '*')
+				{
+					minCount = 0;
+					maxCount = SIZE_MAX;
+					m_pos++;
+				}
+				else if (c == '+')
+				{
+					minCount = 1;
+					maxCount = SIZE_MAX;
+					m_pos++;
+				}
+				else if (c == '?')
+				{
+					minCount = 0;
+					maxCount = 1;
+					m_pos++;
+				}
+				else if (c == '{')
+				{
+					m_pos++;
+					if (!ParseCount(minCount))
+						return Fail("invalid repeat count");
+					maxCount = minCount;
+					if (!AtEnd() && (Peek() == ','))
+					{
+						m_pos++;
+						if (!AtEnd() && (Peek() == '}'))
+							maxCount = SIZE_MAX;
+						else if (!ParseCount(maxCount) || (maxCount < minCount))
+							return Fail("invalid repeat count");
+					}
+					if (AtEnd() || (Peek() != '}'))
+						return Fail("missing }");
+					m_pos++;
+				}
+				else
+				{
+					break;
+				}
+
+				if (!AtEnd() && (Peek() == '?'))
+					return Fail("lazy quantifiers are not supported");
+
+				unique_ptr<RegexNode> repeat(new RegexNode(RegexNode::RepeatNode));
+				repeat->minCount = minCount;
+				repeat->maxCount = maxCount;
+				repeat->children.push_back(move(node));
+				node = move(repeat);
+			}
+			return node;
+		}
+
+		unique_ptr<RegexNode> ParseConcat()
+		{
+			unique_ptr<RegexNode> node(new RegexNode(RegexNode::ConcatNode));
+			while (!AtEnd() && (Peek() != '|') && (Peek() != ')'))
+			{
+				unique_ptr<RegexNode> child = ParseRepeat();
+				if (!child)
+					return nullptr;
+				node->children.push_back(move(child));
+			}
+			return node;
+		}
+
+		unique_ptr<RegexNode> ParseAlternation()
+		{
+			unique_ptr<RegexNode> node(new RegexNode(RegexNode::AlternateNode));
+			while (true)
+			{
+				unique_ptr<RegexNode> child = ParseConcat();
+				if (!child)
+					return nullptr;
+				node->children.push_back(move(child));
+				if (AtEnd() || (Peek() != '|'))
+					break;
+				m_pos++;
+			}
+			return node;
+		}
+
+	public:
+		RegexParser(const string& text): m_text(text), m_pos(0) {}
+
+		unique_ptr<RegexNode> Parse()
+		{
+			unique_ptr<RegexNode> node = ParseAlternation();
+			if (node && !AtEnd())
+				return Fail("unmatched )");
+			return node;
+		}
+
+		const string& GetError() const { return m_error; }
+	};
+
+
+	struct NfaState
+	{
+		enum StateType: uint8_t
+		{
+			ByteState,
+			SplitState,
+			MatchState
+		};
+
+		StateType type;
+		uint32_t out, alt;
+		uint32_t set; // Index of the byte set for ByteState
+	};
+
+
+	// Thompson NFA, built back to front: each node is compiled with the state that follows it already known
+	class Nfa
+	{
+		bool m_reverse;
+		bool m_tooLarge;
+
+		uint32_t AddState(NfaState::StateType type, uint32_t out, uint32_t alt, uint32_t set)
+		{
+			if (states.size() >= REGEX_MAX_NFA_STATES)
+			{
+				m_tooLarge = true;
+				return 0;
+			}
+			NfaState state;
+			state.type = type;
+			state.out = out;
+			state.alt = alt;
+			state.set = set;
+			states.push_back(state);
+			return (uint32_t)(states.size() - 1);
+		}
+
+		uint32_t Compile(const RegexNode* node, uint32_t next)
+		{
+			if (m_tooLarge)
+				return 0;
+
+			switch (node->type)
+			{
+			case RegexNode::BytesNode:
+			{
+				auto i = setIndex.find(node->bytes.to_string());
+				uint32_t index;
+				if (i == setIndex.end())
+				{
+					index = (uint32_t)sets.size();
+					sets.push_back(node->bytes);
+					setIndex[node->bytes.to_string()] = index;
+				}
+				else
+				{
+					index = i->second;
+				}
+				return AddState(NfaState::ByteState, next, 0, index);
+			}
+			case RegexNode::ConcatNode:
+			{
+				// A reversed NFA matches the reversed language, so concatenations are compiled in reverse order
+				uint32_t entry = next;
+				size_t count = node->children.size();
+				for (size_t i = 0; i < count; i++)
+					entry = Compile(node->children[m_reverse ? i : (count - 1 - i)].get(), entry);
+				return entry;
+			}
+			case RegexNode::AlternateNode:
+			{
+				uint32_t entry = Compile(node->children.back().get(), next);
+				for (size_t i = node->children.size() - 1; i > 0; i--)
+					entry = AddState(NfaState::SplitState, Compile(node->children[i - 1].get(), next), entry, 0);
+				return entry;
+			}
+			case RegexNode::RepeatNode:
+			{
+				const RegexNode* child = node->children[0].get();
+				uint32_t entry = next;
+				if (node->maxCount == SIZE_MAX)
+				{
+					uint32_t loop = AddState(NfaState::SplitState, 0, next, 0);
+					if (m_tooLarge)
+						return 0;
+					uint32_t body = Compile(child, loop);
+					states[loop].out = body;
+					entry = loop;
+				}
+				else
+				{
+					for (size_t i = node->minCount; i < node->maxCount; i++)
+						entry = AddState(NfaState::SplitState, Compile(child, entry), next, 0);
+				}
+				for (size_t i = 0; i < node->minCount; i++)
+					entry = Compile(child, entry);
+				return entry;
+			}
+			default:
+				return next;
+			}
+		}
+
+	public:
+		vector<NfaState> states;
+		vector<ByteSet> sets;
+		map<string, uint32_t> setIndex;
+		uint32_t start;
+
+		Nfa(): m_reverse(false), m_tooLarge(false), start(0) {}
+
+		bool Build(const RegexNode* root, bool reverse)
+		{
+			m_reverse = reverse;
+			uint32_t match = AddState(NfaState::MatchState, 0, 0, 0);
+			start = Compile(root, match);
+			return !m_tooLarge;
+		}
+	};
+
+
+	// Lazily constructed DFA over an NFA. A DFA state is the set of NFA byte and match states reachable after
+	// the input so far. The unanchored transition also starts a new match before each byte. States are added
+	// on demand, and the whole cache is dropped when it reaches its size limit.
+	class LazyDfa
+	{
+		struct SetHash
+		{
+			size_t operator()(const vector<uint32_t>& set) const
+			{
+				size_t hash = 14695981039346656037ULL;
+				for (uint32_t i : set)
+					hash = (hash ^ i) * 1099511628211ULL;
+				return hash;
+			}
+		};
+
+		const Nfa& m_nfa;
+		const uint8_t* m_classes;
+		size_t m_classCount;
+		size_t m_maxStates;
+
+		vector<vector<uint32_t>> m_sets;
+		vector<bool> m_matching;
+		unordered_map<vector<uint32_t>, uint32_t, SetHash> m_ids;
+		vector<uint32_t> m_anchored, m_unanchored;
+		vector<uint32_t> m_startSet;
+		size_t m_flushCount;
+
+		vector<uint32_t> m_marks;
+		uint32_t m_generation;
+		vector<uint32_t> m_stack, m_targets, m_next;
+
+		void Closure(const vector<uint32_t>& roots, vector<uint32_t>& result)
+		{
+			m_generation++;
+			if (m_generation == 0)
+			{
+				fill(m_marks.begin(), m_marks.end(), 0);
+				m_generation = 1;
+			}
+
+			result.clear();
+			m_stack.assign(roots.rbegin(), roots.rend());
+			while (!m_stack.empty())
+			{
+				uint32_t state = m_stack.back();
+				m_stack.pop_back();
+				if (m_marks[state] == m_generation)
+					continue;
+				m_marks[state] = m_generation;
+
+				const NfaState& s = m_nfa.states[state];
+				if (s.type == NfaState::SplitState)
+				{
+					m_stack.push_back(s.alt);
+					m_stack.push_back(s.out);
+				}
+				else
+				{
+					result.push_back(state);
+				}
+			}
+			sort(result.begin(), result.end());
+		}
+
+		uint32_t AddState(const vector<uint32_t>& set)
+		{
+			auto i = m_ids.find(set);
+			if (i != m_ids.end())
+				return i->second;
+
+			if (m_sets.size() >= m_maxStates)
+			{
+				m_sets.clear();
+				m_matching.clear();
+				m_ids.clear();
+				m_anchored.clear();
+				m_unanchored.clear();
+				m_flushCount++;
+			}
+
+			uint32_t id = (uint32_t)m_sets.size();
+			bool matching = false;
+			for (uint32_t state : set)
+			{
+				if (m_nfa.states[state].type == NfaState::MatchState)
+					matching = true;
+			}
+			m_sets.push_back(set);
+			m_matching.push_back(matching);
+			m_ids[set] = id;
+			m_anchored.resize(m_sets.size() * m_classCount, REGEX_UNKNOWN_STATE);
+			m_unanchored.resize(m_sets.size() * m_classCount, REGEX_UNKNOWN_STATE);
+			return id;
+		}
+
+		uint32_t Compute(uint32_t state, uint8_t value, bool unanchored)
+		{
+			m_targets.clear();
+			const vector<uint32_t>* sources[2] = {&m_sets[state], unanchored ? &m_startSet : nullptr};
+			for (auto source : sources)
+			{
+				if (!source)
+					continue;
+				for (uint32_t i : *source)
+				{
+					const NfaState& s = m_nfa.states[i];
+					if ((s.type == NfaState::ByteState) && m_nfa.sets[s.set][value])
+						m_targets.push_back(s.out);
+				}
+			}
+			Closure(m_targets, m_next);
+
+			// Adding the state may drop the cache, in which case the source state no longer exists
+			size_t flushCount = m_flushCount;
+			uint32_t next = AddState(m_next);
+			if (flushCount == m_flushCount)
+				(unanchored ? m_unanchored : m_anchored)[(state * m_classCount) + m_classes[value]] = next;
+			return next;
+		}
+
+	public:
+		LazyDfa(const Nfa& nfa, const uint8_t* classes, size_t classCount, size_t maxStates): m_nfa(nfa),
+			m_classes(classes), m_classCount(classCount), m_maxStates(max<size_t>(maxStates, 4)),
+			m_flushCount(0), m_marks(nfa.states.size(), 0), m_generation(0)
+		{
+			Closure(vector<uint32_t>(1, nfa.start), m_startSet);
+		}
+
+		uint32_t GetStartState() { return AddState(m_startSet); }
+		uint32_t GetEmptyState() { return AddState(vector<uint32_t>()); }
+		bool IsMatching(uint32_t state) const { return m_matching[state]; }
+		bool IsEmpty(uint32_t state) const { return m_sets[state].empty(); }
+
+		uint32_t Step(uint32_t state, uint8_t value, bool unanchored)
+		{
+			uint32_t next = (unanchored ? m_unanchored : m_anchored)[(state * m_classCount) + m_classes[value]];
+			if (next != REGEX_UNKNOWN_STATE)
+				return next;
+			return Compute(state, value, unanchored);
+		}
+	};
+}
+
+
+struct ByteRegex::Program
+{
+	Nfa forward, reverse;
+	uint8_t classes[256];
+	size_t classCount;
+	size_t maxMatchLength;
+	size_t maxCachedStates;
+};
+
+
+ByteRegex::ByteRegex(const string& pattern, size_t maxMatchLength, size_t maxCachedStates)
+{
+	RegexParser parser(pattern);
+	unique_ptr<RegexNode> root = parser.Parse();
+	if (!root)
+	{
+		m_error = parser.GetError();
+		return;
+	}
+
+	unique_ptr<Program> program(new Program);
+	if (!program->forward.Build(root.get(), false) || !program->reverse.Build(root.get(), true))
+	{
+		m_error = "regular expression is too large";
+		return;
+	}
+
+	// Bytes that no byte set distinguishes share a DFA column, which keeps the transition tables small
+	size_t classCount = 1;
+	for (size_t i = 0; i < 256; i++)
+		program->classes[i] = 0;
+	for (auto& set : program->forward.sets)
+	{
+		map<pair<uint8_t, bool>, uint8_t> split;
+		for (size_t i = 0; i < 256; i++)
+		{
+			pair<uint8_t, bool> key(program->classes[i], set[i]);
+			auto existing = split.find(key);
+			if (existing == split.end())
+				existing = split.insert(make_pair(key, (uint8_t)split.size())).first;
+			program->classes[i] = existing->second;
+		}
+		classCount = split.size();
+	}
+	program->classCount = classCount;
+	program->maxMatchLength = max<size_t>(maxMatchLength, 1);
+	program->maxCachedStates = maxCachedStates;
+	m_program = move(program);
+}
+
+
+ByteRegex::~ByteRegex()
+{
+}
+
+
+size_t ByteRegex::GetMaxMatchLength() const
+{
+	return m_program ? m_program->maxMatchLength : 0;
+}
+
+
+size_t ByteRegex::Scan(const uint8_t* data, size_t len, size_t positions, uint64_t base,
+	vector<Match>& matches) const
+{
+	if (!m_program)
+		return 0;
+
+	const Program& program = *m_program;
+	LazyDfa forward(program.forward, program.classes, program.classCount, program.maxCachedStates);
+	LazyDfa reverse(program.reverse, program.classes, program.classCount, program.maxCachedStates);
+
+	positions = min(positions, len);
+	size_t pos = 0;
+	size_t lastEnd = 0;
+	vector<size_t> starts;
+	while (pos < positions)
+	{
+		// Run forward from pos, starting a new match before each byte until the first match ends. After that no
+		// more matches are started, and the ones already under way are followed until they stop or can no
+		// longer end within the length limit, so every match starting before firstEnd ends by lastMatchEnd.
+		size_t firstEnd = 0;
+		size_t lastMatchEnd = 0;
+		size_t scanEnd = min(len, positions + program.maxMatchLength);
+		uint32_t state = forward.GetEmptyState();
+		for (size_t i = pos; i < scanEnd; i++)
+		{
+			bool unanchored = (i < positions) && (firstEnd == 0);
+			state = forward.Step(state, data[i], unanchored);
+			if (forward.IsMatching(state))
+			{
+				if (firstEnd == 0)
+				{
+					firstEnd = i + 1;
+					scanEnd = min(scanEnd, i + program.maxMatchLength);
+				}
+				lastMatchEnd = i + 1;
+			}
+			if (!unanchored && forward.IsEmpty(state))
+				break;
+		}
+		if (firstEnd == 0)
+			break;
+
+		// Run the reversed expression back from lastMatchEnd, starting a match before each byte, to find every
+		// position before firstEnd where a match starts.
+		starts.clear();
+		state = reverse.GetEmptyState();
+		for (size_t i = lastMatchEnd; i > pos; i--)
+		{
+			state = reverse.Step(state, data[i - 1], true);
+			if ((i <= firstEnd) && reverse.IsMatching(state))
+				starts.push_back(i - 1);
+		}
+
+		// Take the leftmost of those starts that has a match within the length limit, and extend that match
+		// as far as possible. Only starts with nothing but longer matches are passed over.
+		size_t matchStart = 0;
+		size_t matchEnd = 0;
+		for (auto i = starts.rbegin(); (i != starts.rend()) && (*i < positions) && (matchEnd == 0); ++i)
+		{
+			matchStart = *i;
+			size_t forwardLimit = min(len, matchStart + program.maxMatchLength);
+			state = forward.GetStartState();
+			for (size_t j = matchStart; j < forwardLimit; j++)
+			{
+				state = forward.Step(state, data[j], false);
+				if (forward.IsEmpty(state))
+					break;
+				if (forward.IsMatching(state))
+					matchEnd = j + 1;
+			}
+		}
+		if (matchEnd == 0)
+		{
+			// Every match starting before firstEnd is longer than the length limit
+			pos = firstEnd;
+			continue;
+		}
+
+		Match match;
+		match.address = base + matchStart;
+		match.length = matchEnd - matchStart;
+		matches.push_back(match);
+		pos = matchEnd;
+		lastEnd = matchEnd;
+	}
+	return lastEnd;
+}
+
+
+void ByteRegex::Scan(const uint8_t* data, size_t len, uint64_t base, vector<Match>& matches) const
+{
+	Scan(data, len, len, base, matches);
+}
@@ -0,0 +1,250 @@
+// Copyright (c) 2015-2019 Vector 35 Inc
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <list>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+struct CachedBinaryView::PageCache
+{
+	struct Page
+	{
+		uint64_t index;
+		vector<uint8_t> data; // Shorter than a page where the data of the view ends
+	};
+
+	mutex lock;
+	size_t pageSize, pageCount;
+	list<Page> pages; // Most recently used first
+	unordered_map<uint64_t, list<Page>::iterator> lookup;
+	uint64_t generation; // Changed on invalidation, so that reads started before it are not cached
+
+	void Evict()
+	{
+		while (pages.size() > pageCount)
+		{
+			lookup.erase(pages.back().index);
+			pages.pop_back();
+		}
+	}
+
+	void Remove(uint64_t first, uint64_t last)
+	{
+		generation++;
+		if ((last - first) < lookup.size())
+		{
+			for (uint64_t i = first; i <= last; i++)
+			{
+				auto page = lookup.find(i);
+				if (page == lookup.end())
+					continue;
+				pages.erase(page->second);
+				lookup.erase(page);
+			}
+			return;
+		}
+
+		for (auto i = pages.begin(); i != pages.end(); )
+		{
+			if ((i->index >= first) && (i->index <= last))
+			{
+				lookup.erase(i->index);
+				i = pages.erase(i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+};
+
+
+CachedBinaryView::CachedBinaryView(const string& typeName, FileMetadata* file, BinaryView* parentView,
+	size_t pageCount, size_t pageSize): BinaryView(typeName, file, parentView), m_cache(new PageCache),
+	m_cacheHits(0), m_cacheMisses(0)
+{
+	m_cache->pageSize = pageSize ? pageSize : DefaultPageSize;
+	m_cache->pageCount = pageCount;
+	m_cache->generation = 0;
+}
+
+
+CachedBinaryView::~CachedBinaryView()
+{
+}
+
+
+size_t CachedBinaryView::PerformRead(void* dest, uint64_t offset, size_t len)
+{
+	bool enabled;
+	{
+		unique_lock<mutex> lock(m_cache->lock);
+		enabled = m_cache->pageCount != 0;
+	}
+	if (!enabled)
+		return PerformUncachedRead(dest, offset, len);
+
+	uint8_t* out = (uint8_t*)dest;
+	size_t pageSize = m_cache->pageSize;
+	size_t done = 0;
+	while (done < len)
+	{
+		uint64_t addr = offset + done;
+		uint64_t index = addr / pageSize;
+		size_t pageOffset = (size_t)(addr % pageSize);
+		size_t runCount = 1;
+		uint64_t generation;
+		{
+			unique_lock<mutex> lock(m_cache->lock);
+			auto i = m_cache->lookup.find(index);
+			if (i != m_cache->lookup.end())
+			{
+				m_cacheHits++;
+				m_cache->pages.splice(m_cache->pages.begin(), m_cache->pages, i->second);
+				const vector<uint8_t>& data = i->second->data;
+				if (pageOffset >= data.size())
+					return done;
+				size_t count = min(len - done, data.size() - pageOffset);
+				memcpy(&out[done], &data[pageOffset], count);
+				done += count;
+				if ((data.size() < pageSize) && ((pageOffset + count) == data.size()))
+					return done;
+				continue;
+			}
+
+			// Fetch the run of missing pages up to the next cached one in a single read
+			uint64_t lastIndex = (offset + len - 1) / pageSize;
+			while (((index + runCount) <= lastIndex) && (runCount < m_cache->pageCount) &&
+				(m_cache->lookup.find(index + runCount) == m_cache->lookup.end()))
+				runCount++;
+			generation = m_cache->generation;
+		}
+
+		m_cacheMisses += runCount;
+		vector<uint8_t> buffer(runCount * pageSize);
+		size_t read = PerformUncachedRead(buffer.data(), index * pageSize, buffer.size());
+		read = min(read, buffer.size());
+
+		{
+			unique_lock<mutex> lock(m_cache->lock);
+			if (generation == m_cache->generation)
+			{
+				// Reads stop at the first unreadable byte, so nothing is known about pages after a short one
+				for (size_t j = 0; j < runCount; j++)
+				{
+					size_t start = j * pageSize;
+					size_t valid = (read > start) ? min(read - start, pageSize) : 0;
+					if (m_cache->lookup.find(index + j) == m_cache->lookup.end())
+					{
+						PageCache::Page page;
+						page.index = index + j;
+						page.data.assign(buffer.begin() + start, buffer.begin() + start + valid);
+						m_cache->pages.push_front(move(page));
+						m_cache->lookup[index + j] = m_cache->pages.begin();
+					}
+					if (valid < pageSize)
+						break;
+				}
+				m_cache->Evict();
+			}
+		}
+
+		size_t available = (read > pageOffset) ? (read - pageOffset) : 0;
+		size_t count = min(len - done, available);
+		memcpy(&out[done], &buffer[pageOffset], count);
+		done += count;
+		if (read < buffer.size())
+			break;
+	}
+	return done;
+}
+
+
+size_t CachedBinaryView::PerformWrite(uint64_t offset, const void* data, size_t len)
+{
+	size_t result = PerformUncachedWrite(offset, data, len);
+	InvalidateCache(offset, len);
+	return result;
+}
+
+
+size_t CachedBinaryView::PerformInsert(uint64_t offset, const void* data, size_t len)
+{
+	// Everything after an insert or remove moves, so all later pages are dropped
+	size_t result = PerformUncachedInsert(offset, data, len);
+	InvalidateCache(offset, UINT64_MAX - offset);
+	return result;
+}
+
+
+size_t CachedBinaryView::PerformRemove(uint64_t offset, uint64_t len)
+{
+	size_t result = PerformUncachedRemove(offset, len);
+	InvalidateCache(offset, UINT64_MAX - offset);
+	return result;
+}
+
+
+size_t CachedBinaryView::GetCachePageSize() const
+{
+	return m_cache->pageSize;
+}
+
+
+size_t CachedBinaryView::GetCachePageCount() const
+{
+	unique_lock<mutex> lock(m_cache->lock);
+	return m_cache->pageCount;
+}
+
+
+void CachedBinaryView::SetCachePageCount(size_t pageCount)
+{
+	unique_lock<mutex> lock(m_cache->lock);
+	m_cache->pageCount = pageCount;
+	m_cache->Evict();
+}
+
+
+void CachedBinaryView::InvalidateCache(uint64_t offset, uint64_t len)
+{
+	if (len == 0)
+		return;
+	uint64_t last = ((len - 1) > (UINT64_MAX - offset)) ? UINT64_MAX : (offset + len - 1);
+	unique_lock<mutex> lock(m_cache->lock);
+	m_cache->Remove(offset / m_cache->pageSize, last / m_cache->pageSize);
+}
+
+
+void CachedBinaryView::ClearCache()
+{
+	InvalidateCache(0, UINT64_MAX);
+}
+
+
+void CachedBinaryView::ResetCacheStatistics()
+{
+	m_cacheHits = 0;
+	m_cacheMisses = 0;
+}
@@ -190,7 +190,7 @@ void CallingConvention::GetIncomingRegisterValueCallback(void* ctxt, uint32_t re
 	CallingConvention* cc = (CallingConvention*)ctxt;
 	Ref<Function> funcObj;
 	if (func)
-		funcObj = new Function(BNNewFunctionReference(func));
+		funcObj = Function::Intern(BNNewFunctionReference(func));
 	*result = cc->GetIncomingRegisterValue(reg, funcObj).ToAPIObject();
 }
 
@@ -200,7 +200,7 @@ void CallingConvention::GetIncomingFlagValueCallback(void* ctxt, uint32_t reg, B
 	CallingConvention* cc = (CallingConvention*)ctxt;
 	Ref<Function> funcObj;
 	if (func)
-		funcObj = new Function(BNNewFunctionReference(func));
+		funcObj = Function::Intern(BNNewFunctionReference(func));
 	*result = cc->GetIncomingFlagValue(reg, funcObj).ToAPIObject();
 }
 
@@ -211,7 +211,7 @@ void CallingConvention::GetIncomingVariableForParameterVariableCallback(void* ct
 	CallingConvention* cc = (CallingConvention*)ctxt;
 	Ref<Function> funcObj;
 	if (func)
-		funcObj = new Function(BNNewFunctionReference(func));
+		funcObj = Function::Intern(BNNewFunctionReference(func));
 	*result = cc->GetIncomingVariableForParameterVariable(*var, funcObj);
 }
 
@@ -222,14 +222,14 @@ void CallingConvention::GetParameterVariableForIncomingVariableCallback(void* ct
 	CallingConvention* cc = (CallingConvention*)ctxt;
 	Ref<Function> funcObj;
 	if (func)
-		funcObj = new Function(BNNewFunctionReference(func));
+		funcObj = Function::Intern(BNNewFunctionReference(func));
 	*result = cc->GetParameterVariableForIncomingVariable(*var, funcObj);
 }
 
 
 Ref<Architecture> CallingConvention::GetArchitecture() const
 {
-	return new CoreArchitecture(BNGetCallingConventionArchitecture(m_object));
+	return CoreArchitecture::Intern(BNGetCallingConventionArchitecture(m_object));
 }
 
 
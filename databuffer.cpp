@@ -18,50 +18,519 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
 using namespace std;
 
 
-DataBuffer::DataBuffer()
+// Base64 and escape string fast paths. The core implementations remain the reference behavior: encoding is
+// always done here, decoding is done here for canonical padded input and falls back to the core for anything
+// else, and escaping only skips the core when the input contains nothing that could need escaping.
+#if defined(__x86_64__) || defined(_M_X64)
+#define DATABUFFER_X86_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#else
+#include <cpuid.h>
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static const char g_base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Encodes whole 3 byte groups, returning the number of input bytes consumed
+typedef size_t (*Base64EncodeFunction)(const uint8_t* src, size_t len, char* dest);
+
+// Decodes whole 4 character groups, returning the number of characters consumed. Stops early at any character
+// outside the alphabet (including padding). May write up to 8 bytes past the end of the decoded data.
+typedef size_t (*Base64DecodeFunction)(const char* src, size_t len, uint8_t* dest);
+
+// Returns the length of the prefix that needs no escaping
+typedef size_t (*PlainPrefixFunction)(const uint8_t* src, size_t len);
+
+
+static uint8_t Base64Value(char ch)
+{
+	if ((ch >= 'A') && (ch <= 'Z'))
+		return (uint8_t)(ch - 'A');
+	if ((ch >= 'a') && (ch <= 'z'))
+		return (uint8_t)(ch - 'a' + 26);
+	if ((ch >= '0') && (ch <= '9'))
+		return (uint8_t)(ch - '0' + 52);
+	if (ch == '+')
+		return 62;
+	if (ch == '/')
+		return 63;
+	return 0xff;
+}
+
+
+static bool IsPlainCharacter(uint8_t ch)
+{
+	return (ch >= 0x20) && (ch < 0x7f) && (ch != '\\') && (ch != '"') && (ch != '\'');
+}
+
+
+static size_t EncodeBase64Scalar(const uint8_t* src, size_t len, char* dest)
+{
+	size_t i = 0;
+	for (; (i + 3) <= len; i += 3)
+	{
+		uint32_t group = ((uint32_t)src[i] << 16) | ((uint32_t)src[i + 1] << 8) | src[i + 2];
+		*dest++ = g_base64Alphabet[group >> 18];
+		*dest++ = g_base64Alphabet[(group >> 12) & 63];
+		*dest++ = g_base64Alphabet[(group >> 6) & 63];
+		*dest++ = g_base64Alphabet[group & 63];
+	}
+	return i;
+}
+
+
+static size_t DecodeBase64Scalar(const char* src, size_t len, uint8_t* dest)
+{
+	size_t i = 0;
+	for (; (i + 4) <= len; i += 4)
+	{
+		uint8_t a = Base64Value(src[i]);
+		uint8_t b = Base64Value(src[i + 1]);
+		uint8_t c = Base64Value(src[i + 2]);
+		uint8_t d = Base64Value(src[i + 3]);
+		if ((a | b | c | d) & 0x80)
+			break;
+		uint32_t group = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)c << 6) | d;
+		*dest++ = (uint8_t)(group >> 16);
+		*dest++ = (uint8_t)(group >> 8);
+		*dest++ = (uint8_t)group;
+	}
+	return i;
+}
+
+
+static size_t GetPlainPrefixScalar(const uint8_t* src, size_t len)
+{
+	size_t i = 0;
+	while ((i < len) && IsPlainCharacter(src[i]))
+		i++;
+	return i;
+}
+
+
+#ifdef DATABUFFER_X86_SIMD
+enum SimdLevel
+{
+	SimdNone,
+	SimdSSSE3,
+	SimdAVX2
+};
+
+
+static SimdLevel DetectSimdLevel()
+{
+	int regs[4] = {0, 0, 0, 0};
+#ifdef _MSC_VER
+	__cpuid(regs, 0);
+	int maxLeaf = regs[0];
+	__cpuid(regs, 1);
+#else
+	int maxLeaf = (int)__get_cpuid_max(0, nullptr);
+	__cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	if ((regs[2] & (1 << 9)) == 0)
+		return SimdNone;
+
+	// AVX2 needs the instruction set and the OS saving YMM state on context switches
+	if (((regs[2] & (1 << 27)) == 0) || ((regs[2] & (1 << 28)) == 0) || (maxLeaf < 7))
+		return SimdSSSE3;
+#ifdef _MSC_VER
+	uint64_t xcr0 = _xgetbv(0);
+	__cpuidex(regs, 7, 0);
+#else
+	uint32_t xcr0Low, xcr0High;
+	__asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+	uint64_t xcr0 = ((uint64_t)xcr0High << 32) | xcr0Low;
+	__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	if (((xcr0 & 6) != 6) || ((regs[1] & (1 << 5)) == 0))
+		return SimdSSSE3;
+	return SimdAVX2;
+}
+
+
+// Each 32-bit lane of the input holds one 3 byte group s0 s1 s2 arranged as the bytes (s1, s0, s2, s1), so the
+// low half word is s0:s1 and the high half word is s1:s2. The four 6-bit fields are then moved into the four
+// bytes of the lane with one multiply per pair. The result is mapped to ASCII by adding a per-range offset.
+TARGET_SSSE3 static inline __m128i EncodeBase64LanesSSSE3(__m128i in)
+{
+	in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+	__m128i high = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+	__m128i low = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+	__m128i values = _mm_or_si128(high, low);
+
+	__m128i offset = _mm_set1_epi8('A');
+	offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(values, _mm_set1_epi8(25)), _mm_set1_epi8(6)));
+	offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(values, _mm_set1_epi8(51)), _mm_set1_epi8(-75)));
+	offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpeq_epi8(values, _mm_set1_epi8(62)), _mm_set1_epi8(-15)));
+	offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpeq_epi8(values, _mm_set1_epi8(63)), _mm_set1_epi8(-12)));
+	return _mm_add_epi8(values, offset);
+}
+
+
+// Maps ASCII to 6-bit values, setting valid to false if any character is outside the alphabet, then packs each
+// 32-bit lane of four values into three bytes at the start of the lane's 12 byte output
+TARGET_SSSE3 static inline __m128i DecodeBase64LanesSSSE3(__m128i in, bool& valid)
+{
+	__m128i upper = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('Z' + 1)));
+	__m128i lower = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('z' + 1)));
+	__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('9' + 1)));
+	__m128i plus = _mm_cmpeq_epi8(in, _mm_set1_epi8('+'));
+	__m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+	__m128i any = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, plus)), slash);
+	valid = _mm_movemask_epi8(any) == 0xffff;
+
+	__m128i offset = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+	offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+	offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+	offset = _mm_or_si128(offset, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+	offset = _mm_or_si128(offset, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+	__m128i values = _mm_add_epi8(in, offset);
+
+	__m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+	__m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+	return _mm_shuffle_epi8(groups, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+
+TARGET_SSSE3 static size_t EncodeBase64SSSE3(const uint8_t* src, size_t len, char* dest)
+{
+	size_t i = 0;
+	for (; (i + 16) <= len; i += 12, dest += 16)
+	{
+		__m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+		_mm_storeu_si128((__m128i*)dest, EncodeBase64LanesSSSE3(in));
+	}
+	return i + EncodeBase64Scalar(src + i, len - i, dest);
+}
+
+
+TARGET_SSSE3 static size_t DecodeBase64SSSE3(const char* src, size_t len, uint8_t* dest)
+{
+	size_t i = 0;
+	for (; (i + 16) <= len; i += 16, dest += 12)
+	{
+		bool valid;
+		__m128i out = DecodeBase64LanesSSSE3(_mm_loadu_si128((const __m128i*)(src + i)), valid);
+		if (!valid)
+			break;
+		_mm_storeu_si128((__m128i*)dest, out);
+	}
+	return i + DecodeBase64Scalar(src + i, len - i, dest);
+}
+
+
+TARGET_SSSE3 static size_t GetPlainPrefixSSSE3(const uint8_t* src, size_t len)
+{
+	size_t i = 0;
+	for (; (i + 16) <= len; i += 16)
+	{
+		__m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i bad = _mm_or_si128(_mm_cmplt_epi8(in, _mm_set1_epi8(0x20)), _mm_cmpeq_epi8(in, _mm_set1_epi8(0x7f)));
+		bad = _mm_or_si128(bad, _mm_cmpeq_epi8(in, _mm_set1_epi8('\\')));
+		bad = _mm_or_si128(bad, _mm_cmpeq_epi8(in, _mm_set1_epi8('"')));
+		bad = _mm_or_si128(bad, _mm_cmpeq_epi8(in, _mm_set1_epi8('\'')));
+		if (_mm_movemask_epi8(bad) != 0)
+			break;
+	}
+	return i + GetPlainPrefixScalar(src + i, len - i);
+}
+
+
+// The AVX2 versions run the same per-lane algorithm on two 128-bit lanes at once
+TARGET_AVX2 static size_t EncodeBase64AVX2(const uint8_t* src, size_t len, char* dest)
+{
+	const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+		1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	size_t i = 0;
+	for (; (i + 28) <= len; i += 24, dest += 32)
+	{
+		__m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(src + i))),
+			_mm_loadu_si128((const __m128i*)(src + i + 12)), 1);
+		in = _mm256_shuffle_epi8(in, shuffle);
+		__m256i high = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+			_mm256_set1_epi32(0x04000040));
+		__m256i low = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+			_mm256_set1_epi32(0x01000010));
+		__m256i values = _mm256_or_si256(high, low);
+
+		__m256i offset = _mm256_set1_epi8('A');
+		offset = _mm256_add_epi8(offset,
+			_mm256_and_si256(_mm256_cmpgt_epi8(values, _mm256_set1_epi8(25)), _mm256_set1_epi8(6)));
+		offset = _mm256_add_epi8(offset,
+			_mm256_and_si256(_mm256_cmpgt_epi8(values, _mm256_set1_epi8(51)), _mm256_set1_epi8(-75)));
+		offset = _mm256_add_epi8(offset,
+			_mm256_and_si256(_mm256_cmpeq_epi8(values, _mm256_set1_epi8(62)), _mm256_set1_epi8(-15)));
+		offset = _mm256_add_epi8(offset,
+			_mm256_and_si256(_mm256_cmpeq_epi8(values, _mm256_set1_epi8(63)), _mm256_set1_epi8(-12)));
+		_mm256_storeu_si256((__m256i*)dest, _mm256_add_epi8(values, offset));
+	}
+	return i + EncodeBase64SSSE3(src + i, len - i, dest);
+}
+
+
+TARGET_AVX2 static size_t DecodeBase64AVX2(const char* src, size_t len, uint8_t* dest)
+{
+	size_t i = 0;
+	for (; (i + 32) <= len; i += 32, dest += 24)
+	{
+		__m256i in = _mm256_loadu_si256((const __m256i*)(src + i));
+		__m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('A' - 1)),
+			_mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), in));
+		__m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('a' - 1)),
+			_mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), in));
+		__m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('0' - 1)),
+			_mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), in));
+		__m256i plus = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('+'));
+		__m256i slash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+		__m256i any = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, plus)),
+			slash);
+		if (_mm256_movemask_epi8(any) != -1)
+			break;
+
+		__m256i offset = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+		offset = _mm256_or_si256(offset, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+		offset = _mm256_or_si256(offset, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+		offset = _mm256_or_si256(offset, _mm256_and_si256(plus, _mm256_set1_epi8(62 - '+')));
+		offset = _mm256_or_si256(offset, _mm256_and_si256(slash, _mm256_set1_epi8(63 - '/')));
+		__m256i values = _mm256_add_epi8(in, offset);
+
+		__m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+		__m256i groups = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+		__m256i packed = _mm256_shuffle_epi8(groups, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+			-1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+		packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+		_mm256_storeu_si256((__m256i*)dest, packed);
+	}
+	return i + DecodeBase64SSSE3(src + i, len - i, dest);
+}
+
+
+TARGET_AVX2 static size_t GetPlainPrefixAVX2(const uint8_t* src, size_t len)
+{
+	size_t i = 0;
+	for (; (i + 32) <= len; i += 32)
+	{
+		__m256i in = _mm256_loadu_si256((const __m256i*)(src + i));
+		__m256i bad = _mm256_or_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), in),
+			_mm256_cmpeq_epi8(in, _mm256_set1_epi8(0x7f)));
+		bad = _mm256_or_si256(bad, _mm256_cmpeq_epi8(in, _mm256_set1_epi8('\\')));
+		bad = _mm256_or_si256(bad, _mm256_cmpeq_epi8(in, _mm256_set1_epi8('"')));
+		bad = _mm256_or_si256(bad, _mm256_cmpeq_epi8(in, _mm256_set1_epi8('\'')));
+		if (_mm256_movemask_epi8(bad) != 0)
+			break;
+	}
+	return i + GetPlainPrefixSSSE3(src + i, len - i);
+}
+#endif
+
+
+struct DataBufferCodecs
+{
+	Base64EncodeFunction encodeBase64;
+	Base64DecodeFunction decodeBase64;
+	PlainPrefixFunction getPlainPrefix;
+
+	DataBufferCodecs(): encodeBase64(EncodeBase64Scalar), decodeBase64(DecodeBase64Scalar),
+		getPlainPrefix(GetPlainPrefixScalar)
+	{
+#ifdef DATABUFFER_X86_SIMD
+		switch (DetectSimdLevel())
+		{
+		case SimdAVX2:
+			encodeBase64 = EncodeBase64AVX2;
+			decodeBase64 = DecodeBase64AVX2;
+			getPlainPrefix = GetPlainPrefixAVX2;
+			break;
+		case SimdSSSE3:
+			encodeBase64 = EncodeBase64SSSE3;
+			decodeBase64 = DecodeBase64SSSE3;
+			getPlainPrefix = GetPlainPrefixSSSE3;
+			break;
+		default:
+			break;
+		}
+#endif
+	}
+};
+
+
+static const DataBufferCodecs& GetCodecs()
+{
+	static DataBufferCodecs codecs;
+	return codecs;
+}
+
+
+static string EncodeBase64(const uint8_t* src, size_t len)
+{
+	string result(((len + 2) / 3) * 4, '\0');
+	char* dest = &result[0];
+	size_t consumed = GetCodecs().encodeBase64(src, len, dest);
+	dest += (consumed / 3) * 4;
+
+	size_t remaining = len - consumed;
+	if (remaining != 0)
+	{
+		uint32_t group = (uint32_t)src[consumed] << 16;
+		if (remaining > 1)
+			group |= (uint32_t)src[consumed + 1] << 8;
+		dest[0] = g_base64Alphabet[group >> 18];
+		dest[1] = g_base64Alphabet[(group >> 12) & 63];
+		dest[2] = (remaining > 1) ? g_base64Alphabet[(group >> 6) & 63] : '=';
+		dest[3] = '=';
+	}
+	return result;
+}
+
+
+// Decodes canonical Base64 (length a multiple of four, padding only at the end). Returns false for anything
+// else so that the caller can defer to the core's more lenient decoder.
+static bool DecodeBase64(const string& src, DataBuffer& output)
+{
+	size_t len = src.size();
+	if ((len % 4) != 0)
+		return false;
+
+	size_t padding = 0;
+	if ((len != 0) && (src[len - 1] == '='))
+		padding = (src[len - 2] == '=') ? 2 : 1;
+
+	// Leave room for the bytes the vector decoders write past the end of their output
+	size_t outputLength = ((len / 4) * 3) - padding;
+	DataBuffer result(((len / 4) * 3) + 8);
+	uint8_t* dest = (uint8_t*)result.GetData();
+	size_t bodyLength = padding ? (len - 4) : len;
+	if (GetCodecs().decodeBase64(src.data(), bodyLength, dest) != bodyLength)
+		return false;
+
+	if (padding)
+	{
+		const char* tail = src.data() + bodyLength;
+		uint8_t a = Base64Value(tail[0]);
+		uint8_t b = Base64Value(tail[1]);
+		uint8_t c = (padding == 1) ? Base64Value(tail[2]) : 0;
+		if ((a | b | c) & 0x80)
+			return false;
+		uint8_t* last = dest + ((bodyLength / 4) * 3);
+		last[0] = (uint8_t)((a << 2) | (b >> 4));
+		if (padding == 1)
+			last[1] = (uint8_t)((b << 4) | (c >> 2));
+	}
+
+	result.SetSize(outputLength);
+	output = move(result);
+	return true;
+}
+
+
+static bool IsPlainString(const void* data, size_t len)
 {
-	m_buffer = BNCreateDataBuffer(nullptr, 0);
+	return GetCodecs().getPlainPrefix((const uint8_t*)data, len) == len;
 }
 
 
-DataBuffer::DataBuffer(size_t len)
+constexpr size_t DataBuffer::InlineCapacity;
+
+
+DataBuffer::DataBuffer(): m_buffer(nullptr), m_inlineLength(0)
+{
+}
+
+
+DataBuffer::DataBuffer(size_t len): m_buffer(nullptr), m_inlineLength(0)
+{
+	if (len <= InlineCapacity)
+	{
+		memset(m_inline, 0, len);
+		m_inlineLength = len;
+	}
+	else
+	{
+		m_buffer = BNCreateDataBuffer(nullptr, len);
+	}
+}
+
+
+DataBuffer::DataBuffer(const void* data, size_t len): m_buffer(nullptr), m_inlineLength(0)
 {
-	m_buffer = BNCreateDataBuffer(nullptr, len);
+	if (len <= InlineCapacity)
+		AssignInline(data, len);
+	else
+		m_buffer = BNCreateDataBuffer(data, len);
 }
 
 
-DataBuffer::DataBuffer(const void* data, size_t len)
+DataBuffer::DataBuffer(const DataBuffer& buf): m_buffer(nullptr), m_inlineLength(0)
 {
-	m_buffer = BNCreateDataBuffer(data, len);
+	BNDataBuffer* other = buf.m_buffer.load(memory_order_acquire);
+	if (other)
+		m_buffer = BNDuplicateDataBuffer(other);
+	else
+		AssignInline(buf.m_inline, buf.m_inlineLength);
 }
 
 
-DataBuffer::DataBuffer(const DataBuffer& buf)
+DataBuffer::DataBuffer(DataBuffer&& buf) NOEXCEPT: m_buffer(nullptr), m_inlineLength(0)
 {
-	m_buffer = BNDuplicateDataBuffer(buf.m_buffer);
+	BNDataBuffer* other = buf.m_buffer.load(memory_order_relaxed);
+	if (other)
+		m_buffer = other;
+	else
+		AssignInline(buf.m_inline, buf.m_inlineLength);
+	buf.m_buffer = nullptr;
+	buf.m_inlineLength = 0;
 }
 
-DataBuffer::DataBuffer(DataBuffer&& buf)
+DataBuffer::DataBuffer(BNDataBuffer* buf): m_buffer(buf), m_inlineLength(0)
 {
-	m_buffer = buf.m_buffer;
-	buf.m_buffer = BNCreateDataBuffer(nullptr, 0);
 }
 
-DataBuffer::DataBuffer(BNDataBuffer* buf)
+
+DataBuffer::DataBuffer(const DataBufferView& view): m_buffer(nullptr), m_inlineLength(0)
 {
-	m_buffer = buf;
+	if (view.GetLength() <= InlineCapacity)
+		AssignInline(view.GetData(), view.GetLength());
+	else
+		m_buffer = BNCreateDataBuffer(view.GetData(), view.GetLength());
 }
 
 
 DataBuffer::~DataBuffer()
 {
-	BNFreeDataBuffer(m_buffer);
+	BNDataBuffer* buffer = m_buffer.load(memory_order_relaxed);
+	if (buffer)
+		BNFreeDataBuffer(buffer);
+}
+
+
+void DataBuffer::AssignInline(const void* data, size_t len)
+{
+	if (len)
+		memmove(m_inline, data, len);
+	m_inlineLength = len;
+}
+
+
+void DataBuffer::ResetToEmpty()
+{
+	BNDataBuffer* buffer = m_buffer.exchange(nullptr, memory_order_relaxed);
+	if (buffer)
+		BNFreeDataBuffer(buffer);
+	m_inlineLength = 0;
 }
 
 
@@ -69,77 +538,138 @@ DataBuffer& DataBuffer::operator=(const DataBuffer& buf)
 {
 	if (this != &buf)
 	{
-		BNFreeDataBuffer(m_buffer);
-		m_buffer = BNDuplicateDataBuffer(buf.m_buffer);
+		ResetToEmpty();
+		BNDataBuffer* other = buf.m_buffer.load(memory_order_acquire);
+		if (other)
+			m_buffer = BNDuplicateDataBuffer(other);
+		else
+			AssignInline(buf.m_inline, buf.m_inlineLength);
 	}
 
 	return *this;
 }
 
-DataBuffer& DataBuffer::operator=(DataBuffer&& buf)
+
+DataBuffer& DataBuffer::operator=(DataBuffer&& buf) NOEXCEPT
 {
 	if (this != &buf)
 	{
-		BNClearDataBuffer(m_buffer);
-		BNDataBuffer* temp = m_buffer;
-		m_buffer = buf.m_buffer;
-		buf.m_buffer = temp;
+		ResetToEmpty();
+		BNDataBuffer* other = buf.m_buffer.exchange(nullptr, memory_order_relaxed);
+		if (other)
+			m_buffer = other;
+		else
+			AssignInline(buf.m_inline, buf.m_inlineLength);
+		buf.m_inlineLength = 0;
 	}
 
 	return *this;
 }
 
+
+BNDataBuffer* DataBuffer::GetBufferObject() const
+{
+	BNDataBuffer* buffer = m_buffer.load(memory_order_acquire);
+	if (buffer)
+		return buffer;
+
+	// Move the inline contents into a core buffer. Concurrent callers on a const buffer may race to do this,
+	// in which case the loser frees its copy and uses the winner's.
+	BNDataBuffer* created = BNCreateDataBuffer(m_inline, m_inlineLength);
+	if (m_buffer.compare_exchange_strong(buffer, created, memory_order_acq_rel, memory_order_acquire))
+		return created;
+	BNFreeDataBuffer(created);
+	return buffer;
+}
+
+
 void* DataBuffer::GetData()
 {
-	return BNGetDataBufferContents(m_buffer);
+	BNDataBuffer* buffer = m_buffer.load(memory_order_acquire);
+	if (buffer)
+		return BNGetDataBufferContents(buffer);
+	return m_inline;
 }
 
 
 const void* DataBuffer::GetData() const
 {
-	return BNGetDataBufferContents(m_buffer);
+	BNDataBuffer* buffer = m_buffer.load(memory_order_acquire);
+	if (buffer)
+		return BNGetDataBufferContents(buffer);
+	return m_inline;
 }
 
 
 void* DataBuffer::GetDataAt(size_t offset)
 {
-	return BNGetDataBufferContentsAt(m_buffer, offset);
+	BNDataBuffer* buffer = m_buffer.load(memory_order_acquire);
+	if (buffer)
+		return BNGetDataBufferContentsAt(buffer, offset);
+	return &m_inline[offset];
 }
 
 
 const void* DataBuffer::GetDataAt(size_t offset) const
 {
-	return BNGetDataBufferContentsAt(m_buffer, offset);
+	BNDataBuffer* buffer = m_buffer.load(memory_order_acquire);
+	if (buffer)
+		return BNGetDataBufferContentsAt(buffer, offset);
+	return &m_inline[offset];
 }
 
 
 size_t DataBuffer::GetLength() const
 {
-	return BNGetDataBufferLength(m_buffer);
+	BNDataBuffer* buffer = m_buffer.load(memory_order_acquire);
+	if (buffer)
+		return BNGetDataBufferLength(buffer);
+	return m_inlineLength;
 }
 
 
 void DataBuffer::SetSize(size_t len)
 {
-	BNSetDataBufferLength(m_buffer, len);
+	if (IsInline() && (len <= InlineCapacity))
+	{
+		if (len > m_inlineLength)
+			memset(&m_inline[m_inlineLength], 0, len - m_inlineLength);
+		m_inlineLength = len;
+		return;
+	}
+	BNSetDataBufferLength(GetBufferObject(), len);
 }
 
 
 void DataBuffer::Clear()
 {
-	BNClearDataBuffer(m_buffer);
+	BNDataBuffer* buffer = m_buffer.load(memory_order_acquire);
+	if (buffer)
+		BNClearDataBuffer(buffer);
+	m_inlineLength = 0;
 }
 
 
 void DataBuffer::Append(const void* data, size_t len)
 {
-	BNAppendDataBufferContents(m_buffer, data, len);
+	if (IsInline() && (len <= (InlineCapacity - m_inlineLength)))
+	{
+		if (len)
+			memmove(&m_inline[m_inlineLength], data, len);
+		m_inlineLength += len;
+		return;
+	}
+	BNAppendDataBufferContents(GetBufferObject(), data, len);
 }
 
 
 void DataBuffer::Append(const DataBuffer& buf)
 {
-	BNAppendDataBuffer(m_buffer, buf.m_buffer);
+	BNDataBuffer* other = buf.m_buffer.load(memory_order_acquire);
+	if (other && !IsInline())
+		BNAppendDataBuffer(GetBufferObject(), other);
+	else
+		Append(buf.GetData(), buf.GetLength());
 }
 
 
@@ -151,8 +681,22 @@ void DataBuffer::AppendByte(uint8_t val)
 
 DataBuffer DataBuffer::GetSlice(size_t start, size_t len)
 {
-	BNDataBuffer* result = BNGetDataBufferSlice(m_buffer, start, len);
-	return DataBuffer(result);
+	BNDataBuffer* buffer = m_buffer.load(memory_order_acquire);
+	if (buffer)
+		return DataBuffer(BNGetDataBufferSlice(buffer, start, len));
+	return DataBuffer(GetView(start, len));
+}
+
+
+DataBufferView DataBuffer::GetView() const
+{
+	return DataBufferView(*this);
+}
+
+
+DataBufferView DataBuffer::GetView(size_t start, size_t len) const
+{
+	return DataBufferView(*this).GetSlice(start, len);
 }
 
 
@@ -170,37 +714,142 @@ const uint8_t& DataBuffer::operator[](size_t offset) const
 
 string DataBuffer::ToEscapedString() const
 {
-	char* str = BNDataBufferToEscapedString(m_buffer);
-	string result = str;
-	BNFreeString(str);
-	return result;
+	return GetView().ToEscapedString();
 }
 
 
 DataBuffer DataBuffer::FromEscapedString(const string& src)
 {
+	// Every escape sequence starts with a backslash, so without one the string decodes to itself
+	if (!memchr(src.data(), '\\', src.size()))
+		return DataBuffer(src.data(), src.size());
 	return DataBuffer(BNDecodeEscapedString(src.c_str()));
 }
 
 
 string DataBuffer::ToBase64() const
 {
-	char* str = BNDataBufferToBase64(m_buffer);
-	string result = str;
-	BNFreeString(str);
-	return result;
+	return GetView().ToBase64();
 }
 
 
 DataBuffer DataBuffer::FromBase64(const string& src)
 {
+	DataBuffer result;
+	if (DecodeBase64(src, result))
+		return result;
 	return DataBuffer(BNDecodeBase64(src.c_str()));
 }
 
 
 bool DataBuffer::ZlibCompress(DataBuffer& output) const
 {
-	BNDataBuffer* result = BNZlibCompress(output.m_buffer);
+	return GetView().ZlibCompress(output);
+}
+
+
+bool DataBuffer::ZlibDecompress(DataBuffer& output) const
+{
+	return GetView().ZlibDecompress(output);
+}
+
+
+// Core APIs only accept core buffers. When the view covers a whole DataBuffer its handle is passed through,
+// otherwise the viewed bytes are copied into a temporary buffer for the duration of the call.
+static BNDataBuffer* GetCoreBufferForView(const DataBufferView& view, DataBuffer& temp)
+{
+	if (view.GetBuffer())
+		return view.GetBuffer()->GetBufferObject();
+	temp = view.ToBuffer();
+	return temp.GetBufferObject();
+}
+
+
+DataBufferView::DataBufferView(): m_data(nullptr), m_length(0), m_buffer(nullptr)
+{
+}
+
+
+DataBufferView::DataBufferView(const void* data, size_t len): m_data((const uint8_t*)data), m_length(len),
+	m_buffer(nullptr)
+{
+}
+
+
+DataBufferView::DataBufferView(const DataBuffer& buf): m_data((const uint8_t*)buf.GetData()),
+	m_length(buf.GetLength()), m_buffer(&buf)
+{
+}
+
+
+DataBufferView::DataBufferView(const string& str): m_data((const uint8_t*)str.data()), m_length(str.size()),
+	m_buffer(nullptr)
+{
+}
+
+
+DataBufferView::DataBufferView(const shared_ptr<const DataBuffer>& owner): m_data(nullptr), m_length(0),
+	m_buffer(owner.get()), m_owner(owner)
+{
+	if (owner)
+	{
+		m_data = (const uint8_t*)owner->GetData();
+		m_length = owner->GetLength();
+	}
+}
+
+
+DataBufferView DataBufferView::GetSlice(size_t start, size_t len) const
+{
+	if (start > m_length)
+		start = m_length;
+	if (len > (m_length - start))
+		len = m_length - start;
+
+	DataBufferView result(*this);
+	result.m_data = m_data + start;
+	result.m_length = len;
+	if ((start != 0) || (len != m_length))
+		result.m_buffer = nullptr;
+	return result;
+}
+
+
+DataBuffer DataBufferView::ToBuffer() const
+{
+	return DataBuffer(m_data, m_length);
+}
+
+
+string DataBufferView::ToString() const
+{
+	return string((const char*)m_data, m_length);
+}
+
+
+string DataBufferView::ToEscapedString() const
+{
+	if (IsPlainString(m_data, m_length))
+		return ToString();
+
+	DataBuffer temp;
+	char* str = BNDataBufferToEscapedString(GetCoreBufferForView(*this, temp));
+	string result = str;
+	BNFreeString(str);
+	return result;
+}
+
+
+string DataBufferView::ToBase64() const
+{
+	return EncodeBase64(m_data, m_length);
+}
+
+
+bool DataBufferView::ZlibCompress(DataBuffer& output) const
+{
+	DataBuffer temp;
+	BNDataBuffer* result = BNZlibCompress(GetCoreBufferForView(*this, temp));
 	if (!result)
 		return false;
 	output = DataBuffer(result);
@@ -208,9 +857,10 @@ bool DataBuffer::ZlibCompress(DataBuffer& output) const
 }
 
 
-bool DataBuffer::ZlibDecompress(DataBuffer& output) const
+bool DataBufferView::ZlibDecompress(DataBuffer& output) const
 {
-	BNDataBuffer* result = BNZlibDecompress(output.m_buffer);
+	DataBuffer temp;
+	BNDataBuffer* result = BNZlibDecompress(GetCoreBufferForView(*this, temp));
 	if (!result)
 		return false;
 	output = DataBuffer(result);
@@ -220,13 +870,20 @@ bool DataBuffer::ZlibDecompress(DataBuffer& output) const
 
 string BinaryNinja::EscapeString(const string& s)
 {
-	DataBuffer buffer(s.c_str(), s.size());
-	return buffer.ToEscapedString();
+	return DataBufferView(s).ToEscapedString();
+}
+
+
+string BinaryNinja::EscapeString(const DataBufferView& data)
+{
+	return data.ToEscapedString();
 }
 
 
 string BinaryNinja::UnescapeString(const string& s)
 {
+	if (!memchr(s.data(), '\\', s.size()))
+		return s;
 	DataBuffer buffer = DataBuffer::FromEscapedString(s);
 	return string((const char*)buffer.GetData(), buffer.GetLength());
 }
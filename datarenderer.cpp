@@ -46,7 +46,7 @@ bool DataRenderer::IsValidForDataCallback(void* ctxt, BNBinaryView* view, uint64
 	vector<Type*> context;
 	context.reserve(ctxCount);
 	for (size_t i = 0; i < ctxCount; i++)
-		context.push_back(new Type(BNNewTypeReference(typeCtx[i])));
+		context.emplace_back(new Type(BNNewTypeReference(typeCtx[i])));
 
 	return renderer->IsValidForData(viewObj, addr, typeObj, context);
 }
@@ -64,7 +64,7 @@ BNDisassemblyTextLine* DataRenderer::GetLinesForDataCallback(void* ctxt, BNBinar
 	vector<Type*> context;
 	context.reserve(ctxCount);
 	for (size_t i = 0; i < ctxCount; i++)
-		context.push_back(new Type(BNNewTypeReference(typeCtx[i])));
+		context.emplace_back(new Type(BNNewTypeReference(typeCtx[i])));
 	auto lines = renderer->GetLinesForData(viewObj, addr, typeObj, prefixes, width, context);
 	*count = lines.size();
 	BNDisassemblyTextLine* buf = new BNDisassemblyTextLine[lines.size()];
@@ -0,0 +1,652 @@
+// Copyright (c) 2015-2019 Vector 35 Inc
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <string.h>
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DATASEARCH_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+#define DATA_SEARCH_CHUNK_SIZE 0x100000
+
+
+struct DataSearchChunk
+{
+	uint64_t start, end; // Matches must start in this range
+	uint64_t limit; // Matches may not extend past this address
+};
+
+
+// Splits the part of [start, end) that is backed by readable segments into chunks. Adjacent and overlapping
+// segments are merged first so that matches spanning a segment boundary are still found.
+static vector<DataSearchChunk> GetDataSearchChunks(BinaryView* view, uint64_t start, uint64_t end)
+{
+	vector<pair<uint64_t, uint64_t>> ranges;
+	vector<Ref<Segment>> segments = view->GetSegments();
+	for (auto& segment : segments)
+	{
+		if (segment->GetFlags() & SegmentReadable)
+			ranges.push_back(pair<uint64_t, uint64_t>(segment->GetStart(), segment->GetEnd()));
+	}
+	if (segments.empty())
+		ranges.push_back(pair<uint64_t, uint64_t>(view->GetStart(), view->GetEnd()));
+	sort(ranges.begin(), ranges.end());
+
+	vector<pair<uint64_t, uint64_t>> merged;
+	for (auto& i : ranges)
+	{
+		if (!merged.empty() && (i.first <= merged.back().second))
+			merged.back().second = max(merged.back().second, i.second);
+		else
+			merged.push_back(i);
+	}
+
+	vector<DataSearchChunk> chunks;
+	for (auto& i : merged)
+	{
+		uint64_t rangeStart = max(i.first, start);
+		uint64_t rangeEnd = min(i.second, end);
+		for (uint64_t addr = rangeStart; addr < rangeEnd; )
+		{
+			DataSearchChunk chunk;
+			chunk.start = addr;
+			chunk.end = ((rangeEnd - addr) > DATA_SEARCH_CHUNK_SIZE) ? (addr + DATA_SEARCH_CHUNK_SIZE) : rangeEnd;
+			chunk.limit = i.second;
+			chunks.push_back(chunk);
+			addr = chunk.end;
+		}
+	}
+	return chunks;
+}
+
+
+// Reads the bytes of a chunk plus up to overlap bytes after it, so that matches starting near the end of the
+// chunk can be checked. Returns the number of bytes read.
+static size_t ReadDataSearchChunk(BinaryView* view, const DataSearchChunk& chunk, size_t overlap,
+	vector<uint8_t>& buffer)
+{
+	uint64_t readEnd = ((chunk.limit - chunk.end) > overlap) ? (chunk.end + overlap) : chunk.limit;
+	buffer.resize((size_t)(readEnd - chunk.start));
+	size_t len = view->Read(buffer.data(), chunk.start, buffer.size());
+	buffer.resize(len);
+	return len;
+}
+
+
+// Scans chunks on up to threadCount threads and passes the hits to deliver in chunk order, one call at a time.
+// Chunks are claimed in order, so only the results of chunks finished ahead of a slower earlier one are held.
+template <typename Hit>
+static bool SearchChunksInOrder(const vector<DataSearchChunk>& chunks, size_t threadCount, BackgroundTask* task,
+	const function<void(const DataSearchChunk& chunk, vector<Hit>& hits)>& scan,
+	const function<bool(const Hit& hit)>& deliver)
+{
+	vector<vector<Hit>> results(chunks.size());
+	vector<bool> finished(chunks.size(), false);
+	size_t nextToDeliver = 0;
+	size_t finishedCount = 0;
+	size_t lastPercent = 0;
+	mutex lock;
+	atomic<bool> stop(false);
+
+	WorkerParallelFor(chunks.size(), [&](size_t i) {
+			if (stop)
+				return;
+			if (task && task->IsCancelled())
+			{
+				stop = true;
+				return;
+			}
+
+			vector<Hit> hits;
+			scan(chunks[i], hits);
+
+			unique_lock<mutex> guard(lock);
+			results[i] = move(hits);
+			finished[i] = true;
+			finishedCount++;
+
+			while (!stop && (nextToDeliver < chunks.size()) && finished[nextToDeliver])
+			{
+				for (auto& hit : results[nextToDeliver])
+				{
+					if (!deliver(hit))
+					{
+						stop = true;
+						break;
+					}
+				}
+				vector<Hit>().swap(results[nextToDeliver]);
+				nextToDeliver++;
+			}
+
+			size_t percent = (finishedCount * 100) / chunks.size();
+			if (task && (percent != lastPercent))
+			{
+				lastPercent = percent;
+				task->SetProgressText("Searching... " + to_string(percent) + "%");
+			}
+		}, threadCount);
+
+	return !stop;
+}
+
+
+static inline size_t CountTrailingZeros(uint32_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return (size_t)index;
+#else
+	return (size_t)__builtin_ctz(value);
+#endif
+}
+
+
+class MaskedPattern
+{
+	vector<uint8_t> m_pattern, m_mask;
+	size_t m_anchor;
+	bool m_hasAnchor, m_hasPairAnchor;
+
+	bool MatchesAt(const uint8_t* data) const
+	{
+		for (size_t i = 0; i < m_pattern.size(); i++)
+		{
+			if ((data[i] & m_mask[i]) != m_pattern[i])
+				return false;
+		}
+		return true;
+	}
+
+public:
+	MaskedPattern(const DataBuffer& pattern, const DataBuffer& mask): m_anchor(0), m_hasAnchor(false),
+		m_hasPairAnchor(false)
+	{
+		const uint8_t* patternData = (const uint8_t*)pattern.GetData();
+		const uint8_t* maskData = (const uint8_t*)mask.GetData();
+		m_pattern.resize(pattern.GetLength());
+		m_mask.resize(pattern.GetLength());
+		for (size_t i = 0; i < m_pattern.size(); i++)
+		{
+			m_mask[i] = (i < mask.GetLength()) ? maskData[i] : 0xff;
+			m_pattern[i] = patternData[i] & m_mask[i];
+		}
+
+		// Candidates are found by comparing one or two fully specified bytes, then verified with the mask.
+		// A pair of adjacent bytes is much more selective than one, and 00 and ff are common filler values.
+		for (size_t i = 0; (i + 1) < m_pattern.size(); i++)
+		{
+			if ((m_mask[i] != 0xff) || (m_mask[i + 1] != 0xff))
+				continue;
+			bool common = (m_pattern[i] == 0) || (m_pattern[i] == 0xff);
+			if (!m_hasPairAnchor || !common)
+			{
+				m_anchor = i;
+				m_hasAnchor = true;
+				m_hasPairAnchor = true;
+				if (!common)
+					break;
+			}
+		}
+		if (!m_hasAnchor)
+		{
+			for (size_t i = 0; i < m_pattern.size(); i++)
+			{
+				if (m_mask[i] == 0xff)
+				{
+					m_anchor = i;
+					m_hasAnchor = true;
+					break;
+				}
+			}
+		}
+	}
+
+	size_t GetLength() const { return m_pattern.size(); }
+
+	void Find(const uint8_t* data, size_t len, size_t positions, uint64_t base, vector<uint64_t>& hits) const
+	{
+		if (len < m_pattern.size())
+			return;
+		positions = min(positions, len - m_pattern.size() + 1);
+
+		size_t pos = 0;
+#ifdef DATASEARCH_SSE2
+		if (m_hasAnchor)
+		{
+			__m128i first = _mm_set1_epi8((char)m_pattern[m_anchor]);
+			__m128i second = _mm_set1_epi8((char)(m_hasPairAnchor ? m_pattern[m_anchor + 1] : 0));
+			for (; (pos + 16) <= positions; pos += 16)
+			{
+				__m128i cmp = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&data[pos + m_anchor]), first);
+				if (m_hasPairAnchor)
+				{
+					cmp = _mm_and_si128(cmp, _mm_cmpeq_epi8(
+						_mm_loadu_si128((const __m128i*)&data[pos + m_anchor + 1]), second));
+				}
+				uint32_t bits = (uint32_t)_mm_movemask_epi8(cmp);
+				while (bits)
+				{
+					size_t candidate = pos + CountTrailingZeros(bits);
+					if (MatchesAt(&data[candidate]))
+						hits.push_back(base + candidate);
+					bits &= bits - 1;
+				}
+			}
+		}
+#endif
+		if (m_hasAnchor)
+		{
+			for (; pos < positions; pos++)
+			{
+				if ((data[pos + m_anchor] == m_pattern[m_anchor]) && MatchesAt(&data[pos]))
+					hits.push_back(base + pos);
+			}
+		}
+		else
+		{
+			for (; pos < positions; pos++)
+			{
+				if (MatchesAt(&data[pos]))
+					hits.push_back(base + pos);
+			}
+		}
+	}
+};
+
+
+bool BinaryView::ParseBytePattern(const string& text, DataBuffer& pattern, DataBuffer& mask)
+{
+	vector<uint8_t> patternBytes, maskBytes;
+	bool highNibble = true;
+	for (char c : text)
+	{
+		uint8_t value, nibbleMask;
+		if ((c == ' ') || (c == '\t'))
+		{
+			if (!highNibble)
+				return false;
+			continue;
+		}
+		else if (c == '?')
+		{
+			value = 0;
+			nibbleMask = 0;
+		}
+		else if ((c >= '0') && (c <= '9'))
+		{
+			value = (uint8_t)(c - '0');
+			nibbleMask = 0xf;
+		}
+		else if ((c >= 'a') && (c <= 'f'))
+		{
+			value = (uint8_t)(c - 'a' + 10);
+			nibbleMask = 0xf;
+		}
+		else if ((c >= 'A') && (c <= 'F'))
+		{
+			value = (uint8_t)(c - 'A' + 10);
+			nibbleMask = 0xf;
+		}
+		else
+		{
+			return false;
+		}
+
+		if (highNibble)
+		{
+			patternBytes.push_back((uint8_t)(value << 4));
+			maskBytes.push_back((uint8_t)(nibbleMask << 4));
+		}
+		else
+		{
+			patternBytes.back() |= value;
+			maskBytes.back() |= nibbleMask;
+		}
+		highNibble = !highNibble;
+	}
+
+	if (!highNibble || patternBytes.empty())
+		return false;
+	pattern = DataBuffer(patternBytes.data(), patternBytes.size());
+	mask = DataBuffer(maskBytes.data(), maskBytes.size());
+	return true;
+}
+
+
+bool BinaryView::FindAllData(uint64_t start, uint64_t end, const DataBuffer& pattern, const DataBuffer& mask,
+	const function<bool(uint64_t addr)>& callback, size_t threadCount, BackgroundTask* task)
+{
+	if (pattern.GetLength() == 0)
+		return true;
+
+	MaskedPattern matcher(pattern, mask);
+	vector<DataSearchChunk> chunks = GetDataSearchChunks(this, start, end);
+	return SearchChunksInOrder<uint64_t>(chunks, threadCount, task,
+		[&](const DataSearchChunk& chunk, vector<uint64_t>& hits) {
+			vector<uint8_t> buffer;
+			size_t len = ReadDataSearchChunk(this, chunk, matcher.GetLength() - 1, buffer);
+			matcher.Find(buffer.data(), len, (size_t)(chunk.end - chunk.start), chunk.start, hits);
+		}, callback);
+}
+
+
+bool BinaryView::FindAllData(uint64_t start, uint64_t end, const string& pattern,
+	const function<bool(uint64_t addr)>& callback, size_t threadCount, BackgroundTask* task)
+{
+	DataBuffer patternData, mask;
+	if (!ParseBytePattern(pattern, patternData, mask))
+		return false;
+	return FindAllData(start, end, patternData, mask, callback, threadCount, task);
+}
+
+
+struct MultiPatternScanner::Automaton
+{
+	static const uint32_t NoNode = 0xffffffff;
+
+	struct Node
+	{
+		uint32_t edgeStart, edgeCount; // Children, sorted by byte
+		uint32_t fail;
+		uint32_t outputStart, outputCount; // Patterns that end at this node
+		uint32_t dictLink; // Nearest node on the failure chain that has outputs
+	};
+
+	vector<Node> nodes;
+	vector<uint8_t> edgeBytes;
+	vector<uint32_t> edgeTargets;
+	vector<uint32_t> outputs;
+	vector<size_t> lengths;
+	size_t maxLength;
+	uint32_t rootNext[256];
+
+	uint32_t GetChild(uint32_t node, uint8_t value) const
+	{
+		const Node& n = nodes[node];
+		const uint8_t* begin = &edgeBytes[n.edgeStart];
+		const uint8_t* end = begin + n.edgeCount;
+		const uint8_t* i = lower_bound(begin, end, value);
+		if ((i == end) || (*i != value))
+			return NoNode;
+		return edgeTargets[n.edgeStart + (i - begin)];
+	}
+
+	uint32_t Step(uint32_t state, uint8_t value) const
+	{
+		while (state != 0)
+		{
+			uint32_t next = GetChild(state, value);
+			if (next != NoNode)
+				return next;
+			state = nodes[state].fail;
+		}
+		return rootNext[value];
+	}
+};
+
+
+MultiPatternScanner::MultiPatternScanner(const vector<DataBuffer>& patterns): m_automaton(new Automaton)
+{
+	Automaton& a = *m_automaton;
+	a.maxLength = 0;
+
+	// Build the trie with per node child maps, then flatten it into sorted edge arrays
+	vector<map<uint8_t, uint32_t>> children(1);
+	vector<vector<uint32_t>> nodeOutputs(1);
+	for (size_t id = 0; id < patterns.size(); id++)
+	{
+		const uint8_t* data = (const uint8_t*)patterns[id].GetData();
+		size_t len = patterns[id].GetLength();
+		a.lengths.push_back(len);
+		if (len == 0)
+			continue;
+		a.maxLength = max(a.maxLength, len);
+
+		uint32_t node = 0;
+		for (size_t i = 0; i < len; i++)
+		{
+			auto child = children[node].find(data[i]);
+			if (child == children[node].end())
+			{
+				uint32_t next = (uint32_t)children.size();
+				children[node][data[i]] = next;
+				children.emplace_back();
+				nodeOutputs.emplace_back();
+				node = next;
+			}
+			else
+			{
+				node = child->second;
+			}
+		}
+		nodeOutputs[node].push_back((uint32_t)id);
+	}
+
+	a.nodes.resize(children.size());
+	for (size_t i = 0; i < children.size(); i++)
+	{
+		Automaton::Node& node = a.nodes[i];
+		node.edgeStart = (uint32_t)a.edgeBytes.size();
+		node.edgeCount = (uint32_t)children[i].size();
+		for (auto& j : children[i])
+		{
+			a.edgeBytes.push_back(j.first);
+			a.edgeTargets.push_back(j.second);
+		}
+		node.outputStart = (uint32_t)a.outputs.size();
+		node.outputCount = (uint32_t)nodeOutputs[i].size();
+		a.outputs.insert(a.outputs.end(), nodeOutputs[i].begin(), nodeOutputs[i].end());
+		node.fail = 0;
+		node.dictLink = Automaton::NoNode;
+	}
+
+	for (size_t i = 0; i < 256; i++)
+		a.rootNext[i] = 0;
+	for (auto& i : children[0])
+		a.rootNext[i.first] = i.second;
+
+	// Failure links are assigned in breadth first order, so the links of shallower nodes are always ready
+	vector<uint32_t> queue;
+	for (auto& i : children[0])
+		queue.push_back(i.second);
+	for (size_t head = 0; head < queue.size(); head++)
+	{
+		uint32_t node = queue[head];
+		for (auto& i : children[node])
+		{
+			uint32_t child = i.second;
+			uint32_t fail = a.Step(a.nodes[node].fail, i.first);
+			a.nodes[child].fail = fail;
+			a.nodes[child].dictLink = (a.nodes[fail].outputCount != 0) ? fail : a.nodes[fail].dictLink;
+			queue.push_back(child);
+		}
+	}
+}
+
+
+MultiPatternScanner::~MultiPatternScanner()
+{
+}
+
+
+size_t MultiPatternScanner::GetPatternCount() const
+{
+	return m_automaton->lengths.size();
+}
+
+
+size_t MultiPatternScanner::GetMaxPatternLength() const
+{
+	return m_automaton->maxLength;
+}
+
+
+void MultiPatternScanner::Scan(const uint8_t* data, size_t len, uint64_t base, vector<Match>& matches) const
+{
+	const Automaton& a = *m_automaton;
+	size_t first = matches.size();
+	uint32_t state = 0;
+	for (size_t i = 0; i < len; i++)
+	{
+		// Most bytes do not start any pattern, so skip through them without leaving the root
+		if (state == 0)
+		{
+			while ((i < len) && (a.rootNext[data[i]] == 0))
+				i++;
+			if (i == len)
+				break;
+		}
+
+		state = a.Step(state, data[i]);
+		for (uint32_t node = state; node != Automaton::NoNode; node = a.nodes[node].dictLink)
+		{
+			const Automaton::Node& n = a.nodes[node];
+			for (uint32_t j = 0; j < n.outputCount; j++)
+			{
+				Match match;
+				match.patternId = a.outputs[n.outputStart + j];
+				match.address = base + i + 1 - a.lengths[match.patternId];
+				matches.push_back(match);
+			}
+		}
+	}
+
+	sort(matches.begin() + first, matches.end(), [](const Match& x, const Match& y) {
+			if (x.address != y.address)
+				return x.address < y.address;
+			return x.patternId < y.patternId;
+		});
+}
+
+
+bool MultiPatternScanner::Scan(BinaryView* view, uint64_t start, uint64_t end,
+	const function<bool(size_t patternId, uint64_t addr)>& callback, size_t threadCount, BackgroundTask* task) const
+{
+	if (m_automaton->maxLength == 0)
+		return true;
+
+	vector<DataSearchChunk> chunks = GetDataSearchChunks(view, start, end);
+	return SearchChunksInOrder<Match>(chunks, threadCount, task,
+		[&](const DataSearchChunk& chunk, vector<Match>& matches) {
+			vector<uint8_t> buffer;
+			size_t len = ReadDataSearchChunk(view, chunk, m_automaton->maxLength - 1, buffer);
+			Scan(buffer.data(), len, chunk.start, matches);
+
+			// Matches that start in the overlap belong to the next chunk
+			while (!matches.empty() && (matches.back().address >= chunk.end))
+				matches.pop_back();
+		},
+		[&](const Match& match) { return callback(match.patternId, match.address); });
+}
+
+
+bool MultiPatternScanner::Scan(BinaryView* view, const function<bool(size_t patternId, uint64_t addr)>& callback,
+	size_t threadCount, BackgroundTask* task) const
+{
+	return Scan(view, view->GetStart(), view->GetEnd(), callback, threadCount, task);
+}
+
+
+struct RegexSearchHit
+{
+	ByteRegex::Match match;
+	size_t chunk;
+};
+
+
+bool ByteRegex::Scan(BinaryView* view, uint64_t start, uint64_t end,
+	const function<bool(uint64_t addr, size_t len)>& callback, size_t threadCount, BackgroundTask* task) const
+{
+	if (!m_program)
+		return false;
+
+	size_t overlap = GetMaxMatchLength();
+	vector<DataSearchChunk> chunks = GetDataSearchChunks(view, start, end);
+	uint64_t lastEnd = 0;
+	size_t rescannedChunk = (size_t)-1;
+	return SearchChunksInOrder<RegexSearchHit>(chunks, threadCount, task,
+		[&](const DataSearchChunk& chunk, vector<RegexSearchHit>& hits) {
+			vector<uint8_t> buffer;
+			size_t len = ReadDataSearchChunk(view, chunk, overlap, buffer);
+			vector<Match> matches;
+			Scan(buffer.data(), len, (size_t)(chunk.end - chunk.start), chunk.start, matches);
+			for (auto& i : matches)
+			{
+				RegexSearchHit hit;
+				hit.match = i;
+				hit.chunk = (size_t)(&chunk - chunks.data());
+				hits.push_back(hit);
+			}
+		},
+		[&](const RegexSearchHit& hit) {
+			// Matches are leftmost-longest, so the next match depends only on where the scan resumes and not on
+			// any start past the end of the chunk. A chunk's matches therefore agree with a single scan unless a
+			// match from an earlier chunk ran past the start of this one.
+			if (hit.chunk == rescannedChunk)
+				return true;
+
+			if (hit.match.address < lastEnd)
+			{
+				// A match from the previous chunk ran into this one, so this chunk's matches were found from
+				// the wrong starting point. Scan the chunk again from the end of that match instead.
+				rescannedChunk = hit.chunk;
+				const DataSearchChunk& chunk = chunks[hit.chunk];
+				if (lastEnd >= chunk.end)
+					return true;
+
+				DataSearchChunk rest = chunk;
+				rest.start = lastEnd;
+				vector<uint8_t> buffer;
+				size_t len = ReadDataSearchChunk(view, rest, overlap, buffer);
+				vector<Match> matches;
+				Scan(buffer.data(), len, (size_t)(rest.end - rest.start), rest.start, matches);
+				for (auto& i : matches)
+				{
+					lastEnd = i.address + i.length;
+					if (!callback(i.address, i.length))
+						return false;
+				}
+				return true;
+			}
+
+			lastEnd = hit.match.address + hit.match.length;
+			return callback(hit.match.address, hit.match.length);
+		});
+}
+
+
+bool ByteRegex::Scan(BinaryView* view, const function<bool(uint64_t addr, size_t len)>& callback,
+	size_t threadCount, BackgroundTask* task) const
+{
+	return Scan(view, view->GetStart(), view->GetEnd(), callback, threadCount, task);
+}
@@ -116,7 +116,7 @@ vector<Ref<DownloadProvider>> DownloadProvider::GetList()
 	BNDownloadProvider** list = BNGetDownloadProviderList(&count);
 	vector<Ref<DownloadProvider>> result;
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new CoreDownloadProvider(list[i]));
+		result.emplace_back(new CoreDownloadProvider(list[i]));
 	BNFreeDownloadProviderList(list);
 	return result;
 }
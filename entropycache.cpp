@@ -0,0 +1,383 @@
+// Copyright (c) 2015-2019 Vector 35 Inc
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <cmath>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+// Blocks read and computed together by one worker
+#define ENTROPY_BLOCKS_PER_TASK 64
+#define ENTROPY_LOG_TABLE_SIZE  4097
+
+
+EntropyCache::EntropyCache(BinaryView* view, size_t blockSize, size_t threadCount, bool registerNotifications):
+	m_view(view), m_blockSize(blockSize ? blockSize : DefaultBlockSize), m_threadCount(threadCount),
+	m_registered(registerNotifications), m_start(0), m_blockCount(0), m_epoch(0)
+{
+	ResizeLocked(0);
+	if (m_registered)
+		m_view->RegisterNotification(this);
+}
+
+
+EntropyCache::~EntropyCache()
+{
+	if (m_registered)
+		m_view->UnregisterNotification(this);
+}
+
+
+void EntropyCache::ComputeHistogram(const uint8_t* data, size_t len, uint32_t counts[256])
+{
+	// Counting into four interleaved tables avoids stalling on repeated increments of the same counter,
+	// which dominates on low entropy data
+	uint32_t tables[4][256];
+	memset(tables, 0, sizeof(tables));
+
+	size_t i = 0;
+	for (; (i + 8) <= len; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, &data[i], sizeof(word));
+		tables[0][word & 0xff]++;
+		tables[1][(word >> 8) & 0xff]++;
+		tables[2][(word >> 16) & 0xff]++;
+		tables[3][(word >> 24) & 0xff]++;
+		tables[0][(word >> 32) & 0xff]++;
+		tables[1][(word >> 40) & 0xff]++;
+		tables[2][(word >> 48) & 0xff]++;
+		tables[3][word >> 56]++;
+	}
+	for (; i < len; i++)
+		tables[0][data[i]]++;
+
+	for (size_t j = 0; j < 256; j++)
+		counts[j] = tables[0][j] + tables[1][j] + tables[2][j] + tables[3][j];
+}
+
+
+// Entropy is computed as log2(n) - sum(c * log2(c)) / n, with c * log2(c) looked up for small counts
+static double CountLog2(uint32_t count)
+{
+	struct Table
+	{
+		double values[ENTROPY_LOG_TABLE_SIZE];
+		Table()
+		{
+			values[0] = 0;
+			for (size_t i = 1; i < ENTROPY_LOG_TABLE_SIZE; i++)
+				values[i] = (double)i * log2((double)i);
+		}
+	};
+	static const Table table;
+
+	if (count < ENTROPY_LOG_TABLE_SIZE)
+		return table.values[count];
+	return (double)count * log2((double)count);
+}
+
+
+float EntropyCache::ComputeEntropy(const uint8_t* data, size_t len)
+{
+	if (len == 0)
+		return 0;
+
+	uint32_t counts[256];
+	ComputeHistogram(data, len, counts);
+
+	double sum = 0;
+	for (size_t i = 0; i < 256; i++)
+		sum += CountLog2(counts[i]);
+	double entropy = log2((double)len) - (sum / (double)len);
+	return (float)(max(entropy, 0.0) / 8);
+}
+
+
+// Matches the block layout to the current extent of the view. Blocks before the first changed block keep their
+// values, everything after it is invalidated and the pyramid is rebuilt.
+void EntropyCache::ResizeLocked(uint64_t changed)
+{
+	uint64_t start = m_view->GetStart();
+	uint64_t end = m_view->GetEnd();
+	size_t count = (end > start) ? (size_t)(((end - start) + m_blockSize - 1) / m_blockSize) : 0;
+
+	size_t keep = 0;
+	if (start == m_start)
+		keep = min(m_blockCount, (changed > start) ? (size_t)((changed - start) / m_blockSize) : 0);
+
+	m_start = start;
+	m_blockCount = count;
+	m_epoch++;
+	m_blocks.resize(count, 0);
+	m_valid.resize(count, false);
+	m_epochs.resize(count, 0);
+	for (size_t i = keep; i < count; i++)
+	{
+		m_valid[i] = false;
+		m_epochs[i] = ++m_epoch;
+	}
+
+	m_levels.clear();
+	m_dirty.clear();
+	for (size_t levelCount = count; levelCount > 1; )
+	{
+		levelCount = (levelCount + 1) / 2;
+		m_levels.push_back(vector<double>(levelCount, 0));
+		m_dirty.push_back(vector<bool>(levelCount, true));
+	}
+}
+
+
+void EntropyCache::InvalidateLocked(uint64_t start, uint64_t end)
+{
+	if ((end <= m_start) || (start >= end) || (m_blockCount == 0))
+		return;
+
+	size_t first = (start > m_start) ? (size_t)((start - m_start) / m_blockSize) : 0;
+	size_t last = (size_t)min<uint64_t>(((end - m_start) + m_blockSize - 1) / m_blockSize, m_blockCount);
+	if (first >= last)
+		return;
+
+	for (size_t i = first; i < last; i++)
+	{
+		m_valid[i] = false;
+		m_epochs[i] = ++m_epoch;
+	}
+	MarkDirtyLocked(first, last);
+}
+
+
+void EntropyCache::MarkDirtyLocked(size_t first, size_t last)
+{
+	for (auto& level : m_dirty)
+	{
+		first /= 2;
+		last = (last - 1) / 2;
+		for (size_t i = first; i <= last; i++)
+			level[i] = true;
+		last++;
+	}
+}
+
+
+// Computes the missing blocks in [first, last) on worker threads. The lock is not held while reading, so a
+// result is only stored if its block was not invalidated in the meantime.
+void EntropyCache::ComputeBlocks(size_t first, size_t last)
+{
+	struct Task
+	{
+		size_t first, count;
+		uint64_t start;
+		vector<uint32_t> epochs;
+		vector<float> values;
+	};
+
+	vector<Task> tasks;
+	{
+		unique_lock<mutex> lock(m_mutex);
+		last = min(last, m_blockCount);
+		for (size_t i = first; i < last; i++)
+		{
+			if (m_valid[i])
+				continue;
+			if (tasks.empty() || ((tasks.back().first + tasks.back().count) != i) ||
+				(tasks.back().count >= ENTROPY_BLOCKS_PER_TASK))
+			{
+				Task task;
+				task.first = i;
+				task.count = 0;
+				task.start = m_start + ((uint64_t)i * m_blockSize);
+				tasks.push_back(task);
+			}
+			tasks.back().count++;
+			tasks.back().epochs.push_back(m_epochs[i]);
+		}
+	}
+	if (tasks.empty())
+		return;
+
+	WorkerParallelFor(tasks.size(), [&](size_t i) {
+			Task& task = tasks[i];
+			vector<uint8_t> buffer(task.count * m_blockSize);
+			size_t len = m_view->Read(buffer.data(), task.start, buffer.size());
+			task.values.resize(task.count);
+			for (size_t j = 0; j < task.count; j++)
+			{
+				size_t offset = j * m_blockSize;
+				size_t blockLen = (len > offset) ? min(len - offset, m_blockSize) : 0;
+				task.values[j] = ComputeEntropy(&buffer[offset], blockLen);
+			}
+		}, m_threadCount);
+
+	unique_lock<mutex> lock(m_mutex);
+	for (auto& task : tasks)
+	{
+		for (size_t j = 0; j < task.count; j++)
+		{
+			size_t block = task.first + j;
+			if ((block >= m_blockCount) || (m_epochs[block] != task.epochs[j]))
+				continue;
+			m_blocks[block] = task.values[j];
+			m_valid[block] = true;
+		}
+		if (task.first < m_blockCount)
+			MarkDirtyLocked(task.first, min(task.first + task.count, m_blockCount));
+	}
+}
+
+
+// Returns the sum of the blocks under a pyramid node, where level zero is the blocks themselves
+double EntropyCache::GetSumLocked(size_t level, size_t index)
+{
+	if (level == 0)
+		return m_blocks[index];
+
+	vector<bool>& dirty = m_dirty[level - 1];
+	if (dirty[index])
+	{
+		size_t childCount = (level == 1) ? m_blockCount : m_levels[level - 2].size();
+		double sum = GetSumLocked(level - 1, index * 2);
+		if (((index * 2) + 1) < childCount)
+			sum += GetSumLocked(level - 1, (index * 2) + 1);
+		m_levels[level - 1][index] = sum;
+		dirty[index] = false;
+	}
+	return m_levels[level - 1][index];
+}
+
+
+double EntropyCache::GetRangeSumLocked(size_t first, size_t last)
+{
+	double sum = 0;
+	for (size_t level = 0; first < last; level++)
+	{
+		if (first & 1)
+			sum += GetSumLocked(level, first++);
+		if (last & 1)
+			sum += GetSumLocked(level, --last);
+		first /= 2;
+		last /= 2;
+	}
+	return sum;
+}
+
+
+vector<float> EntropyCache::GetBlockEntropy(uint64_t start, uint64_t end)
+{
+	size_t first, last;
+	{
+		unique_lock<mutex> lock(m_mutex);
+		if ((end <= m_start) || (start >= end))
+			return vector<float>();
+		first = (start > m_start) ? (size_t)min<uint64_t>((start - m_start) / m_blockSize, m_blockCount) : 0;
+		last = (size_t)min<uint64_t>(((end - m_start) + m_blockSize - 1) / m_blockSize, m_blockCount);
+	}
+
+	ComputeBlocks(first, last);
+
+	unique_lock<mutex> lock(m_mutex);
+	last = min(last, m_blockCount);
+	if (first >= last)
+		return vector<float>();
+	return vector<float>(m_blocks.begin() + first, m_blocks.begin() + last);
+}
+
+
+vector<float> EntropyCache::GetOverview(uint64_t start, uint64_t end, size_t columns)
+{
+	if ((columns == 0) || (start >= end))
+		return vector<float>();
+
+	size_t first, last;
+	{
+		unique_lock<mutex> lock(m_mutex);
+		start = max(start, m_start);
+		end = min(end, m_start + ((uint64_t)m_blockCount * m_blockSize));
+		if (start >= end)
+			return vector<float>(columns, 0);
+		first = (size_t)((start - m_start) / m_blockSize);
+		last = (size_t)(((end - m_start) + m_blockSize - 1) / m_blockSize);
+	}
+
+	ComputeBlocks(first, last);
+
+	vector<float> result(columns, 0);
+	uint64_t span = end - start;
+	uint64_t step = span / columns;
+	uint64_t remainder = span % columns;
+	unique_lock<mutex> lock(m_mutex);
+	for (size_t i = 0; i < columns; i++)
+	{
+		uint64_t columnStart = start + (step * i) + ((remainder * i) / columns);
+		uint64_t columnEnd = start + (step * (i + 1)) + ((remainder * (i + 1)) / columns);
+		size_t a = (size_t)((columnStart - m_start) / m_blockSize);
+		size_t b = (size_t)(((columnEnd - m_start) + m_blockSize - 1) / m_blockSize);
+		b = min(max(b, a + 1), m_blockCount);
+		if (a >= b)
+			continue;
+		result[i] = (float)(GetRangeSumLocked(a, b) / (double)(b - a));
+	}
+	return result;
+}
+
+
+void EntropyCache::Invalidate(uint64_t start, uint64_t end)
+{
+	unique_lock<mutex> lock(m_mutex);
+	InvalidateLocked(start, end);
+}
+
+
+uint32_t EntropyCache::GetChangeCount()
+{
+	unique_lock<mutex> lock(m_mutex);
+	return m_epoch;
+}
+
+
+void EntropyCache::InvalidateAll()
+{
+	unique_lock<mutex> lock(m_mutex);
+	m_blockCount = 0;
+	ResizeLocked(0);
+}
+
+
+void EntropyCache::OnBinaryDataWritten(BinaryView*, uint64_t offset, size_t len)
+{
+	Invalidate(offset, offset + len);
+}
+
+
+void EntropyCache::OnBinaryDataInserted(BinaryView*, uint64_t offset, size_t)
+{
+	unique_lock<mutex> lock(m_mutex);
+	ResizeLocked(offset);
+}
+
+
+void EntropyCache::OnBinaryDataRemoved(BinaryView*, uint64_t offset, uint64_t)
+{
+	unique_lock<mutex> lock(m_mutex);
+	ResizeLocked(offset);
+}
@@ -0,0 +1,321 @@
+/*
+ * Compares the API's Base64, escape string and zlib stream codecs with
+ * the core implementations they replace on a buffer of the given size.
+ * The zlib streams are first checked for round trips with the core.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include "binaryninjacore.h"
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+template <typename F>
+double time_ms(size_t iterations, F func)
+{
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+        func();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(end - start).count() / iterations;
+}
+
+void report(const char* name, size_t bytes, double core_ms, double api_ms)
+{
+    double mb = bytes / (1024.0 * 1024.0);
+    cout << setw(22) << left << name << fixed << setprecision(1)
+         << setw(10) << right << (mb * 1000.0 / core_ms) << " MB/s core"
+         << setw(10) << right << (mb * 1000.0 / api_ms) << " MB/s api"
+         << setw(8) << right << setprecision(2) << (core_ms / api_ms) << "x" << endl;
+}
+
+struct bit_writer
+{
+    vector<uint8_t> out;
+    uint32_t bits = 0;
+    int count = 0;
+
+    void put(uint32_t value, int n)
+    {
+        bits |= value << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back((uint8_t)bits);
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    // Huffman codes are stored starting from their most significant bit
+    void put_code(uint32_t code, int n)
+    {
+        uint32_t reversed = 0;
+        for (int i = 0; i < n; i++)
+            reversed |= ((code >> i) & 1) << (n - 1 - i);
+        put(reversed, n);
+    }
+
+    void align()
+    {
+        if (count != 0)
+            put(0, 8 - count);
+    }
+};
+
+uint32_t adler32(const uint8_t* data, size_t len)
+{
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < len; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+DataBuffer finish_zlib_stream(bit_writer& writer, const vector<uint8_t>& expected)
+{
+    writer.align();
+    uint32_t adler = adler32(expected.data(), expected.size());
+    for (int shift = 24; shift >= 0; shift -= 8)
+        writer.out.push_back((uint8_t)(adler >> shift));
+    return DataBuffer(writer.out.data(), writer.out.size());
+}
+
+// Two stored blocks, the first not final
+DataBuffer make_stored_stream(const uint8_t* data, size_t len, vector<uint8_t>& expected)
+{
+    bit_writer writer;
+    writer.out = {0x78, 0x01};
+    size_t split = len / 2;
+    for (int block = 0; block < 2; block++) {
+        const uint8_t* start = data + (block ? split : 0);
+        uint16_t size = (uint16_t)(block ? (len - split) : split);
+        writer.put(block, 1);
+        writer.put(0, 2);
+        writer.align();
+        writer.put(size, 16);
+        writer.put((uint16_t)~size, 16);
+        writer.out.insert(writer.out.end(), start, start + size);
+        expected.insert(expected.end(), start, start + size);
+    }
+    return finish_zlib_stream(writer, expected);
+}
+
+// One block with the fixed Huffman codes, mixing literals and length 10 copies from distance 3
+DataBuffer make_fixed_stream(const uint8_t* data, size_t len, vector<uint8_t>& expected)
+{
+    bit_writer writer;
+    writer.out = {0x78, 0x01};
+    writer.put(1, 1);
+    writer.put(1, 2);
+    for (size_t i = 0; i < len; i++) {
+        uint8_t value = data[i];
+        if (value < 144)
+            writer.put_code(0x30 + value, 8);
+        else
+            writer.put_code(0x190 + (value - 144), 9);
+        expected.push_back(value);
+        if ((i % 100) == 99) {
+            writer.put_code(264 - 256, 7);
+            writer.put_code(2, 5);
+            for (int j = 0; j < 10; j++)
+                expected.push_back(expected[expected.size() - 3]);
+        }
+    }
+    writer.put_code(0, 7);
+    return finish_zlib_stream(writer, expected);
+}
+
+bool inflate_matches(const DataBuffer& compressed, const uint8_t* expected, size_t len, size_t chunk)
+{
+    vector<uint8_t> output;
+    ZlibDecompressor decompressor([&](const void* data, size_t n) {
+        output.insert(output.end(), (const uint8_t*)data, (const uint8_t*)data + n);
+        return true;
+    });
+    const uint8_t* input = (const uint8_t*)compressed.GetData();
+    for (size_t i = 0; i < compressed.GetLength(); i += chunk) {
+        if (!decompressor.Write(input + i, min(chunk, compressed.GetLength() - i)))
+            return false;
+    }
+    if (!decompressor.Finish() || !decompressor.IsComplete())
+        return false;
+    return (output.size() == len) && ((len == 0) || (memcmp(output.data(), expected, len) == 0));
+}
+
+DataBuffer deflate_stream(const uint8_t* data, size_t len, size_t threads, size_t block_size, size_t chunk)
+{
+    DataBuffer output;
+    ZlibCompressor compressor([&](const void* data, size_t n) {
+        output.Append(data, n);
+        return true;
+    }, threads, block_size);
+    for (size_t i = 0; i < len; i += chunk)
+        compressor.Write(data + i, min(chunk, len - i));
+    compressor.Finish();
+    return output;
+}
+
+bool core_inflate_matches(const DataBuffer& compressed, const uint8_t* expected, size_t len)
+{
+    DataBuffer output;
+    if (!compressed.ZlibDecompress(output))
+        return false;
+    return (output.GetLength() == len) && ((len == 0) || (memcmp(output.GetData(), expected, len) == 0));
+}
+
+void check(bool ok, const char* name)
+{
+    if (!ok) {
+        cerr << "Error: zlib check failed: " << name << endl;
+        exit(-1);
+    }
+}
+
+void check_zlib(const uint8_t* binary, const uint8_t* text, size_t size)
+{
+    size_t sample = min(size, (size_t)(256 * 1024));
+    size_t threads = max(2u, thread::hardware_concurrency());
+    vector<uint8_t> expected;
+
+    DataBuffer stored = make_stored_stream(text, min(sample, (size_t)60000), expected);
+    check(core_inflate_matches(stored, expected.data(), expected.size()), "stored blocks, core");
+    check(inflate_matches(stored, expected.data(), expected.size(), 1), "stored blocks, 1 byte chunks");
+
+    expected.clear();
+    DataBuffer fixed = make_fixed_stream(binary, min(sample, (size_t)10000), expected);
+    check(core_inflate_matches(fixed, expected.data(), expected.size()), "fixed block, core");
+    check(inflate_matches(fixed, expected.data(), expected.size(), 1), "fixed block, 1 byte chunks");
+    check(inflate_matches(fixed, expected.data(), expected.size(), 4096), "fixed block");
+
+    // The core emits dynamic blocks for the text and stored blocks for the random data
+    for (const uint8_t* data : {text, binary}) {
+        DataBuffer compressed;
+        check(DataBuffer(data, sample).ZlibCompress(compressed), "core compress");
+        check(inflate_matches(compressed, data, sample, 1), "core stream, 1 byte chunks");
+        check(inflate_matches(compressed, data, sample, 65536), "core stream");
+
+        compressed = DataBuffer();
+        check(DataBuffer(data, size).ZlibCompress(compressed), "core compress");
+        check(inflate_matches(compressed, data, size, 1024 * 1024), "core stream, full size");
+
+        compressed = deflate_stream(data, size, threads, 64 * 1024 + 17, 1000003);
+        check(core_inflate_matches(compressed, data, size), "multi-block stream, core");
+        check(inflate_matches(compressed, data, size, 1024 * 1024), "multi-block stream");
+
+        compressed = deflate_stream(data, sample, 1, 4096, 1);
+        check(core_inflate_matches(compressed, data, sample), "single thread stream, 1 byte chunks, core");
+    }
+
+    DataBuffer empty = deflate_stream(nullptr, 0, threads, 4096, 1);
+    check(core_inflate_matches(empty, nullptr, 0), "empty stream, core");
+    check(inflate_matches(empty, nullptr, 0, 1), "empty stream");
+
+    // A corrupted checksum must be reported
+    fixed[fixed.GetLength() - 1] ^= 1;
+    check(!inflate_matches(fixed, expected.data(), expected.size(), 4096), "corrupt checksum rejected");
+}
+
+int main(int argc, char *argv[])
+{
+    size_t size_mb = 100;
+    size_t iterations = 5;
+    if (argc > 1)
+        size_mb = strtoul(argv[1], nullptr, 0);
+    if (argc > 2)
+        iterations = strtoul(argv[2], nullptr, 0);
+    if (size_mb == 0 || iterations == 0) {
+        cerr << "USAGE: " << argv[0] << " [size_in_mb] [iterations]" << endl;
+        exit(-1);
+    }
+
+    size_t size = size_mb * 1024 * 1024;
+    DataBuffer binary(size);
+    DataBuffer text(size);
+    uint8_t* binary_data = (uint8_t*)binary.GetData();
+    uint8_t* text_data = (uint8_t*)text.GetData();
+    uint32_t state = 0x12345678;
+    for (size_t i = 0; i < size; i++) {
+        state = state * 1103515245 + 12345;
+        binary_data[i] = (uint8_t)(state >> 16);
+        text_data[i] = (uint8_t)('a' + ((state >> 16) % 26));
+    }
+
+    check_zlib(binary_data, text_data, size);
+
+    string encoded = binary.ToBase64();
+    char* core_encoded = BNDataBufferToBase64(binary.GetBufferObject());
+    bool match = encoded == core_encoded;
+    BNFreeString(core_encoded);
+    if (!match) {
+        cerr << "Error: Base64 output differs from the core" << endl;
+        exit(-1);
+    }
+
+    double core_ms = time_ms(iterations, [&]() {
+        BNFreeString(BNDataBufferToBase64(binary.GetBufferObject()));
+    });
+    double api_ms = time_ms(iterations, [&]() {
+        binary.ToBase64();
+    });
+    report("Base64 encode", size, core_ms, api_ms);
+
+    core_ms = time_ms(iterations, [&]() {
+        BNFreeDataBuffer(BNDecodeBase64(encoded.c_str()));
+    });
+    api_ms = time_ms(iterations, [&]() {
+        DataBuffer::FromBase64(encoded);
+    });
+    report("Base64 decode", size, core_ms, api_ms);
+
+    core_ms = time_ms(iterations, [&]() {
+        BNFreeString(BNDataBufferToEscapedString(text.GetBufferObject()));
+    });
+    api_ms = time_ms(iterations, [&]() {
+        text.ToEscapedString();
+    });
+    report("Escape (printable)", size, core_ms, api_ms);
+
+    string plain((const char*)text_data, size);
+    core_ms = time_ms(iterations, [&]() {
+        BNFreeDataBuffer(BNDecodeEscapedString(plain.c_str()));
+    });
+    api_ms = time_ms(iterations, [&]() {
+        UnescapeString(plain);
+    });
+    report("Unescape (no escapes)", size, core_ms, api_ms);
+
+    size_t threads = max(1u, thread::hardware_concurrency());
+    DataBuffer compressed;
+    text.ZlibCompress(compressed);
+    core_ms = time_ms(iterations, [&]() {
+        DataBuffer output;
+        text.ZlibCompress(output);
+    });
+    api_ms = time_ms(iterations, [&]() {
+        deflate_stream(text_data, size, threads, ZlibCompressor::DefaultBlockSize, size);
+    });
+    report("Zlib compress", size, core_ms, api_ms);
+
+    core_ms = time_ms(iterations, [&]() {
+        DataBuffer output;
+        compressed.ZlibDecompress(output);
+    });
+    api_ms = time_ms(iterations, [&]() {
+        ZlibDecompressor decompressor([](const void*, size_t) { return true; });
+        decompressor.Write(compressed.GetData(), compressed.GetLength());
+        decompressor.Finish();
+    });
+    report("Zlib decompress", size, core_ms, api_ms);
+
+    return 0;
+}
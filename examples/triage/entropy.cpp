@@ -5,13 +5,19 @@
 #include "theme.h"
 
 
-EntropyThread::EntropyThread(BinaryViewRef data, int width, size_t blockSize)
+EntropyThread::EntropyThread(BinaryViewRef data, BinaryNinja::EntropyCache* cache, int width, size_t blockSize,
+	const QImage* previous)
 {
 	m_data = data;
-	m_image = QImage(width, 1, QImage::Format_ARGB32);
+	m_cache = cache;
+	if (previous)
+		m_image = previous->copy();
+	else
+		m_image = QImage(width, 1, QImage::Format_ARGB32);
 	m_blockSize = blockSize;
 	m_updated = false;
 	m_running = true;
+	m_finished = false;
 	m_thread = std::thread([=]() { Run(); });
 }
 
@@ -25,31 +31,39 @@ EntropyThread::~EntropyThread()
 
 void EntropyThread::Run()
 {
+	// Columns are computed in batches so that the image fills in progressively and stopping stays responsive
+	static const int batchSize = 256;
 	int width = m_image.width();
-	for (int i = 0; i < width; i++)
+	for (int i = 0; i < width; i += batchSize)
 	{
 		if (!m_running)
 			break;
-		std::vector<float> entropy = m_data->GetEntropy(m_data->GetStart() + ((uint64_t)i * m_blockSize), m_blockSize, m_blockSize);
-		int v;
-		if (entropy.size() == 0)
-			v = 0;
-		else
-			v = (int)(entropy[0] * 255);
-		if (v >= 240)
+		int count = std::min(batchSize, width - i);
+		uint64_t start = m_data->GetStart() + ((uint64_t)i * m_blockSize);
+		std::vector<float> entropy = m_cache->GetOverview(start, start + ((uint64_t)count * m_blockSize), count);
+		for (int j = 0; j < count; j++)
 		{
-			QColor color = getThemeColor(YellowStandardHighlightColor);
-			m_image.setPixelColor(i, 0, color);
-		}
-		else
-		{
-			QColor baseColor = getThemeColor(FeatureMapBaseColor);
-			QColor entropyColor = getThemeColor(BlueStandardHighlightColor);
-			QColor color = mixColor(baseColor, entropyColor, (uint8_t)v);
-			m_image.setPixelColor(i, 0, color);
+			int v;
+			if ((size_t)j >= entropy.size())
+				v = 0;
+			else
+				v = (int)(entropy[j] * 255);
+			if (v >= 240)
+			{
+				QColor color = getThemeColor(YellowStandardHighlightColor);
+				m_image.setPixelColor(i + j, 0, color);
+			}
+			else
+			{
+				QColor baseColor = getThemeColor(FeatureMapBaseColor);
+				QColor entropyColor = getThemeColor(BlueStandardHighlightColor);
+				QColor color = mixColor(baseColor, entropyColor, (uint8_t)v);
+				m_image.setPixelColor(i + j, 0, color);
+			}
 		}
 		m_updated = true;
 	}
+	m_finished = true;
 }
 
 
@@ -61,7 +75,11 @@ EntropyWidget::EntropyWidget(QWidget* parent, TriageView* view, BinaryViewRef da
 
 	m_blockSize = 1024;
 	m_width = (int)(m_rawData->GetLength() / (uint64_t)m_blockSize);
-	m_thread = new EntropyThread(m_rawData, m_width, m_blockSize);
+
+	// The cache lives as long as the widget, so redraws after a change only recompute the modified blocks
+	m_cache = std::unique_ptr<BinaryNinja::EntropyCache>(new BinaryNinja::EntropyCache(m_rawData, m_blockSize));
+	m_drawnChangeCount = m_cache->GetChangeCount();
+	m_thread = new EntropyThread(m_rawData, m_cache.get(), m_width, m_blockSize);
 
 	QTimer* timer = new QTimer();
 	connect(timer, &QTimer::timeout, this, &EntropyWidget::timerExpired);
@@ -100,6 +118,15 @@ void EntropyWidget::timerExpired()
 		m_thread->ResetUpdated();
 		update();
 	}
+
+	if (m_thread->IsFinished() && (m_cache->GetChangeCount() != m_drawnChangeCount))
+	{
+		m_drawnChangeCount = m_cache->GetChangeCount();
+		EntropyThread* thread = new EntropyThread(m_rawData, m_cache.get(), m_width, m_blockSize,
+			&m_thread->GetImage());
+		delete m_thread;
+		m_thread = thread;
+	}
 }
 
 
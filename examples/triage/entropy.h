@@ -2,6 +2,7 @@
 
 #include <QtWidgets/QWidget>
 #include <QtGui/QImage>
+#include <memory>
 #include <thread>
 #include "uitypes.h"
 
@@ -9,18 +10,21 @@
 class EntropyThread
 {
 	BinaryViewRef m_data;
+	BinaryNinja::EntropyCache* m_cache;
 	QImage m_image;
 	size_t m_blockSize;
-	bool m_updated, m_running;
+	bool m_updated, m_running, m_finished;
 	std::thread m_thread;
 
 public:
-	EntropyThread(BinaryViewRef data, int width, size_t blockSize);
+	EntropyThread(BinaryViewRef data, BinaryNinja::EntropyCache* cache, int width, size_t blockSize,
+		const QImage* previous = nullptr);
 	~EntropyThread();
 
 	void Run();
 	bool IsUpdated() { return m_updated; }
 	void ResetUpdated() { m_updated = false; }
+	bool IsFinished() { return m_finished; }
 
 	const QImage& GetImage() { return m_image; }
 };
@@ -34,6 +38,8 @@ class EntropyWidget: public QWidget
 	BinaryViewRef m_data, m_rawData;
 	size_t m_blockSize;
 	int m_width;
+	std::unique_ptr<BinaryNinja::EntropyCache> m_cache;
+	uint32_t m_drawnChangeCount;
 	EntropyThread* m_thread;
 
 public:
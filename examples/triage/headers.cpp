@@ -6,6 +6,97 @@
 #include "viewframe.h"
 
 
+struct PECOFFHeader
+{
+	uint16_t machine;
+	uint16_t numberOfSections;
+	uint32_t timeDateStamp;
+	uint16_t sizeOfOptionalHeader;
+	uint16_t characteristics;
+};
+
+// Offsets are from the "PE\0\0" signature, which directly precedes the COFF header
+typedef BinaryNinja::StructLayout<PECOFFHeader,
+	BinaryNinja::StructField<PECOFFHeader, uint16_t, &PECOFFHeader::machine, 4>,
+	BinaryNinja::StructField<PECOFFHeader, uint16_t, &PECOFFHeader::numberOfSections, 6>,
+	BinaryNinja::StructField<PECOFFHeader, uint32_t, &PECOFFHeader::timeDateStamp, 8>,
+	BinaryNinja::StructField<PECOFFHeader, uint16_t, &PECOFFHeader::sizeOfOptionalHeader, 20>,
+	BinaryNinja::StructField<PECOFFHeader, uint16_t, &PECOFFHeader::characteristics, 22>> PECOFFHeaderLayout;
+
+struct PEOptionalHeader
+{
+	uint64_t majorLinkerVersion, minorLinkerVersion;
+	uint64_t sizeOfCode, sizeOfInitializedData, sizeOfUninitializedData;
+	uint64_t addressOfEntryPoint, baseOfCode, baseOfData, imageBase;
+	uint64_t sectionAlignment, fileAlignment;
+	uint64_t majorOperatingSystemVersion, minorOperatingSystemVersion;
+	uint64_t majorImageVersion, minorImageVersion;
+	uint64_t majorSubsystemVersion, minorSubsystemVersion;
+	uint64_t sizeOfImage, sizeOfHeaders, checkSum, subsystem, dllCharacteristics;
+	uint64_t sizeOfStackReserve, sizeOfStackCommit, sizeOfHeapReserve, sizeOfHeapCommit;
+};
+
+template <uint64_t PEOptionalHeader::*Member, uint64_t Offset, size_t Width>
+using PEOptionalHeaderField = BinaryNinja::StructField<PEOptionalHeader, uint64_t, Member, Offset, Width>;
+
+// PE32 and PE32+ optional headers share a structure, but PE32+ drops baseOfData and widens the image base
+// and the stack and heap sizes to 64 bits
+typedef BinaryNinja::StructLayout<PEOptionalHeader,
+	PEOptionalHeaderField<&PEOptionalHeader::majorLinkerVersion, 2, 1>,
+	PEOptionalHeaderField<&PEOptionalHeader::minorLinkerVersion, 3, 1>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfCode, 4, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfInitializedData, 8, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfUninitializedData, 12, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::addressOfEntryPoint, 16, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::baseOfCode, 20, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::baseOfData, 24, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::imageBase, 28, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::sectionAlignment, 32, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::fileAlignment, 36, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::majorOperatingSystemVersion, 40, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::minorOperatingSystemVersion, 42, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::majorImageVersion, 44, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::minorImageVersion, 46, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::majorSubsystemVersion, 48, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::minorSubsystemVersion, 50, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfImage, 56, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfHeaders, 60, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::checkSum, 64, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::subsystem, 68, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::dllCharacteristics, 70, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfStackReserve, 72, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfStackCommit, 76, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfHeapReserve, 80, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfHeapCommit, 84, 4>> PE32OptionalHeaderLayout;
+
+typedef BinaryNinja::StructLayout<PEOptionalHeader,
+	PEOptionalHeaderField<&PEOptionalHeader::majorLinkerVersion, 2, 1>,
+	PEOptionalHeaderField<&PEOptionalHeader::minorLinkerVersion, 3, 1>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfCode, 4, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfInitializedData, 8, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfUninitializedData, 12, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::addressOfEntryPoint, 16, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::baseOfCode, 20, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::imageBase, 24, 8>,
+	PEOptionalHeaderField<&PEOptionalHeader::sectionAlignment, 32, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::fileAlignment, 36, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::majorOperatingSystemVersion, 40, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::minorOperatingSystemVersion, 42, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::majorImageVersion, 44, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::minorImageVersion, 46, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::majorSubsystemVersion, 48, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::minorSubsystemVersion, 50, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfImage, 56, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfHeaders, 60, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::checkSum, 64, 4>,
+	PEOptionalHeaderField<&PEOptionalHeader::subsystem, 68, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::dllCharacteristics, 70, 2>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfStackReserve, 72, 8>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfStackCommit, 80, 8>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfHeapReserve, 88, 8>,
+	PEOptionalHeaderField<&PEOptionalHeader::sizeOfHeapCommit, 96, 8>> PE64OptionalHeaderLayout;
+
+
 NavigationLabel::NavigationLabel(const QString& text, QColor color, const std::function<void()>& func):
 	QLabel(text), m_func(func)
 {
@@ -81,21 +172,20 @@ GenericHeaders::GenericHeaders(BinaryViewRef data)
 
 PEHeaders::PEHeaders(BinaryViewRef data)
 {
-	uint64_t peOffset = data->GetStart() + GetValueOfStructMember(data, "DOS_Header", data->GetStart(), "e_lfanew");
-	uint64_t optHeaderStart = GetAddressAfterStruct(data, "COFF_Header", peOffset);
+	uint32_t peOffsetValue = 0;
+	data->Read(&peOffsetValue, data->GetStart() + 0x3c, sizeof(peOffsetValue));
+	uint64_t peOffset = data->GetStart() + peOffsetValue;
+	uint64_t optHeaderStart = peOffset + PECOFFHeaderLayout::Size;
 
 	BinaryNinja::DataBuffer peMagic = data->ReadBuffer(optHeaderStart, 2);
 	bool is64bit;
-	std::string optHeaderName;
 	if ((peMagic.GetLength() == 2) && (peMagic[0] == 0x0b) && (peMagic[1] == 0x01))
 	{
-		optHeaderName = "PE32_Optional_Header";
 		AddField("Type", "PE 32-bit");
 		is64bit = false;
 	}
 	else if ((peMagic.GetLength() == 2) && (peMagic[0] == 0x0b) && (peMagic[1] == 0x02))
 	{
-		optHeaderName = "PE64_Optional_Header";
 		AddField("Type", "PE 64-bit");
 		is64bit = true;
 	}
@@ -109,92 +199,68 @@ PEHeaders::PEHeaders(BinaryViewRef data)
 		return;
 	}
 
-	uint64_t machineValue = GetValueOfStructMember(data, "COFF_Header", peOffset, "machine");
-	QString machineName = GetNameOfEnumerationMember(data, "coff_machine", machineValue);
+	// Each header is fetched with a single read and decoded locally
+	PECOFFHeader coff;
+	PEOptionalHeader opt;
+	if (!PECOFFHeaderLayout::TryRead(data, peOffset, coff, LittleEndian))
+		return;
+	if (is64bit ? !PE64OptionalHeaderLayout::TryRead(data, optHeaderStart, opt, LittleEndian) :
+		!PE32OptionalHeaderLayout::TryRead(data, optHeaderStart, opt, LittleEndian))
+		return;
+
+	QString machineName = GetNameOfEnumerationMember(data, "coff_machine", coff.machine);
 	if (machineName.startsWith("IMAGE_FILE_MACHINE_"))
 		machineName = machineName.mid(strlen("IMAGE_FILE_MACHINE_"));
 	AddField("Machine", machineName);
 
-	uint64_t subsysValue = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "subsystem");
-	QString subsysName = GetNameOfEnumerationMember(data, "pe_subsystem", subsysValue);
+	QString subsysName = GetNameOfEnumerationMember(data, "pe_subsystem", opt.subsystem);
 	if (subsysName.startsWith("IMAGE_SUBSYSTEM_"))
 		subsysName = subsysName.mid(strlen("IMAGE_SUBSYSTEM_"));
 	AddField("Subsystem", subsysName);
 
-	uint64_t secs = GetValueOfStructMember(data, "COFF_Header", peOffset, "timeDateStamp");
-	QDateTime t = QDateTime::fromSecsSinceEpoch(secs);
+	QDateTime t = QDateTime::fromSecsSinceEpoch(coff.timeDateStamp);
 	AddField("Timestamp", t.toString());
 
-	uint64_t base = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "imageBase");
+	uint64_t base = opt.imageBase;
 	AddField("Image Base", QString("0x") + QString::number(base, 16), AddressHeaderField);
 
-	uint64_t entryPoint = base + GetValueOfStructMember(data, optHeaderName, optHeaderStart, "addressOfEntryPoint");
+	uint64_t entryPoint = base + opt.addressOfEntryPoint;
 	AddField("Entry Point", QString("0x") + QString::number(entryPoint, 16), CodeHeaderField);
 
-	uint64_t sectionAlign = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "sectionAlignment");
-	AddField("Section Alignment", QString("0x") + QString::number(sectionAlign, 16));
-
-	uint64_t fileAlign = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "fileAlignment");
-	AddField("File Alignment", QString("0x") + QString::number(fileAlign, 16));
+	AddField("Section Alignment", QString("0x") + QString::number(opt.sectionAlignment, 16));
+	AddField("File Alignment", QString("0x") + QString::number(opt.fileAlignment, 16));
+	AddField("Checksum", QString("0x") + QString::number(opt.checkSum, 16));
 
-	uint64_t checksum = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "checkSum");
-	AddField("Checksum", QString("0x") + QString::number(checksum, 16));
-
-	uint64_t codeBase = base + GetValueOfStructMember(data, optHeaderName, optHeaderStart, "baseOfCode");
+	uint64_t codeBase = base + opt.baseOfCode;
 	AddField("Base of Code", QString("0x") + QString::number(codeBase, 16), AddressHeaderField);
 
 	if (!is64bit)
 	{
-		uint64_t dataBase = base + GetValueOfStructMember(data, optHeaderName, optHeaderStart, "baseOfData");
+		uint64_t dataBase = base + opt.baseOfData;
 		AddField("Base of Data", QString("0x") + QString::number(dataBase, 16), AddressHeaderField);
 	}
 
-	uint64_t codeSize = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "sizeOfCode");
-	AddField("Size of Code", QString("0x") + QString::number(codeSize, 16));
-
-	uint64_t initDataSize = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "sizeOfInitializedData");
-	AddField("Size of Init Data", QString("0x") + QString::number(initDataSize, 16));
-
-	uint64_t uninitDataSize = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "sizeOfUninitializedData");
-	AddField("Size of Uninit Data", QString("0x") + QString::number(uninitDataSize, 16));
-
-	uint64_t headerSize = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "sizeOfHeaders");
-	AddField("Size of Headers", QString("0x") + QString::number(headerSize, 16));
-
-	uint64_t imageSize = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "sizeOfImage");
-	AddField("Size of Image", QString("0x") + QString::number(imageSize, 16));
-
-	uint64_t stackCommit = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "sizeOfStackCommit");
-	uint64_t stackReserve = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "sizeOfStackReserve");
-	AddField("Stack Size", QString("0x") + QString::number(stackCommit, 16) + QString(" / 0x") +
-		QString::number(stackReserve, 16));
-
-	uint64_t heapCommit = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "sizeOfHeapCommit");
-	uint64_t heapReserve = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "sizeOfHeapReserve");
-	AddField("Heap Size", QString("0x") + QString::number(heapCommit, 16) + QString(" / 0x") +
-		QString::number(heapReserve, 16));
-
-	uint64_t linkerMajor = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "majorLinkerVersion");
-	uint64_t linkerMinor = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "minorLinkerVersion");
-	AddField("Linker Version", QString::number(linkerMajor) + QString(".") +
-		QString::number(linkerMinor).rightJustified(2, '0'));
-
-	uint64_t imageMajor = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "majorImageVersion");
-	uint64_t imageMinor = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "minorImageVersion");
-	AddField("Image Version", QString::number(imageMajor) + QString(".") +
-		QString::number(imageMinor).rightJustified(2, '0'));
-
-	uint64_t osMajor = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "majorOperatingSystemVersion");
-	uint64_t osMinor = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "minorOperatingSystemVersion");
-	AddField("OS Version", QString::number(osMajor) + QString(".") +
-		QString::number(osMinor).rightJustified(2, '0'));
-
-	uint64_t subMajor = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "majorSubsystemVersion");
-	uint64_t subMinor = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "minorSubsystemVersion");
-	AddField("Subsystem Version", QString::number(subMajor) + QString(".") +
-		QString::number(subMinor).rightJustified(2, '0'));
-
-	uint64_t coffCharValue = GetValueOfStructMember(data, "COFF_Header", peOffset, "characteristics");
+	AddField("Size of Code", QString("0x") + QString::number(opt.sizeOfCode, 16));
+	AddField("Size of Init Data", QString("0x") + QString::number(opt.sizeOfInitializedData, 16));
+	AddField("Size of Uninit Data", QString("0x") + QString::number(opt.sizeOfUninitializedData, 16));
+	AddField("Size of Headers", QString("0x") + QString::number(opt.sizeOfHeaders, 16));
+	AddField("Size of Image", QString("0x") + QString::number(opt.sizeOfImage, 16));
+
+	AddField("Stack Size", QString("0x") + QString::number(opt.sizeOfStackCommit, 16) + QString(" / 0x") +
+		QString::number(opt.sizeOfStackReserve, 16));
+	AddField("Heap Size", QString("0x") + QString::number(opt.sizeOfHeapCommit, 16) + QString(" / 0x") +
+		QString::number(opt.sizeOfHeapReserve, 16));
+
+	AddField("Linker Version", QString::number(opt.majorLinkerVersion) + QString(".") +
+		QString::number(opt.minorLinkerVersion).rightJustified(2, '0'));
+	AddField("Image Version", QString::number(opt.majorImageVersion) + QString(".") +
+		QString::number(opt.minorImageVersion).rightJustified(2, '0'));
+	AddField("OS Version", QString::number(opt.majorOperatingSystemVersion) + QString(".") +
+		QString::number(opt.minorOperatingSystemVersion).rightJustified(2, '0'));
+	AddField("Subsystem Version", QString::number(opt.majorSubsystemVersion) + QString(".") +
+		QString::number(opt.minorSubsystemVersion).rightJustified(2, '0'));
+
+	uint64_t coffCharValue = coff.characteristics;
 	TypeRef coffCharEnum = data->GetTypeByName(BinaryNinja::QualifiedName("coff_characteristics"));
 	if (coffCharEnum && (coffCharEnum->GetClass() == EnumerationTypeClass))
 	{
@@ -213,7 +279,7 @@ PEHeaders::PEHeaders(BinaryViewRef data)
 			AddField("COFF Characteristics", coffCharValues);
 	}
 
-	uint64_t dllCharValue = GetValueOfStructMember(data, optHeaderName, optHeaderStart, "dllCharacteristics");
+	uint64_t dllCharValue = opt.dllCharacteristics;
 	TypeRef dllCharEnum = data->GetTypeByName(BinaryNinja::QualifiedName("pe_dll_characteristics"));
 	if (dllCharEnum && (dllCharEnum->GetClass() == EnumerationTypeClass))
 	{
@@ -237,41 +303,6 @@ PEHeaders::PEHeaders(BinaryViewRef data)
 }
 
 
-uint64_t PEHeaders::GetValueOfStructMember(BinaryViewRef data, const std::string& structName, uint64_t structStart,
-	const std::string& fieldName)
-{
-	TypeRef type = data->GetTypeByName(structName);
-	if (!type)
-		return 0;
-	if (type->GetClass() != StructureTypeClass)
-		return 0;
-	StructureRef s = type->GetStructure();
-	for (auto& member: s->GetMembers())
-	{
-		if (member.name == fieldName)
-		{
-			uint64_t offset = structStart + member.offset;
-			size_t width = member.type->GetWidth();
-			if (width > 8)
-				return 0;
-			uint64_t value = 0;
-			data->Read(&value, offset, width);
-			return value;
-		}
-	}
-	return 0;
-}
-
-
-uint64_t PEHeaders::GetAddressAfterStruct(BinaryViewRef data, const std::string& structName, uint64_t structStart)
-{
-	TypeRef type = data->GetTypeByName(structName);
-	if (!type)
-		return structStart;
-	return structStart + type->GetWidth();
-}
-
-
 QString PEHeaders::GetNameOfEnumerationMember(BinaryViewRef data, const std::string& enumName, uint64_t value)
 {
 	TypeRef type = data->GetTypeByName(enumName);
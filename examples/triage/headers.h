@@ -82,9 +82,6 @@ public:
 
 class PEHeaders: public Headers
 {
-	uint64_t GetValueOfStructMember(BinaryViewRef data, const std::string& structName, uint64_t structStart,
-		const std::string& fieldName);
-	uint64_t GetAddressAfterStruct(BinaryViewRef data, const std::string& structName, uint64_t structStart);
 	QString GetNameOfEnumerationMember(BinaryViewRef data, const std::string& enumName, uint64_t value);
 
 public:
@@ -56,7 +56,7 @@ Ref<BasicBlock> FlowGraphNode::GetBasicBlock() const
 	BNBasicBlock* block = BNGetFlowGraphBasicBlock(m_object);
 	if (!block)
 		return nullptr;
-	return new BasicBlock(block);
+	return BasicBlock::Intern(block);
 }
 
 
@@ -153,11 +153,11 @@ const vector<FlowGraphEdge>& FlowGraphNode::GetOutgoingEdges()
 		edge.target = edges[i].target ? new FlowGraphNode(BNNewFlowGraphNodeReference(edges[i].target)) : nullptr;
 		edge.points.insert(edge.points.begin(), &edges[i].points[0], &edges[i].points[edges[i].pointCount]);
 		edge.backEdge = edges[i].backEdge;
-		result.push_back(edge);
+		result.push_back(std::move(edge));
 	}
 
 	BNFreeFlowGraphNodeEdgeList(edges, count);
-	m_cachedEdges = result;
+	m_cachedEdges = std::move(result);
 	m_cachedEdgesValid = true;
 	return m_cachedEdges;
 }
@@ -180,11 +180,11 @@ const vector<FlowGraphEdge>& FlowGraphNode::GetIncomingEdges()
 		edge.target = edges[i].target ? new FlowGraphNode(BNNewFlowGraphNodeReference(edges[i].target)) : nullptr;
 		edge.points.insert(edge.points.begin(), &edges[i].points[0], &edges[i].points[edges[i].pointCount]);
 		edge.backEdge = edges[i].backEdge;
-		result.push_back(edge);
+		result.push_back(std::move(edge));
 	}
 
 	BNFreeFlowGraphNodeEdgeList(edges, count);
-	m_cachedIncomingEdges = result;
+	m_cachedIncomingEdges = std::move(result);
 	m_cachedIncomingEdgesValid = true;
 	return m_cachedIncomingEdges;
 }
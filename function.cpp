@@ -113,8 +113,15 @@ Function::Function(BNFunction* func)
 }
 
 
+Ref<Function> Function::Intern(BNFunction* func)
+{
+	return WrapperCache<Function, BNFunction>::Get(func, [](BNFunction* f) { return new Function(f); });
+}
+
+
 Function::~Function()
 {
+	WrapperCache<Function, BNFunction>::Remove(m_object, this);
 	if (m_advancedAnalysisRequests > 0)
 		BNReleaseAdvancedFunctionAnalysisDataMultiple(m_object, (size_t)m_advancedAnalysisRequests);
 }
@@ -128,13 +135,13 @@ Ref<BinaryView> Function::GetView() const
 
 Ref<Platform> Function::GetPlatform() const
 {
-	return new Platform(BNGetFunctionPlatform(m_object));
+	return Platform::Intern(BNGetFunctionPlatform(m_object));
 }
 
 
 Ref<Architecture> Function::GetArchitecture() const
 {
-	return new CoreArchitecture(BNGetFunctionArchitecture(m_object));
+	return CoreArchitecture::Intern(BNGetFunctionArchitecture(m_object));
 }
 
 
@@ -183,7 +190,7 @@ vector<Ref<BasicBlock>> Function::GetBasicBlocks() const
 	vector<Ref<BasicBlock>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.emplace_back(BasicBlock::Intern(BNNewBasicBlockReference(blocks[i])));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -195,7 +202,7 @@ Ref<BasicBlock> Function::GetBasicBlockAtAddress(Architecture* arch, uint64_t ad
 	BNBasicBlock* block = BNGetFunctionBasicBlockAtAddress(m_object, arch->GetObject(), addr);
 	if (!block)
 		return nullptr;
-	return new BasicBlock(block);
+	return BasicBlock::Intern(block);
 }
 
 
@@ -399,7 +406,7 @@ vector<StackVariableReference> Function::GetStackVariablesReferencedByInstructio
 		ref.var = Variable::FromIdentifier(refs[i].varIdentifier);
 		ref.referencedOffset = refs[i].referencedOffset;
 		ref.size = refs[i].size;
-		result.push_back(ref);
+		result.push_back(std::move(ref));
 	}
 
 	BNFreeStackVariableReferenceList(refs, count);
@@ -830,7 +837,7 @@ map<int64_t, vector<VariableNameAndType>> Function::GetStackLayout()
 		var.type = Confidence<Ref<Type>>(new Type(BNNewTypeReference(vars[i].type)), vars[i].typeConfidence);
 		var.var = vars[i].var;
 		var.autoDefined = vars[i].autoDefined;
-		result[vars[i].var.storage].push_back(var);
+		result[vars[i].var.storage].push_back(std::move(var));
 	}
 
 	BNFreeVariableNameAndTypeList(vars, count);
@@ -992,12 +999,12 @@ vector<IndirectBranchInfo> Function::GetIndirectBranches()
 	for (size_t i = 0; i < count; i++)
 	{
 		IndirectBranchInfo b;
-		b.sourceArch = new CoreArchitecture(branches[i].sourceArch);
+		b.sourceArch = CoreArchitecture::Intern(branches[i].sourceArch);
 		b.sourceAddr = branches[i].sourceAddr;
-		b.destArch = new CoreArchitecture(branches[i].destArch);
+		b.destArch = CoreArchitecture::Intern(branches[i].destArch);
 		b.destAddr = branches[i].destAddr;
 		b.autoDefined = branches[i].autoDefined;
-		result.push_back(b);
+		result.push_back(std::move(b));
 	}
 
 	BNFreeIndirectBranchList(branches);
@@ -1015,12 +1022,12 @@ vector<IndirectBranchInfo> Function::GetIndirectBranchesAt(Architecture* arch, u
 	for (size_t i = 0; i < count; i++)
 	{
 		IndirectBranchInfo b;
-		b.sourceArch = new CoreArchitecture(branches[i].sourceArch);
+		b.sourceArch = CoreArchitecture::Intern(branches[i].sourceArch);
 		b.sourceAddr = branches[i].sourceAddr;
-		b.destArch = new CoreArchitecture(branches[i].destArch);
+		b.destArch = CoreArchitecture::Intern(branches[i].destArch);
 		b.destAddr = branches[i].destAddr;
 		b.autoDefined = branches[i].autoDefined;
-		result.push_back(b);
+		result.push_back(std::move(b));
 	}
 
 	BNFreeIndirectBranchList(branches);
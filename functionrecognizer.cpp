@@ -32,7 +32,7 @@ bool FunctionRecognizer::RecognizeLowLevelILCallback(void* ctxt, BNBinaryView* d
 {
 	FunctionRecognizer* recog = (FunctionRecognizer*)ctxt;
 	Ref<BinaryView> dataObj = new BinaryView(BNNewViewReference(data));
-	Ref<Function> funcObj = new Function(BNNewFunctionReference(func));
+	Ref<Function> funcObj = Function::Intern(BNNewFunctionReference(func));
 	Ref<LowLevelILFunction> ilObj = new LowLevelILFunction(BNNewLowLevelILFunctionReference(il));
 	return recog->RecognizeLowLevelIL(dataObj, funcObj, ilObj);
 }
@@ -42,7 +42,7 @@ bool FunctionRecognizer::RecognizeMediumLevelILCallback(void* ctxt, BNBinaryView
 {
 	FunctionRecognizer* recog = (FunctionRecognizer*)ctxt;
 	Ref<BinaryView> dataObj = new BinaryView(BNNewViewReference(data));
-	Ref<Function> funcObj = new Function(BNNewFunctionReference(func));
+	Ref<Function> funcObj = Function::Intern(BNNewFunctionReference(func));
 	Ref<MediumLevelILFunction> ilObj = new MediumLevelILFunction(BNNewMediumLevelILFunctionReference(il));
 	return recog->RecognizeMediumLevelIL(dataObj, funcObj, ilObj);
 }
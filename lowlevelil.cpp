@@ -48,7 +48,7 @@ Ref<Function> LowLevelILFunction::GetFunction() const
 	BNFunction* func = BNGetLowLevelILOwnerFunction(m_object);
 	if (!func)
 		return nullptr;
-	return new Function(func);
+	return Function::Intern(func);
 }
 
 
@@ -472,7 +472,7 @@ vector<Ref<BasicBlock>> LowLevelILFunction::GetBasicBlocks() const
 	vector<Ref<BasicBlock>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.emplace_back(BasicBlock::Intern(BNNewBasicBlockReference(blocks[i])));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -484,7 +484,7 @@ Ref<BasicBlock> LowLevelILFunction::GetBasicBlockForInstruction(size_t i) const
 	BNBasicBlock* block = BNGetLowLevelILBasicBlockForInstruction(m_object, i);
 	if (!block)
 		return nullptr;
-	return new BasicBlock(block);
+	return BasicBlock::Intern(block);
 }
 
 
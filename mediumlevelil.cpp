@@ -48,7 +48,7 @@ Ref<Function> MediumLevelILFunction::GetFunction() const
 	BNFunction* func = BNGetMediumLevelILOwnerFunction(m_object);
 	if (!func)
 		return nullptr;
-	return new Function(func);
+	return Function::Intern(func);
 }
 
 
@@ -385,7 +385,7 @@ vector<Ref<BasicBlock>> MediumLevelILFunction::GetBasicBlocks() const
 	vector<Ref<BasicBlock>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.emplace_back(BasicBlock::Intern(BNNewBasicBlockReference(blocks[i])));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -397,7 +397,7 @@ Ref<BasicBlock> MediumLevelILFunction::GetBasicBlockForInstruction(size_t i) con
 	BNBasicBlock* block = BNGetMediumLevelILBasicBlockForInstruction(m_object, i);
 	if (!block)
 		return nullptr;
-	return new BasicBlock(block);
+	return BasicBlock::Intern(block);
 }
 
 
@@ -149,7 +149,7 @@ vector<Ref<Metadata>> Metadata::GetArray()
 	vector<Ref<Metadata>> result;
 	result.reserve(size);
 	for (size_t i = 0; i < size; i++)
-		result.push_back(new Metadata(data[i]));
+		result.emplace_back(new Metadata(data[i]));
 	return result;
 }
 
@@ -0,0 +1,215 @@
+// Copyright (c) 2015-2019 Vector 35 Inc
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef WIN32
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+MmapFileAccessor::MmapFileAccessor(const string& path): m_fd(-1), m_base(nullptr), m_fileLength(0), m_length(0),
+	m_hasOverlays(false)
+{
+	long pageSize = sysconf(_SC_PAGESIZE);
+	m_pageSize = (pageSize > 0) ? (uint64_t)pageSize : 0x1000;
+
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return;
+
+	struct stat st;
+	if ((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode))
+	{
+		close(fd);
+		return;
+	}
+
+	if (st.st_size > 0)
+	{
+		void* base = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (base == MAP_FAILED)
+		{
+			close(fd);
+			return;
+		}
+		m_base = (const uint8_t*)base;
+	}
+
+	m_fd = fd;
+	m_fileLength = (uint64_t)st.st_size;
+	m_length = m_fileLength;
+}
+
+
+MmapFileAccessor::~MmapFileAccessor()
+{
+	if (m_base)
+		munmap((void*)m_base, (size_t)m_fileLength);
+	if (m_fd != -1)
+		close(m_fd);
+}
+
+
+void MmapFileAccessor::ReadMapped(uint8_t* dest, uint64_t offset, size_t len) const
+{
+	// Anything past the end of the mapping was created by a write that extended the file, and reads as zero
+	size_t mapped = 0;
+	if (offset < m_fileLength)
+	{
+		mapped = (size_t)min<uint64_t>(len, m_fileLength - offset);
+		memcpy(dest, m_base + offset, mapped);
+	}
+	if (mapped < len)
+		memset(dest + mapped, 0, len - mapped);
+}
+
+
+size_t MmapFileAccessor::Read(void* dest, uint64_t offset, size_t len)
+{
+	uint64_t length = m_length;
+	if (offset >= length)
+		return 0;
+	len = (size_t)min<uint64_t>(len, length - offset);
+
+	if (!m_hasOverlays)
+	{
+		ReadMapped((uint8_t*)dest, offset, len);
+		return len;
+	}
+
+	lock_guard<mutex> lock(m_overlayMutex);
+	uint8_t* out = (uint8_t*)dest;
+	size_t remaining = len;
+	while (remaining > 0)
+	{
+		uint64_t page = offset / m_pageSize;
+		size_t pageOffset = (size_t)(offset % m_pageSize);
+		size_t chunk = (size_t)min<uint64_t>(remaining, m_pageSize - pageOffset);
+
+		auto i = m_overlays.find(page);
+		if (i != m_overlays.end())
+			memcpy(out, &i->second[pageOffset], chunk);
+		else
+			ReadMapped(out, offset, chunk);
+
+		out += chunk;
+		offset += chunk;
+		remaining -= chunk;
+	}
+	return len;
+}
+
+
+size_t MmapFileAccessor::Write(uint64_t offset, const void* src, size_t len)
+{
+	if ((m_fd == -1) || ((offset + len) < offset))
+		return 0;
+
+	lock_guard<mutex> lock(m_overlayMutex);
+	const uint8_t* in = (const uint8_t*)src;
+	uint64_t end = offset + len;
+	size_t remaining = len;
+	while (remaining > 0)
+	{
+		uint64_t page = offset / m_pageSize;
+		size_t pageOffset = (size_t)(offset % m_pageSize);
+		size_t chunk = (size_t)min<uint64_t>(remaining, m_pageSize - pageOffset);
+
+		auto i = m_overlays.find(page);
+		if (i == m_overlays.end())
+		{
+			vector<uint8_t> contents((size_t)m_pageSize);
+			ReadMapped(contents.data(), page * m_pageSize, (size_t)m_pageSize);
+			i = m_overlays.insert(make_pair(page, move(contents))).first;
+		}
+		memcpy(&i->second[pageOffset], in, chunk);
+
+		in += chunk;
+		offset += chunk;
+		remaining -= chunk;
+	}
+
+	if (len > 0)
+		m_hasOverlays = true;
+	if (end > m_length)
+		m_length = end;
+	return len;
+}
+
+
+bool MmapFileAccessor::Advise(MmapAccessHint hint, uint64_t offset, uint64_t len)
+{
+	if (!m_base || (offset >= m_fileLength))
+		return false;
+	if ((len == 0) || (len > (m_fileLength - offset)))
+		len = m_fileLength - offset;
+
+	int advice;
+	switch (hint)
+	{
+	case MmapSequentialAccess:
+		advice = MADV_SEQUENTIAL;
+		break;
+	case MmapRandomAccess:
+		advice = MADV_RANDOM;
+		break;
+	case MmapWillNeedAccess:
+		advice = MADV_WILLNEED;
+		break;
+	default:
+		advice = MADV_NORMAL;
+		break;
+	}
+
+	// madvise requires a page aligned start address
+	uint64_t start = offset - (offset % m_pageSize);
+	return madvise((void*)(m_base + start), (size_t)(len + (offset - start)), advice) == 0;
+}
+
+
+bool MmapFileAccessor::IsModified()
+{
+	return m_hasOverlays;
+}
+
+
+size_t MmapFileAccessor::GetOverlayPageCount()
+{
+	lock_guard<mutex> lock(m_overlayMutex);
+	return m_overlays.size();
+}
+
+
+void MmapFileAccessor::DiscardWrites()
+{
+	lock_guard<mutex> lock(m_overlayMutex);
+	m_overlays.clear();
+	m_hasOverlays = false;
+	m_length = m_fileLength;
+}
+
+#endif
@@ -36,9 +36,21 @@ Platform::Platform(Architecture* arch, const string& name)
 }
 
 
+Platform::~Platform()
+{
+	WrapperCache<Platform, BNPlatform>::Remove(m_object, this);
+}
+
+
+Ref<Platform> Platform::Intern(BNPlatform* platform)
+{
+	return WrapperCache<Platform, BNPlatform>::Get(platform, [](BNPlatform* p) { return new Platform(p); });
+}
+
+
 Ref<Architecture> Platform::GetArchitecture() const
 {
-	return new CoreArchitecture(BNGetPlatformArchitecture(m_object));
+	return CoreArchitecture::Intern(BNGetPlatformArchitecture(m_object));
 }
 
 
@@ -62,7 +74,7 @@ Ref<Platform> Platform::GetByName(const string& name)
 	BNPlatform* platform = BNGetPlatformByName(name.c_str());
 	if (!platform)
 		return nullptr;
-	return new Platform(platform);
+	return Platform::Intern(platform);
 }
 
 
@@ -74,7 +86,7 @@ vector<Ref<Platform>> Platform::GetList()
 	vector<Ref<Platform>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Platform(BNNewPlatformReference(list[i])));
+		result.emplace_back(Platform::Intern(BNNewPlatformReference(list[i])));
 
 	BNFreePlatformList(list, count);
 	return result;
@@ -89,7 +101,7 @@ vector<Ref<Platform>> Platform::GetList(Architecture* arch)
 	vector<Ref<Platform>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Platform(BNNewPlatformReference(list[i])));
+		result.emplace_back(Platform::Intern(BNNewPlatformReference(list[i])));
 
 	BNFreePlatformList(list, count);
 	return result;
@@ -104,7 +116,7 @@ vector<Ref<Platform>> Platform::GetList(const string& os)
 	vector<Ref<Platform>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Platform(BNNewPlatformReference(list[i])));
+		result.emplace_back(Platform::Intern(BNNewPlatformReference(list[i])));
 
 	BNFreePlatformList(list, count);
 	return result;
@@ -119,7 +131,7 @@ vector<Ref<Platform>> Platform::GetList(const string& os, Architecture* arch)
 	vector<Ref<Platform>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Platform(BNNewPlatformReference(list[i])));
+		result.emplace_back(Platform::Intern(BNNewPlatformReference(list[i])));
 
 	BNFreePlatformList(list, count);
 	return result;
@@ -185,7 +197,7 @@ vector<Ref<CallingConvention>> Platform::GetCallingConventions() const
 	vector<Ref<CallingConvention>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new CoreCallingConvention(BNNewCallingConventionReference(list[i])));
+		result.emplace_back(new CoreCallingConvention(BNNewCallingConventionReference(list[i])));
 
 	BNFreeCallingConventionList(list, count);
 	return result;
@@ -242,7 +254,7 @@ Ref<Platform> Platform::GetRelatedPlatform(Architecture* arch)
 	BNPlatform* platform = BNGetRelatedPlatform(m_object, arch->GetObject());
 	if (!platform)
 		return nullptr;
-	return new Platform(platform);
+	return Platform::Intern(platform);
 }
 
 
@@ -257,7 +269,7 @@ Ref<Platform> Platform::GetAssociatedPlatformByAddress(uint64_t& addr)
 	BNPlatform* platform = BNGetAssociatedPlatformByAddress(m_object, &addr);
 	if (!platform)
 		return nullptr;
-	return new Platform(platform);
+	return Platform::Intern(platform);
 }
 
 
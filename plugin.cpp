@@ -95,7 +95,7 @@ void PluginCommand::FunctionPluginCommandActionCallback(void* ctxt, BNBinaryView
 {
 	RegisteredFunctionCommand* cmd = (RegisteredFunctionCommand*)ctxt;
 	Ref<BinaryView> viewObject = new BinaryView(BNNewViewReference(view));
-	Ref<Function> funcObject = new Function(BNNewFunctionReference(func));
+	Ref<Function> funcObject = Function::Intern(BNNewFunctionReference(func));
 	cmd->action(viewObject, funcObject);
 }
 
@@ -170,7 +170,7 @@ bool PluginCommand::FunctionPluginCommandIsValidCallback(void* ctxt, BNBinaryVie
 {
 	RegisteredFunctionCommand* cmd = (RegisteredFunctionCommand*)ctxt;
 	Ref<BinaryView> viewObject = new BinaryView(BNNewViewReference(view));
-	Ref<Function> funcObject = new Function(BNNewFunctionReference(func));
+	Ref<Function> funcObject = Function::Intern(BNNewFunctionReference(func));
 	return cmd->isValid(viewObject, funcObject);
 }
 
@@ -137,7 +137,7 @@ vector<Ref<RepoPlugin>> Repository::GetPlugins() const
 	size_t count = 0;
 	BNRepoPlugin** pluginsPtr = BNRepositoryGetPlugins(m_object, &count);
 	for (size_t i = 0; i < count; i++)
-		plugins.push_back(new RepoPlugin(BNNewPluginReference(pluginsPtr[i])));
+		plugins.emplace_back(new RepoPlugin(BNNewPluginReference(pluginsPtr[i])));
 	BNFreeRepositoryPluginList(pluginsPtr);
 	return plugins;
 }
@@ -192,7 +192,7 @@ vector<Ref<Repository>> RepositoryManager::GetRepositories()
 	size_t count = 0;
 	BNRepository** reposPtr = BNRepositoryManagerGetRepositories(m_object, &count);
 	for (size_t i = 0; i < count; i++)
-		repos.push_back(new Repository(BNNewRepositoryReference(reposPtr[i])));
+		repos.emplace_back(new Repository(BNNewRepositoryReference(reposPtr[i])));
 	BNFreeRepositoryManagerRepositoriesList(reposPtr);
 	return repos;
 }
@@ -56,7 +56,7 @@ bool RelocationHandler::GetRelocationInfoCallback(void* ctxt, BNBinaryView* view
 {
 	RelocationHandler* handler = (RelocationHandler*)ctxt;
 	Ref<BinaryView> viewObj = new BinaryView(BNNewViewReference(view));
-	Ref<Architecture> archObj = new CoreArchitecture(arch);
+	Ref<Architecture> archObj = CoreArchitecture::Intern(arch);
 	if (!result)
 		return false;
 	vector<BNRelocationInfo> resultVector(&result[0], &result[resultCount]);
@@ -71,7 +71,7 @@ bool RelocationHandler::ApplyRelocationCallback(void* ctxt, BNBinaryView* view,
 	uint8_t* dest, size_t len)
 {
 	RelocationHandler* handler = (RelocationHandler*)ctxt;
-	Ref<Architecture> archObj = new CoreArchitecture(arch);
+	Ref<Architecture> archObj = CoreArchitecture::Intern(arch);
 	Ref<BinaryView> viewObj = new BinaryView(BNNewViewReference(view));
 	Ref<Relocation> relocObj = new Relocation(BNNewRelocationReference(reloc));
 	return handler->ApplyRelocation(viewObj, archObj, relocObj, dest, len);
@@ -109,14 +109,14 @@ void ScriptingInstance::SetCurrentBinaryViewCallback(void* ctxt, BNBinaryView* v
 void ScriptingInstance::SetCurrentFunctionCallback(void* ctxt, BNFunction* func)
 {
 	ScriptingInstance* instance = (ScriptingInstance*)ctxt;
-	instance->SetCurrentFunction(func ? new Function(BNNewFunctionReference(func)) : nullptr);
+	instance->SetCurrentFunction(func ? Function::Intern(BNNewFunctionReference(func)) : nullptr);
 }
 
 
 void ScriptingInstance::SetCurrentBasicBlockCallback(void* ctxt, BNBasicBlock* block)
 {
 	ScriptingInstance* instance = (ScriptingInstance*)ctxt;
-	instance->SetCurrentBasicBlock(block ? new BasicBlock(BNNewBasicBlockReference(block)) : nullptr);
+	instance->SetCurrentBasicBlock(block ? BasicBlock::Intern(BNNewBasicBlockReference(block)) : nullptr);
 }
 
 
@@ -285,7 +285,7 @@ vector<Ref<ScriptingProvider>> ScriptingProvider::GetList()
 	BNScriptingProvider** list = BNGetScriptingProviderList(&count);
 	vector<Ref<ScriptingProvider>> result;
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new CoreScriptingProvider(list[i]));
+		result.emplace_back(new CoreScriptingProvider(list[i]));
 	BNFreeScriptingProviderList(list);
 	return result;
 }
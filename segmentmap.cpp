@@ -0,0 +1,307 @@
+// Copyright (c) 2015-2019 Vector 35 Inc
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+SegmentMap::SegmentMap(BinaryView* view): m_view(view), m_pageBase(0), m_outsideFlags(0)
+{
+	Update();
+}
+
+
+bool SegmentMap::Update()
+{
+	vector<Ref<Segment>> segments = m_view->GetSegments();
+	vector<Descriptor> segmentDescriptors;
+	for (auto& i : segments)
+	{
+		Descriptor desc;
+		desc.start = i->GetStart();
+		desc.end = i->GetEnd();
+		desc.dataEnd = desc.start + min(i->GetDataLength(), desc.end - desc.start);
+		desc.flags = i->GetFlags();
+		segmentDescriptors.push_back(desc);
+	}
+	if (segments.empty())
+	{
+		// Views without segments, such as raw views, are readable and writable throughout
+		Descriptor desc;
+		desc.start = m_view->GetStart();
+		desc.end = m_view->GetEnd();
+		desc.dataEnd = desc.end;
+		desc.flags = SegmentReadable | SegmentWritable;
+		if (desc.end > desc.start)
+			segmentDescriptors.push_back(desc);
+	}
+
+	vector<Ref<Section>> sections = m_view->GetSections();
+	vector<Descriptor> sectionDescriptors;
+	for (auto& i : sections)
+	{
+		Descriptor desc;
+		desc.start = i->GetStart();
+		desc.end = desc.start + i->GetLength();
+		desc.dataEnd = desc.end;
+		desc.flags = i->GetSemantics();
+		sectionDescriptors.push_back(desc);
+	}
+
+	if ((segmentDescriptors == m_segmentDescriptors) && (sectionDescriptors == m_sectionDescriptors))
+		return false;
+
+	m_segments = segments;
+	m_sections = sections;
+	m_segmentDescriptors = segmentDescriptors;
+	m_sectionDescriptors = sectionDescriptors;
+	Rebuild();
+	return true;
+}
+
+
+void SegmentMap::Rebuild()
+{
+	m_intervals.clear();
+	m_intervalSections.clear();
+	m_pages.clear();
+	m_pageBase = 0;
+	m_outsideFlags = 0;
+
+	// Split the address space at every boundary so that each piece has a single set of flags
+	vector<uint64_t> points;
+	for (auto& i : m_segmentDescriptors)
+	{
+		points.push_back(i.start);
+		points.push_back(i.end);
+		points.push_back(i.dataEnd);
+	}
+	for (auto& i : m_sectionDescriptors)
+	{
+		points.push_back(i.start);
+		points.push_back(i.end);
+	}
+	sort(points.begin(), points.end());
+	points.erase(unique(points.begin(), points.end()), points.end());
+
+	vector<size_t> sections;
+	for (size_t i = 1; i < points.size(); i++)
+	{
+		uint64_t start = points[i - 1];
+		uint64_t end = points[i];
+
+		size_t segment = SIZE_MAX;
+		for (size_t j = 0; j < m_segmentDescriptors.size(); j++)
+		{
+			if ((start >= m_segmentDescriptors[j].start) && (start < m_segmentDescriptors[j].end))
+			{
+				segment = j;
+				break;
+			}
+		}
+		sections.clear();
+		for (size_t j = 0; j < m_sectionDescriptors.size(); j++)
+		{
+			if ((start >= m_sectionDescriptors[j].start) && (start < m_sectionDescriptors[j].end))
+				sections.push_back(j);
+		}
+		if ((segment == SIZE_MAX) && sections.empty())
+			continue;
+
+		uint16_t flags = 0;
+		if (segment != SIZE_MAX)
+		{
+			const Descriptor& desc = m_segmentDescriptors[segment];
+			flags |= SegmentMapInSegment;
+			if (desc.flags & SegmentReadable)
+				flags |= SegmentMapReadable;
+			if (desc.flags & SegmentWritable)
+				flags |= SegmentMapWritable;
+			if (desc.flags & SegmentExecutable)
+				flags |= SegmentMapExecutable;
+			if (start < desc.dataEnd)
+				flags |= SegmentMapBackedByFile;
+		}
+		bool sectionSemantics = false;
+		if (!sections.empty())
+		{
+			flags |= SegmentMapInSection;
+			for (size_t j : sections)
+			{
+				switch (m_sectionDescriptors[j].flags)
+				{
+				case ReadOnlyCodeSectionSemantics:
+					flags |= SegmentMapCodeSemantics;
+					sectionSemantics = true;
+					break;
+				case ReadWriteDataSectionSemantics:
+					flags |= SegmentMapWritableSemantics;
+					sectionSemantics = true;
+					break;
+				case ExternalSectionSemantics:
+					flags |= SegmentMapExternSemantics;
+					sectionSemantics = true;
+					break;
+				case ReadOnlyDataSectionSemantics:
+					sectionSemantics = true;
+					break;
+				default:
+					break;
+				}
+			}
+		}
+		if (!sectionSemantics)
+		{
+			// Sections with default semantics defer to the segment permissions
+			if (flags & SegmentMapExecutable)
+				flags |= SegmentMapCodeSemantics;
+			if (flags & SegmentMapWritable)
+				flags |= SegmentMapWritableSemantics;
+		}
+		if ((flags & SegmentMapExecutable) && (flags & SegmentMapCodeSemantics))
+			flags |= SegmentMapPointerToCode;
+
+		// Pieces of a segment split only by boundaries that change nothing are joined again
+		size_t segmentIndex = m_segments.empty() ? SIZE_MAX : segment;
+		if (!m_intervals.empty())
+		{
+			Interval& prev = m_intervals.back();
+			if ((prev.end == start) && (prev.flags == flags) && (prev.segment == segmentIndex) &&
+				(prev.sectionCount == sections.size()) &&
+				equal(sections.begin(), sections.end(), m_intervalSections.begin() + prev.firstSection))
+			{
+				prev.end = end;
+				continue;
+			}
+		}
+
+		Interval interval;
+		interval.start = start;
+		interval.end = end;
+		interval.flags = flags;
+		interval.segment = segmentIndex;
+		interval.firstSection = m_intervalSections.size();
+		interval.sectionCount = sections.size();
+		m_intervalSections.insert(m_intervalSections.end(), sections.begin(), sections.end());
+		m_intervals.push_back(interval);
+	}
+
+	if (m_intervals.empty())
+		return;
+
+	uint64_t pageSize = (uint64_t)1 << PageShift;
+	uint64_t base = m_intervals.front().start & ~(pageSize - 1);
+	uint64_t pageCount = ((m_intervals.back().end - 1 - base) >> PageShift) + 1;
+	if (pageCount > MaxPageCount)
+	{
+		// Too sparse for a page table, so every query uses the interval table
+		m_outsideFlags = SegmentMapMixedPage;
+		return;
+	}
+
+	// A page takes the flags of the interval run that covers all of it. Pages that are only partly covered
+	// are marked so that queries on them search the intervals.
+	m_pageBase = base;
+	m_pages.assign((size_t)pageCount, 0);
+	for (size_t i = 0; i < m_intervals.size(); )
+	{
+		uint64_t start = m_intervals[i].start;
+		uint64_t end = m_intervals[i].end;
+		uint16_t flags = m_intervals[i].flags;
+		for (i++; (i < m_intervals.size()) && (m_intervals[i].start == end) && (m_intervals[i].flags == flags); i++)
+			end = m_intervals[i].end;
+
+		uint64_t firstPage = (start - base) >> PageShift;
+		uint64_t lastPage = (end - 1 - base) >> PageShift;
+		for (uint64_t page = firstPage; page <= lastPage; page++)
+		{
+			uint64_t pageStart = base + (page << PageShift);
+			uint64_t pageLast = pageStart + (pageSize - 1);
+			bool full = (start <= pageStart) && ((end - 1) >= pageLast);
+			m_pages[(size_t)page] = full ? flags : (uint16_t)SegmentMapMixedPage;
+		}
+	}
+}
+
+
+const SegmentMap::Interval* SegmentMap::GetInterval(uint64_t addr) const
+{
+	auto i = upper_bound(m_intervals.begin(), m_intervals.end(), addr,
+		[](uint64_t value, const Interval& interval) { return value < interval.start; });
+	if (i == m_intervals.begin())
+		return nullptr;
+	--i;
+	if (addr >= i->end)
+		return nullptr;
+	return &*i;
+}
+
+
+uint16_t SegmentMap::GetIntervalFlags(uint64_t addr) const
+{
+	const Interval* interval = GetInterval(addr);
+	return interval ? interval->flags : 0;
+}
+
+
+void SegmentMap::GetFlags(const uint64_t* addrs, size_t count, uint16_t* flags) const
+{
+	for (size_t i = 0; i < count; i++)
+		flags[i] = GetFlags(addrs[i]);
+}
+
+
+size_t SegmentMap::FilterPointersToCode(const uint64_t* values, size_t count, uint64_t* out) const
+{
+	// Every value is stored and the output position only advances for pointers to code, so there is no
+	// data dependent branch outside of mixed pages
+	size_t result = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t value = values[i];
+		out[result] = value;
+		result += ((GetFlags(value) & SegmentMapPointerToCode) != 0) ? 1 : 0;
+	}
+	return result;
+}
+
+
+Ref<Segment> SegmentMap::GetSegmentAt(uint64_t addr) const
+{
+	const Interval* interval = GetInterval(addr);
+	if (!interval || (interval->segment == SIZE_MAX))
+		return nullptr;
+	return m_segments[interval->segment];
+}
+
+
+vector<Ref<Section>> SegmentMap::GetSectionsAt(uint64_t addr) const
+{
+	vector<Ref<Section>> result;
+	const Interval* interval = GetInterval(addr);
+	if (!interval)
+		return result;
+	for (size_t i = 0; i < interval->sectionCount; i++)
+		result.push_back(m_sections[m_intervalSections[interval->firstSection + i]]);
+	return result;
+}
@@ -0,0 +1,352 @@
+// Copyright (c) 2015-2019 Vector 35 Inc
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+// Live indexes by view, so that symbol definitions made through any BinaryView object reach them
+static mutex g_symbolIndexLock;
+static map<BNBinaryView*, vector<SymbolIndex*>> g_symbolIndexes;
+static atomic<size_t> g_symbolIndexCount(0);
+
+
+SymbolIndex::SymbolIndex(BinaryView* view, const NameSpace& nameSpace, bool registerNotifications):
+	m_view(view), m_nameSpace(nameSpace), m_registered(registerNotifications), m_stale(true), m_generation(0)
+{
+	{
+		unique_lock<mutex> lock(g_symbolIndexLock);
+		g_symbolIndexes[m_view->GetObject()].push_back(this);
+		g_symbolIndexCount++;
+	}
+	if (m_registered)
+		m_view->RegisterNotification(this);
+}
+
+
+SymbolIndex::~SymbolIndex()
+{
+	if (m_registered)
+		m_view->UnregisterNotification(this);
+
+	unique_lock<mutex> lock(g_symbolIndexLock);
+	auto i = g_symbolIndexes.find(m_view->GetObject());
+	if (i != g_symbolIndexes.end())
+	{
+		i->second.erase(remove(i->second.begin(), i->second.end(), this), i->second.end());
+		if (i->second.empty())
+			g_symbolIndexes.erase(i);
+	}
+	g_symbolIndexCount--;
+}
+
+
+void SymbolIndex::NotifySymbolChanged(BNBinaryView* view, Symbol* sym, Function* func)
+{
+	if (g_symbolIndexCount == 0)
+		return;
+
+	unique_lock<mutex> lock(g_symbolIndexLock);
+	auto i = g_symbolIndexes.find(view);
+	if (i == g_symbolIndexes.end())
+		return;
+
+	uint64_t addr = sym->GetAddress();
+	for (auto index : i->second)
+	{
+		index->AddressChanged(addr);
+		if (func)
+			index->AddressChanged(func->GetStart());
+	}
+}
+
+
+void SymbolIndex::AddressChanged(uint64_t addr)
+{
+	unique_lock<mutex> lock(m_mutex);
+	if (!m_stale)
+		m_changedAddresses.insert(addr);
+}
+
+
+void SymbolIndex::AddEntryLocked(const Ref<Symbol>& symbol)
+{
+	size_t index;
+	if (m_freeEntries.empty())
+	{
+		index = m_entries.size();
+		m_entries.push_back(Entry());
+	}
+	else
+	{
+		index = m_freeEntries.back();
+		m_freeEntries.pop_back();
+	}
+
+	Entry& entry = m_entries[index];
+	entry.symbol = symbol;
+	entry.address = symbol->GetAddress();
+	entry.rawName = symbol->GetRawName();
+	entry.shortName = symbol->GetShortName();
+	entry.fullName = symbol->GetFullName();
+	entry.live = true;
+
+	m_rawNames[entry.rawName].push_back(index);
+	m_names[entry.rawName].push_back(index);
+	if (entry.shortName != entry.rawName)
+		m_names[entry.shortName].push_back(index);
+	if ((entry.fullName != entry.rawName) && (entry.fullName != entry.shortName))
+		m_names[entry.fullName].push_back(index);
+	m_addedAddresses.push_back(pair<uint64_t, size_t>(entry.address, index));
+}
+
+
+static void RemoveFromNameTable(unordered_map<string, vector<size_t>>& table, const string& name, size_t index)
+{
+	auto i = table.find(name);
+	if (i == table.end())
+		return;
+	i->second.erase(remove(i->second.begin(), i->second.end(), index), i->second.end());
+	if (i->second.empty())
+		table.erase(i);
+}
+
+
+// Removed entries stay out of the free list until the address array no longer refers to them
+void SymbolIndex::RemoveEntryLocked(size_t index)
+{
+	Entry& entry = m_entries[index];
+	RemoveFromNameTable(m_rawNames, entry.rawName, index);
+	RemoveFromNameTable(m_names, entry.rawName, index);
+	RemoveFromNameTable(m_names, entry.shortName, index);
+	RemoveFromNameTable(m_names, entry.fullName, index);
+	entry.symbol = nullptr;
+	entry.live = false;
+	m_removedEntries.push_back(index);
+}
+
+
+void SymbolIndex::MergeAddressesLocked()
+{
+	if (m_addedAddresses.empty() && m_removedEntries.empty())
+		return;
+
+	if (!m_removedEntries.empty())
+	{
+		m_addresses.erase(remove_if(m_addresses.begin(), m_addresses.end(),
+			[&](const pair<uint64_t, size_t>& i) { return !m_entries[i.second].live; }), m_addresses.end());
+		m_addedAddresses.erase(remove_if(m_addedAddresses.begin(), m_addedAddresses.end(),
+			[&](const pair<uint64_t, size_t>& i) { return !m_entries[i.second].live; }), m_addedAddresses.end());
+		m_freeEntries.insert(m_freeEntries.end(), m_removedEntries.begin(), m_removedEntries.end());
+		m_removedEntries.clear();
+	}
+
+	auto byAddress = [](const pair<uint64_t, size_t>& a, const pair<uint64_t, size_t>& b) {
+		return a.first < b.first;
+	};
+	stable_sort(m_addedAddresses.begin(), m_addedAddresses.end(), byAddress);
+	size_t middle = m_addresses.size();
+	m_addresses.insert(m_addresses.end(), m_addedAddresses.begin(), m_addedAddresses.end());
+	inplace_merge(m_addresses.begin(), m_addresses.begin() + middle, m_addresses.end(), byAddress);
+	m_addedAddresses.clear();
+}
+
+
+// Brings the index up to date: a full rebuild when stale, otherwise a query for each changed address. The view
+// is queried without holding m_mutex, so notifications arriving meanwhile are recorded rather than blocked, and
+// are picked up by the next pass. Results are dropped if the index was refreshed while they were being fetched.
+void SymbolIndex::Update(unique_lock<mutex>& lock)
+{
+	lock.unlock();
+	unique_lock<mutex> updateLock(m_updateMutex);
+	lock.lock();
+
+	while (m_stale || !m_changedAddresses.empty())
+	{
+		uint64_t generation = m_generation;
+		if (m_stale)
+		{
+			m_stale = false;
+			m_changedAddresses.clear();
+			lock.unlock();
+			vector<Ref<Symbol>> symbols = m_view->GetSymbols(m_nameSpace);
+			lock.lock();
+			if (generation != m_generation)
+				continue;
+
+			m_entries.clear();
+			m_freeEntries.clear();
+			m_removedEntries.clear();
+			m_rawNames.clear();
+			m_names.clear();
+			m_addresses.clear();
+			m_addedAddresses.clear();
+			m_entries.reserve(symbols.size());
+			m_addresses.reserve(symbols.size());
+			for (auto& i : symbols)
+				AddEntryLocked(i);
+		}
+		else
+		{
+			vector<uint64_t> addresses(m_changedAddresses.begin(), m_changedAddresses.end());
+			m_changedAddresses.clear();
+			lock.unlock();
+			vector<vector<Ref<Symbol>>> symbols;
+			symbols.reserve(addresses.size());
+			for (uint64_t addr : addresses)
+				symbols.push_back(m_view->GetSymbols(addr, 1, m_nameSpace));
+			lock.lock();
+			if (generation != m_generation)
+				continue;
+
+			MergeAddressesLocked();
+			for (size_t j = 0; j < addresses.size(); j++)
+			{
+				auto i = lower_bound(m_addresses.begin(), m_addresses.end(),
+					pair<uint64_t, size_t>(addresses[j], 0));
+				for (; (i != m_addresses.end()) && (i->first == addresses[j]); ++i)
+				{
+					if (m_entries[i->second].live)
+						RemoveEntryLocked(i->second);
+				}
+				for (auto& symbol : symbols[j])
+					AddEntryLocked(symbol);
+			}
+		}
+	}
+	MergeAddressesLocked();
+}
+
+
+void SymbolIndex::Refresh()
+{
+	unique_lock<mutex> lock(m_mutex);
+	m_stale = true;
+	m_generation++;
+}
+
+
+void SymbolIndex::RefreshAddress(uint64_t addr)
+{
+	AddressChanged(addr);
+}
+
+
+size_t SymbolIndex::GetSymbolCount()
+{
+	unique_lock<mutex> lock(m_mutex);
+	Update(lock);
+	return m_addresses.size();
+}
+
+
+Ref<Symbol> SymbolIndex::GetSymbolByAddress(uint64_t addr)
+{
+	unique_lock<mutex> lock(m_mutex);
+	Update(lock);
+	auto i = lower_bound(m_addresses.begin(), m_addresses.end(), pair<uint64_t, size_t>(addr, 0));
+	if ((i == m_addresses.end()) || (i->first != addr))
+		return nullptr;
+	return m_entries[i->second].symbol;
+}
+
+
+Ref<Symbol> SymbolIndex::GetSymbolByRawName(const string& name)
+{
+	unique_lock<mutex> lock(m_mutex);
+	Update(lock);
+	auto i = m_rawNames.find(name);
+	if (i == m_rawNames.end())
+		return nullptr;
+	return m_entries[i->second.front()].symbol;
+}
+
+
+vector<Ref<Symbol>> SymbolIndex::GetSymbolsByName(const string& name)
+{
+	unique_lock<mutex> lock(m_mutex);
+	Update(lock);
+	vector<Ref<Symbol>> result;
+	auto i = m_names.find(name);
+	if (i == m_names.end())
+		return result;
+	result.reserve(i->second.size());
+	for (size_t entry : i->second)
+		result.push_back(m_entries[entry].symbol);
+	return result;
+}
+
+
+vector<Ref<Symbol>> SymbolIndex::GetSymbols(uint64_t start, uint64_t len)
+{
+	unique_lock<mutex> lock(m_mutex);
+	Update(lock);
+	vector<Ref<Symbol>> result;
+	uint64_t end = ((start + len) < start) ? UINT64_MAX : (start + len);
+	auto i = lower_bound(m_addresses.begin(), m_addresses.end(), pair<uint64_t, size_t>(start, 0));
+	for (; (i != m_addresses.end()) && (i->first < end); ++i)
+		result.push_back(m_entries[i->second].symbol);
+	return result;
+}
+
+
+void SymbolIndex::OnBinaryDataInserted(BinaryView*, uint64_t, size_t)
+{
+	Refresh();
+}
+
+
+void SymbolIndex::OnBinaryDataRemoved(BinaryView*, uint64_t, uint64_t)
+{
+	Refresh();
+}
+
+
+void SymbolIndex::OnAnalysisFunctionAdded(BinaryView*, Function* func)
+{
+	AddressChanged(func->GetStart());
+}
+
+
+void SymbolIndex::OnAnalysisFunctionRemoved(BinaryView*, Function* func)
+{
+	AddressChanged(func->GetStart());
+}
+
+
+void SymbolIndex::OnDataVariableAdded(BinaryView*, const DataVariable& var)
+{
+	AddressChanged(var.address);
+}
+
+
+void SymbolIndex::OnDataVariableRemoved(BinaryView*, const DataVariable& var)
+{
+	AddressChanged(var.address);
+}
+
+
+void SymbolIndex::OnDataVariableUpdated(BinaryView*, const DataVariable& var)
+{
+	AddressChanged(var.address);
+}
@@ -43,6 +43,18 @@ TemporaryFile::TemporaryFile(const string& contents)
 }
 
 
+TemporaryFile::TemporaryFile(const DataBufferView& contents)
+{
+	if (contents.GetBuffer())
+	{
+		m_object = BNCreateTemporaryFileWithContents(contents.GetBuffer()->GetBufferObject());
+		return;
+	}
+	DataBuffer buf(contents);
+	m_object = BNCreateTemporaryFileWithContents(buf.GetBufferObject());
+}
+
+
 TemporaryFile::TemporaryFile(BNTemporaryFile* file)
 {
 	m_object = file;
@@ -71,7 +71,8 @@ bool Transform::DecodeCallback(void* ctxt, BNDataBuffer* input, BNDataBuffer* ou
 {
 	map<string, DataBuffer> paramMap;
 	for (size_t i = 0; i < paramCount; i++)
-		paramMap[params[i].name] = DataBuffer(BNDuplicateDataBuffer(params[i].value));
+		paramMap[params[i].name] = DataBuffer(BNGetDataBufferContents(params[i].value),
+			BNGetDataBufferLength(params[i].value));
 
 	DataBuffer inputBuf(BNDuplicateDataBuffer(input));
 	DataBuffer outputBuf;
@@ -87,7 +88,8 @@ bool Transform::EncodeCallback(void* ctxt, BNDataBuffer* input, BNDataBuffer* ou
 {
 	map<string, DataBuffer> paramMap;
 	for (size_t i = 0; i < paramCount; i++)
-		paramMap[params[i].name] = DataBuffer(BNDuplicateDataBuffer(params[i].value));
+		paramMap[params[i].name] = DataBuffer(BNGetDataBufferContents(params[i].value),
+			BNGetDataBufferLength(params[i].value));
 
 	DataBuffer inputBuf(BNDuplicateDataBuffer(input));
 	DataBuffer outputBuf;
@@ -159,7 +161,7 @@ vector<Ref<Transform>> Transform::GetTransformTypes()
 	vector<Ref<Transform>> result;
 	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new CoreTransform(list[i]));
+		result.emplace_back(new CoreTransform(list[i]));
 
 	BNFreeTransformTypeList(list);
 	return result;
@@ -219,6 +221,23 @@ bool Transform::Encode(const DataBuffer&, DataBuffer&, const map<string, DataBuf
 }
 
 
+bool Transform::DecodeView(const DataBufferView& input, DataBuffer& output, const map<string, DataBuffer>& params)
+{
+	// A view over a whole buffer is decoded in place, only partial views need to be materialized
+	if (input.GetBuffer())
+		return Decode(*input.GetBuffer(), output, params);
+	return Decode(input.ToBuffer(), output, params);
+}
+
+
+bool Transform::EncodeView(const DataBufferView& input, DataBuffer& output, const map<string, DataBuffer>& params)
+{
+	if (input.GetBuffer())
+		return Encode(*input.GetBuffer(), output, params);
+	return Encode(input.ToBuffer(), output, params);
+}
+
+
 CoreTransform::CoreTransform(BNTransform* xform): Transform(xform)
 {
 }
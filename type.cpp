@@ -575,7 +575,7 @@ vector<FunctionParameter> Type::GetParameters() const
 		param.location.type = types[i].location.type;
 		param.location.index = types[i].location.index;
 		param.location.storage = types[i].location.storage;
-		result.push_back(param);
+		result.push_back(std::move(param));
 	}
 
 	BNFreeTypeParameterList(types, count);
@@ -1084,7 +1084,7 @@ vector<StructureMember> Structure::GetMembers() const
 		member.type = new Type(BNNewTypeReference(members[i].type));
 		member.name = members[i].name;
 		member.offset = members[i].offset;
-		result.push_back(member);
+		result.push_back(std::move(member));
 	}
 
 	BNFreeStructureMemberList(members, count);
@@ -0,0 +1,1049 @@
+// Copyright (c) 2015-2019 Vector 35 Inc
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <string.h>
+#include <condition_variable>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+// The core only exposes whole-buffer zlib routines, so the deflate format (RFC 1950/1951) is decoded here
+// directly. Compression still uses the core: each block is compressed on its own and the resulting deflate
+// data is rewritten to end in an empty non-final stored block (the same layout as a zlib sync flush), which
+// allows the blocks to be concatenated into one stream.
+
+#define ZLIB_WINDOW_SIZE 32768
+#define ZLIB_OUTPUT_CHUNK_SIZE 65536
+#define ZLIB_MAX_MATCH 258
+#define HUFFMAN_FAST_BITS 10
+#define HUFFMAN_MAX_BITS 15
+
+static const uint16_t g_lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+	67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t g_lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+	5, 5, 5, 5, 0};
+static const uint16_t g_distBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+	769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t g_distExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+	11, 11, 12, 12, 13, 13};
+static const uint8_t g_codeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+
+namespace
+{
+	enum DeflateResult
+	{
+		DeflateOk,
+		DeflateNeedInput,
+		DeflateInvalid
+	};
+
+	struct BitReader
+	{
+		const uint8_t* data;
+		size_t length;
+		size_t pos;
+		uint64_t bits;
+		uint32_t count;
+		bool overrun;
+
+		struct Checkpoint
+		{
+			size_t pos;
+			uint64_t bits;
+			uint32_t count;
+		};
+
+		BitReader(): data(nullptr), length(0), pos(0), bits(0), count(0), overrun(false) {}
+		BitReader(const uint8_t* d, size_t len): data(d), length(len), pos(0), bits(0), count(0), overrun(false) {}
+
+		void Refill()
+		{
+			while ((count <= 56) && (pos < length))
+			{
+				bits |= (uint64_t)data[pos++] << count;
+				count += 8;
+			}
+		}
+
+		bool Need(uint32_t n)
+		{
+			if (count < n)
+			{
+				Refill();
+				if (count < n)
+				{
+					overrun = true;
+					return false;
+				}
+			}
+			return true;
+		}
+
+		uint32_t Read(uint32_t n)
+		{
+			if (!Need(n))
+				return 0;
+			uint32_t result = (uint32_t)(bits & ((1ULL << n) - 1));
+			bits >>= n;
+			count -= n;
+			return result;
+		}
+
+		void AlignToByte()
+		{
+			uint32_t drop = count & 7;
+			bits >>= drop;
+			count -= drop;
+		}
+
+		// Number of bits consumed from the start of the data
+		size_t GetBitPosition() const { return (pos * 8) - count; }
+
+		Checkpoint Save() const { return Checkpoint {pos, bits, count}; }
+
+		void Restore(const Checkpoint& checkpoint)
+		{
+			pos = checkpoint.pos;
+			bits = checkpoint.bits;
+			count = checkpoint.count;
+			overrun = false;
+		}
+	};
+
+	struct HuffmanTable
+	{
+		// Entries are (code length << 9) | symbol, indexed by the next HUFFMAN_FAST_BITS input bits. Zero means the
+		// code is longer than the table and is resolved canonically from counts and symbols.
+		uint16_t fast[1 << HUFFMAN_FAST_BITS];
+		uint16_t counts[HUFFMAN_MAX_BITS + 1];
+		uint16_t symbols[288];
+
+		// Returns the number of unused codes (zero for a complete code), or -1 if the lengths are over-subscribed
+		int Build(const uint8_t* lengths, size_t n)
+		{
+			memset(fast, 0, sizeof(fast));
+			memset(counts, 0, sizeof(counts));
+			for (size_t i = 0; i < n; i++)
+				counts[lengths[i]]++;
+
+			int left = 1;
+			for (size_t len = 1; len <= HUFFMAN_MAX_BITS; len++)
+			{
+				left <<= 1;
+				left -= counts[len];
+				if (left < 0)
+					return -1;
+			}
+
+			uint16_t offsets[HUFFMAN_MAX_BITS + 1];
+			offsets[1] = 0;
+			for (size_t len = 1; len < HUFFMAN_MAX_BITS; len++)
+				offsets[len + 1] = offsets[len] + counts[len];
+			for (size_t i = 0; i < n; i++)
+			{
+				if (lengths[i] != 0)
+					symbols[offsets[lengths[i]]++] = (uint16_t)i;
+			}
+
+			// Codes are assigned in canonical order but are stored most significant bit first in the stream, so
+			// the fast table is indexed by the bit-reversed code
+			uint32_t code = 0;
+			size_t index = 0;
+			for (uint32_t len = 1; len <= HUFFMAN_FAST_BITS; len++)
+			{
+				for (size_t i = 0; i < counts[len]; i++, code++)
+				{
+					uint32_t reversed = 0;
+					for (uint32_t bit = 0; bit < len; bit++)
+						reversed |= ((code >> bit) & 1) << (len - 1 - bit);
+					for (uint32_t fill = reversed; fill < (1 << HUFFMAN_FAST_BITS); fill += (1 << len))
+						fast[fill] = (uint16_t)((len << 9) | symbols[index + i]);
+				}
+				index += counts[len];
+				code <<= 1;
+			}
+			return left;
+		}
+
+		// Returns the decoded symbol, -1 if more input is needed or -2 for a code not in the table
+		int Decode(BitReader& reader) const
+		{
+			if (reader.count < HUFFMAN_MAX_BITS)
+				reader.Refill();
+
+			uint16_t entry = fast[reader.bits & ((1 << HUFFMAN_FAST_BITS) - 1)];
+			if (entry != 0)
+			{
+				uint32_t len = entry >> 9;
+				if (len > reader.count)
+				{
+					reader.overrun = true;
+					return -1;
+				}
+				reader.bits >>= len;
+				reader.count -= len;
+				return entry & 0x1ff;
+			}
+
+			int code = 0, first = 0, index = 0;
+			for (uint32_t len = 1; len <= HUFFMAN_MAX_BITS; len++)
+			{
+				if (len > reader.count)
+				{
+					reader.overrun = true;
+					return -1;
+				}
+				code |= (int)((reader.bits >> (len - 1)) & 1);
+				int count = counts[len];
+				if ((code - count) < first)
+				{
+					reader.bits >>= len;
+					reader.count -= len;
+					return symbols[index + (code - first)];
+				}
+				index += count;
+				first += count;
+				first <<= 1;
+				code <<= 1;
+			}
+			return -2;
+		}
+	};
+
+	struct FixedHuffmanTables
+	{
+		HuffmanTable lengths, distances;
+
+		FixedHuffmanTables()
+		{
+			uint8_t lens[288];
+			size_t i = 0;
+			for (; i < 144; i++)
+				lens[i] = 8;
+			for (; i < 256; i++)
+				lens[i] = 9;
+			for (; i < 280; i++)
+				lens[i] = 7;
+			for (; i < 288; i++)
+				lens[i] = 8;
+			lengths.Build(lens, 288);
+			for (i = 0; i < 30; i++)
+				lens[i] = 5;
+			distances.Build(lens, 30);
+		}
+	};
+}
+
+
+static const FixedHuffmanTables& GetFixedHuffmanTables()
+{
+	static FixedHuffmanTables tables;
+	return tables;
+}
+
+
+// Incomplete codes are only permitted when no code is longer than one bit (a single used distance code, or none)
+static bool IsValidHuffmanTable(const HuffmanTable& table, int left, size_t n)
+{
+	if (left < 0)
+		return false;
+	if (left == 0)
+		return true;
+	return n == (size_t)(table.counts[0] + table.counts[1]);
+}
+
+
+static DeflateResult ReadDynamicHuffmanTables(BitReader& reader, HuffmanTable& lengthTable,
+	HuffmanTable& distanceTable)
+{
+	if (!reader.Need(14))
+		return DeflateNeedInput;
+	size_t lengthCount = reader.Read(5) + 257;
+	size_t distanceCount = reader.Read(5) + 1;
+	size_t codeLengthCount = reader.Read(4) + 4;
+	if ((lengthCount > 286) || (distanceCount > 30))
+		return DeflateInvalid;
+
+	uint8_t lengths[286 + 30];
+	memset(lengths, 0, 19);
+	for (size_t i = 0; i < codeLengthCount; i++)
+	{
+		lengths[g_codeLengthOrder[i]] = (uint8_t)reader.Read(3);
+		if (reader.overrun)
+			return DeflateNeedInput;
+	}
+
+	HuffmanTable codeLengthTable;
+	if (codeLengthTable.Build(lengths, 19) != 0)
+		return DeflateInvalid;
+
+	size_t index = 0;
+	while (index < (lengthCount + distanceCount))
+	{
+		int symbol = codeLengthTable.Decode(reader);
+		if (symbol == -1)
+			return DeflateNeedInput;
+		if (symbol < 0)
+			return DeflateInvalid;
+		if (symbol < 16)
+		{
+			lengths[index++] = (uint8_t)symbol;
+			continue;
+		}
+
+		uint8_t value = 0;
+		size_t repeat;
+		if (symbol == 16)
+		{
+			if (index == 0)
+				return DeflateInvalid;
+			value = lengths[index - 1];
+			repeat = 3 + reader.Read(2);
+		}
+		else if (symbol == 17)
+		{
+			repeat = 3 + reader.Read(3);
+		}
+		else
+		{
+			repeat = 11 + reader.Read(7);
+		}
+		if (reader.overrun)
+			return DeflateNeedInput;
+		if ((index + repeat) > (lengthCount + distanceCount))
+			return DeflateInvalid;
+		while (repeat--)
+			lengths[index++] = value;
+	}
+
+	// The end of block code must be present
+	if (lengths[256] == 0)
+		return DeflateInvalid;
+
+	int left = lengthTable.Build(lengths, lengthCount);
+	if (!IsValidHuffmanTable(lengthTable, left, lengthCount))
+		return DeflateInvalid;
+	left = distanceTable.Build(lengths + lengthCount, distanceCount);
+	if (!IsValidHuffmanTable(distanceTable, left, distanceCount))
+		return DeflateInvalid;
+	return DeflateOk;
+}
+
+
+static uint32_t UpdateAdler32(uint32_t adler, const uint8_t* data, size_t len)
+{
+	uint32_t a = adler & 0xffff;
+	uint32_t b = adler >> 16;
+	while (len > 0)
+	{
+		// 5552 is the largest run that cannot overflow 32 bits before the modulo
+		size_t run = (len < 5552) ? len : 5552;
+		len -= run;
+		while (run--)
+		{
+			a += *data++;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b << 16) | a;
+}
+
+
+// Walks a complete deflate stream, returning the bit position of the final block's BFINAL flag and the bit
+// position just past the end of the final block
+static bool LocateFinalDeflateBlock(const uint8_t* data, size_t len, size_t& finalFlagBit, size_t& endBit)
+{
+	const FixedHuffmanTables& fixed = GetFixedHuffmanTables();
+	HuffmanTable dynamicLengths, dynamicDistances;
+	BitReader reader(data, len);
+
+	while (true)
+	{
+		size_t headerBit = reader.GetBitPosition();
+		uint32_t last = reader.Read(1);
+		uint32_t type = reader.Read(2);
+		if (reader.overrun)
+			return false;
+
+		if (type == 0)
+		{
+			reader.AlignToByte();
+			uint32_t storedLen = reader.Read(16);
+			uint32_t storedLenCheck = reader.Read(16);
+			if (reader.overrun || (storedLen != (~storedLenCheck & 0xffff)))
+				return false;
+			// The bit buffer holds whole bytes after alignment, so skip those first
+			while ((storedLen > 0) && (reader.count >= 8))
+			{
+				reader.Read(8);
+				storedLen--;
+			}
+			if (storedLen > (reader.length - reader.pos))
+				return false;
+			reader.pos += storedLen;
+		}
+		else if (type == 3)
+		{
+			return false;
+		}
+		else
+		{
+			const HuffmanTable* lengthTable = &fixed.lengths;
+			const HuffmanTable* distanceTable = &fixed.distances;
+			if (type == 2)
+			{
+				if (ReadDynamicHuffmanTables(reader, dynamicLengths, dynamicDistances) != DeflateOk)
+					return false;
+				lengthTable = &dynamicLengths;
+				distanceTable = &dynamicDistances;
+			}
+
+			while (true)
+			{
+				int symbol = lengthTable->Decode(reader);
+				if (symbol < 0)
+					return false;
+				if (symbol < 256)
+					continue;
+				if (symbol == 256)
+					break;
+				symbol -= 257;
+				if (symbol >= 29)
+					return false;
+				reader.Read(g_lengthExtra[symbol]);
+				int distSymbol = distanceTable->Decode(reader);
+				if ((distSymbol < 0) || (distSymbol >= 30))
+					return false;
+				reader.Read(g_distExtra[distSymbol]);
+				if (reader.overrun)
+					return false;
+			}
+		}
+
+		if (last)
+		{
+			finalFlagBit = headerBit;
+			endBit = reader.GetBitPosition();
+			return true;
+		}
+	}
+}
+
+
+struct ZlibCompressor::Block
+{
+	vector<uint8_t> input;
+	vector<uint8_t> output;
+	bool valid;
+
+	// Each block is compressed exactly once, either by a worker or by the compressor's own thread when it needs
+	// the result before a worker has picked it up
+	atomic<bool> claimed;
+	bool done;
+	mutex lock;
+	condition_variable cv;
+
+	Block(): valid(false), claimed(false), done(false) {}
+
+	bool Claim()
+	{
+		bool expected = false;
+		return claimed.compare_exchange_strong(expected, true);
+	}
+
+	void Compress()
+	{
+		BNDataBuffer* buffer = BNCreateDataBuffer(input.data(), input.size());
+		BNDataBuffer* compressed = BNZlibCompress(buffer);
+		BNFreeDataBuffer(buffer);
+
+		if (compressed)
+		{
+			const uint8_t* data = (const uint8_t*)BNGetDataBufferContents(compressed);
+			size_t len = BNGetDataBufferLength(compressed);
+
+			// Strip the two byte zlib header and the Adler-32 trailer, then clear the final block flag and pad
+			// the block out with an empty stored block so that the next block starts on a byte boundary
+			size_t finalFlagBit, endBit;
+			if ((len >= 6) && ((data[1] & 0x20) == 0) &&
+				LocateFinalDeflateBlock(data + 2, len - 6, finalFlagBit, endBit))
+			{
+				size_t blockBytes = (endBit + 3 + 7) / 8;
+				output.assign(blockBytes + 4, 0);
+				memcpy(output.data(), data + 2, min(blockBytes, len - 6));
+				output[endBit / 8] &= (uint8_t)((1 << (endBit % 8)) - 1);
+				for (size_t i = (endBit / 8) + 1; i < blockBytes; i++)
+					output[i] = 0;
+				output[finalFlagBit / 8] &= (uint8_t)~(1 << (finalFlagBit % 8));
+				output[blockBytes + 2] = 0xff;
+				output[blockBytes + 3] = 0xff;
+				valid = true;
+			}
+			BNFreeDataBuffer(compressed);
+		}
+
+		vector<uint8_t>().swap(input);
+		unique_lock<mutex> guard(lock);
+		done = true;
+		cv.notify_all();
+	}
+
+	void Wait()
+	{
+		unique_lock<mutex> guard(lock);
+		cv.wait(guard, [this]() { return done; });
+	}
+};
+
+
+constexpr size_t ZlibCompressor::DefaultBlockSize;
+
+
+ZlibCompressor::ZlibCompressor(const ZlibOutputCallback& output, size_t threadCount, size_t blockSize):
+	m_output(output), m_outputOffset(0), m_threadCount(threadCount ? threadCount : 1),
+	m_blockSize(blockSize ? blockSize : DefaultBlockSize), m_adler(1), m_totalIn(0), m_totalOut(0),
+	m_headerWritten(false), m_finished(false), m_failed(false)
+{
+}
+
+
+ZlibCompressor::ZlibCompressor(FileAccessor* output, uint64_t offset, size_t threadCount, size_t blockSize):
+	ZlibCompressor(ZlibOutputCallback(), threadCount, blockSize)
+{
+	m_outputOffset = offset;
+	m_output = [this, output](const void* data, size_t len) {
+		if (output->Write(m_outputOffset, data, len) != len)
+			return false;
+		m_outputOffset += len;
+		return true;
+	};
+}
+
+
+ZlibCompressor::~ZlibCompressor()
+{
+	// Blocks that no worker has started are abandoned, but any in progress must finish before the sink goes away
+	for (auto& block : m_pending)
+	{
+		if (!block->Claim())
+			block->Wait();
+	}
+}
+
+
+bool ZlibCompressor::Emit(const void* data, size_t len)
+{
+	if (!m_headerWritten)
+	{
+		static const uint8_t header[2] = {0x78, 0x9c};
+		m_headerWritten = true;
+		if (!Emit(header, sizeof(header)))
+			return false;
+	}
+
+	if (!m_output(data, len))
+	{
+		m_failed = true;
+		return false;
+	}
+	m_totalOut += len;
+	return true;
+}
+
+
+bool ZlibCompressor::SubmitBlock()
+{
+	shared_ptr<Block> block = make_shared<Block>();
+	block->input.swap(m_current);
+
+	if (m_threadCount > 1)
+	{
+		WorkerEnqueue([block]() {
+				if (block->Claim())
+					block->Compress();
+			});
+	}
+	m_pending.push_back(block);
+
+	while (m_pending.size() >= m_threadCount)
+	{
+		if (!RetireOldestBlock())
+			return false;
+	}
+	return true;
+}
+
+
+bool ZlibCompressor::RetireOldestBlock()
+{
+	shared_ptr<Block> block = m_pending.front();
+	m_pending.erase(m_pending.begin());
+
+	if (block->Claim())
+		block->Compress();
+	else
+		block->Wait();
+
+	if (!block->valid)
+	{
+		m_failed = true;
+		return false;
+	}
+	return Emit(block->output.data(), block->output.size());
+}
+
+
+bool ZlibCompressor::Write(const void* data, size_t len)
+{
+	if (m_failed || m_finished)
+		return false;
+
+	const uint8_t* src = (const uint8_t*)data;
+	m_adler = UpdateAdler32(m_adler, src, len);
+	m_totalIn += len;
+
+	while (len > 0)
+	{
+		if (m_current.capacity() < m_blockSize)
+			m_current.reserve(m_blockSize);
+		size_t chunk = min(len, m_blockSize - m_current.size());
+		m_current.insert(m_current.end(), src, src + chunk);
+		src += chunk;
+		len -= chunk;
+
+		if ((m_current.size() == m_blockSize) && !SubmitBlock())
+			return false;
+	}
+	return true;
+}
+
+
+bool ZlibCompressor::Write(const DataBufferView& data)
+{
+	return Write(data.GetData(), data.GetLength());
+}
+
+
+bool ZlibCompressor::Finish()
+{
+	if (m_failed || m_finished)
+		return false;
+
+	if ((!m_current.empty()) && !SubmitBlock())
+		return false;
+	while (!m_pending.empty())
+	{
+		if (!RetireOldestBlock())
+			return false;
+	}
+
+	// Empty final fixed Huffman block followed by the big endian Adler-32 of the input
+	uint8_t trailer[6] = {0x03, 0x00, (uint8_t)(m_adler >> 24), (uint8_t)(m_adler >> 16), (uint8_t)(m_adler >> 8),
+		(uint8_t)m_adler};
+	if (!Emit(trailer, sizeof(trailer)))
+		return false;
+	m_finished = true;
+	return true;
+}
+
+
+struct ZlibDecompressor::State
+{
+	enum Stage
+	{
+		StreamHeaderStage,
+		BlockHeaderStage,
+		StoredBlockStage,
+		CompressedBlockStage,
+		StreamTrailerStage,
+		CompleteStage
+	};
+
+	bool raw;
+	Stage stage;
+	bool finalBlock;
+	size_t storedRemaining;
+
+	vector<uint8_t> input;
+	BitReader reader;
+
+	HuffmanTable dynamicLengths, dynamicDistances;
+	const HuffmanTable* lengthTable;
+	const HuffmanTable* distanceTable;
+
+	// Decoded output, of which everything before outputFlushed has been passed to the sink. After each flush only
+	// the last ZLIB_WINDOW_SIZE bytes are kept for back references.
+	vector<uint8_t> output;
+	size_t outputLength, outputFlushed;
+
+	uint32_t adler;
+	uint64_t totalIn, totalOut;
+	bool failed;
+	string error;
+
+	State(bool rawDeflate): raw(rawDeflate), stage(rawDeflate ? BlockHeaderStage : StreamHeaderStage),
+		finalBlock(false), storedRemaining(0), lengthTable(nullptr), distanceTable(nullptr),
+		output(ZLIB_WINDOW_SIZE + ZLIB_OUTPUT_CHUNK_SIZE + ZLIB_MAX_MATCH), outputLength(0), outputFlushed(0),
+		adler(1), totalIn(0), totalOut(0), failed(false)
+	{
+	}
+};
+
+
+ZlibDecompressor::ZlibDecompressor(const ZlibOutputCallback& output, bool rawDeflate):
+	m_state(new State(rawDeflate)), m_output(output), m_outputOffset(0)
+{
+}
+
+
+ZlibDecompressor::ZlibDecompressor(FileAccessor* output, uint64_t offset, bool rawDeflate):
+	ZlibDecompressor(ZlibOutputCallback(), rawDeflate)
+{
+	m_outputOffset = offset;
+	m_output = [this, output](const void* data, size_t len) {
+		if (output->Write(m_outputOffset, data, len) != len)
+			return false;
+		m_outputOffset += len;
+		return true;
+	};
+}
+
+
+ZlibDecompressor::~ZlibDecompressor()
+{
+}
+
+
+bool ZlibDecompressor::Fail(const string& error)
+{
+	if (!m_state->failed)
+	{
+		m_state->failed = true;
+		m_state->error = error;
+	}
+	return false;
+}
+
+
+bool ZlibDecompressor::Flush()
+{
+	State& s = *m_state;
+	size_t pending = s.outputLength - s.outputFlushed;
+	if (pending != 0)
+	{
+		const uint8_t* data = &s.output[s.outputFlushed];
+		if (!s.raw)
+			s.adler = UpdateAdler32(s.adler, data, pending);
+		if (!m_output(data, pending))
+			return Fail("output rejected");
+		s.totalOut += pending;
+	}
+
+	if (s.outputLength > ZLIB_WINDOW_SIZE)
+	{
+		memmove(s.output.data(), &s.output[s.outputLength - ZLIB_WINDOW_SIZE], ZLIB_WINDOW_SIZE);
+		s.outputLength = ZLIB_WINDOW_SIZE;
+	}
+	s.outputFlushed = s.outputLength;
+	return true;
+}
+
+
+bool ZlibDecompressor::Process(bool final)
+{
+	State& s = *m_state;
+	BitReader& reader = s.reader;
+	reader.data = s.input.data();
+	reader.length = s.input.size();
+
+	bool needInput = false;
+	while (!needInput && !s.failed && (s.stage != State::CompleteStage))
+	{
+		if ((s.outputLength - s.outputFlushed) >= ZLIB_OUTPUT_CHUNK_SIZE)
+		{
+			if (!Flush())
+				break;
+		}
+
+		BitReader::Checkpoint checkpoint = reader.Save();
+		switch (s.stage)
+		{
+		case State::StreamHeaderStage:
+		{
+			uint32_t cmf = reader.Read(8);
+			uint32_t flags = reader.Read(8);
+			if (reader.overrun)
+				break;
+			if (((cmf & 0xf) != 8) || ((cmf >> 4) > 7) || ((((cmf << 8) | flags) % 31) != 0))
+				return Fail("invalid zlib header");
+			if (flags & 0x20)
+				return Fail("preset dictionaries are not supported");
+			s.stage = State::BlockHeaderStage;
+			break;
+		}
+
+		case State::BlockHeaderStage:
+		{
+			s.finalBlock = reader.Read(1) != 0;
+			uint32_t type = reader.Read(2);
+			if (reader.overrun)
+				break;
+			if (type == 0)
+			{
+				reader.AlignToByte();
+				uint32_t storedLen = reader.Read(16);
+				uint32_t storedLenCheck = reader.Read(16);
+				if (reader.overrun)
+					break;
+				if (storedLen != (~storedLenCheck & 0xffff))
+					return Fail("invalid stored block length");
+				s.storedRemaining = storedLen;
+				s.stage = State::StoredBlockStage;
+			}
+			else if (type == 1)
+			{
+				s.lengthTable = &GetFixedHuffmanTables().lengths;
+				s.distanceTable = &GetFixedHuffmanTables().distances;
+				s.stage = State::CompressedBlockStage;
+			}
+			else if (type == 2)
+			{
+				DeflateResult result = ReadDynamicHuffmanTables(reader, s.dynamicLengths, s.dynamicDistances);
+				if (result == DeflateInvalid)
+					return Fail("invalid dynamic Huffman tables");
+				if (result == DeflateNeedInput)
+				{
+					reader.overrun = true;
+					break;
+				}
+				s.lengthTable = &s.dynamicLengths;
+				s.distanceTable = &s.dynamicDistances;
+				s.stage = State::CompressedBlockStage;
+			}
+			else
+			{
+				return Fail("invalid block type");
+			}
+			break;
+		}
+
+		case State::StoredBlockStage:
+		{
+			size_t outLimit = s.outputFlushed + ZLIB_OUTPUT_CHUNK_SIZE;
+			while ((s.storedRemaining > 0) && (reader.count >= 8) && (s.outputLength < outLimit))
+			{
+				s.output[s.outputLength++] = (uint8_t)reader.Read(8);
+				s.storedRemaining--;
+			}
+			if (reader.count == 0)
+			{
+				size_t chunk = min(s.storedRemaining, reader.length - reader.pos);
+				chunk = min(chunk, outLimit - s.outputLength);
+				memcpy(&s.output[s.outputLength], &reader.data[reader.pos], chunk);
+				s.outputLength += chunk;
+				reader.pos += chunk;
+				s.storedRemaining -= chunk;
+			}
+			if (s.storedRemaining == 0)
+				s.stage = s.finalBlock ? State::StreamTrailerStage : State::BlockHeaderStage;
+			else if ((reader.pos == reader.length) && (reader.count == 0))
+				needInput = true;
+			break;
+		}
+
+		case State::CompressedBlockStage:
+		{
+			const HuffmanTable& lengthTable = *s.lengthTable;
+			const HuffmanTable& distanceTable = *s.distanceTable;
+			uint8_t* out = s.output.data();
+			size_t outLimit = s.outputFlushed + ZLIB_OUTPUT_CHUNK_SIZE;
+
+			while (s.outputLength < outLimit)
+			{
+				checkpoint = reader.Save();
+				int symbol = lengthTable.Decode(reader);
+				if (symbol < 256)
+				{
+					if (symbol < 0)
+					{
+						if (symbol == -1)
+							break;
+						return Fail("invalid literal/length code");
+					}
+					out[s.outputLength++] = (uint8_t)symbol;
+					continue;
+				}
+				if (symbol == 256)
+				{
+					s.stage = s.finalBlock ? State::StreamTrailerStage : State::BlockHeaderStage;
+					break;
+				}
+
+				symbol -= 257;
+				if (symbol >= 29)
+					return Fail("invalid literal/length code");
+				size_t length = g_lengthBase[symbol] + reader.Read(g_lengthExtra[symbol]);
+				int distSymbol = distanceTable.Decode(reader);
+				if (distSymbol == -1)
+					break;
+				if ((distSymbol < 0) || (distSymbol >= 30))
+					return Fail("invalid distance code");
+				size_t distance = g_distBase[distSymbol] + reader.Read(g_distExtra[distSymbol]);
+				if (reader.overrun)
+					break;
+				if (distance > s.outputLength)
+					return Fail("distance too far back");
+
+				uint8_t* dest = &out[s.outputLength];
+				const uint8_t* src = dest - distance;
+				if (distance >= length)
+				{
+					memcpy(dest, src, length);
+				}
+				else
+				{
+					for (size_t i = 0; i < length; i++)
+						dest[i] = src[i];
+				}
+				s.outputLength += length;
+			}
+			break;
+		}
+
+		case State::StreamTrailerStage:
+		{
+			if (s.raw)
+			{
+				s.stage = State::CompleteStage;
+				break;
+			}
+			reader.AlignToByte();
+			uint32_t expected = reader.Read(8) << 24;
+			expected |= reader.Read(8) << 16;
+			expected |= reader.Read(8) << 8;
+			expected |= reader.Read(8);
+			if (reader.overrun)
+				break;
+			if (!Flush())
+				return false;
+			if (expected != s.adler)
+				return Fail("incorrect data check");
+			s.stage = State::CompleteStage;
+			break;
+		}
+
+		default:
+			break;
+		}
+
+		if (reader.overrun)
+		{
+			reader.Restore(checkpoint);
+			needInput = true;
+		}
+	}
+
+	// Drop consumed input; any bits already moved into the bit buffer stay there
+	s.input.erase(s.input.begin(), s.input.begin() + reader.pos);
+	reader.pos = 0;
+	reader.data = s.input.data();
+	reader.length = s.input.size();
+
+	if (s.failed)
+		return false;
+	if (final && (s.stage != State::CompleteStage))
+		return Fail("unexpected end of stream");
+	return true;
+}
+
+
+bool ZlibDecompressor::Write(const void* data, size_t len)
+{
+	if (m_state->failed)
+		return false;
+	if (m_state->stage == State::CompleteStage)
+		return true;
+
+	// Feed large writes through in bounded pieces so the internal copy of the input stays small
+	const uint8_t* src = (const uint8_t*)data;
+	while (len > 0)
+	{
+		size_t chunk = min(len, (size_t)ZLIB_OUTPUT_CHUNK_SIZE);
+		m_state->input.insert(m_state->input.end(), src, src + chunk);
+		m_state->totalIn += chunk;
+		src += chunk;
+		len -= chunk;
+		if (!Process(false))
+			return false;
+		if (m_state->stage == State::CompleteStage)
+			break;
+	}
+	return true;
+}
+
+
+bool ZlibDecompressor::Write(const DataBufferView& data)
+{
+	return Write(data.GetData(), data.GetLength());
+}
+
+
+bool ZlibDecompressor::Finish()
+{
+	if (m_state->failed)
+		return false;
+	if (!Process(true))
+		return false;
+	return Flush();
+}
+
+
+bool ZlibDecompressor::IsComplete() const
+{
+	return m_state->stage == State::CompleteStage;
+}
+
+
+bool ZlibDecompressor::HasFailed() const
+{
+	return m_state->failed;
+}
+
+
+string ZlibDecompressor::GetError() const
+{
+	return m_state->error;
+}
+
+
+uint64_t ZlibDecompressor::GetTotalIn() const
+{
+	return m_state->totalIn;
+}
+
+
+uint64_t ZlibDecompressor::GetTotalOut() const
+{
+	return m_state->totalOut;
+}